@@ -0,0 +1,114 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _CEX_ALIGNEDALLOCATOR_H
+#define _CEX_ALIGNEDALLOCATOR_H
+
+#include "CexDomain.h"
+#include <new>
+#if defined(CEX_OS_WINDOWS)
+#	include <malloc.h>
+#else
+#	include <stdlib.h>
+#endif
+
+NAMESPACE_UTILITY
+
+/// <summary>
+/// A standard library allocator that returns memory aligned to a fixed boundary.
+/// <para>The default allocator only guarantees the alignment of the fundamental types before C++17;
+/// containers of cache line aligned state structures use this allocator so that every element starts on its own cache line.</para>
+/// </summary>
+///
+/// <typeparam name="T">The element type</typeparam>
+/// <typeparam name="Alignment">The alignment boundary in bytes; a power of two, and a multiple of the pointer size</typeparam>
+template <typename T, size_t Alignment>
+class AlignedAllocator
+{
+public:
+
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator()
+	{
+	}
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment> &)
+	{
+	}
+
+	/// <summary>
+	/// Allocate aligned memory for a number of elements
+	/// </summary>
+	///
+	/// <param name="Count">The number of elements</param>
+	///
+	/// <returns>A pointer to the uninitialized memory</returns>
+	T* allocate(size_t Count)
+	{
+		void* ptr = 0;
+
+#if defined(CEX_OS_WINDOWS)
+		ptr = _aligned_malloc(Count * sizeof(T), Alignment);
+#else
+		if (posix_memalign(&ptr, Alignment, Count * sizeof(T)) != 0)
+			ptr = 0;
+#endif
+
+		if (ptr == 0)
+			throw std::bad_alloc();
+
+		return static_cast<T*>(ptr);
+	}
+
+	/// <summary>
+	/// Release memory returned by allocate
+	/// </summary>
+	///
+	/// <param name="Ptr">The pointer returned by allocate</param>
+	void deallocate(T* Ptr, size_t)
+	{
+#if defined(CEX_OS_WINDOWS)
+		_aligned_free(Ptr);
+#else
+		free(Ptr);
+#endif
+	}
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &)
+{
+	return true;
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &)
+{
+	return false;
+}
+
+NAMESPACE_UTILITYEND
+#endif
@@ -339,6 +339,19 @@ public:
 			++Output[1];
 	}
 
+	/// <summary>
+	/// Treats a 2x 32bit integer array in place as a large Little Endian integer, incrementing the total value by a defined length
+	/// </summary>
+	/// 
+	/// <param name="Counter">Pointer to the two counter words</param>
+	/// <param name="Length">The number to increase by</param>
+	static inline void IncreaseLE32(uint* Counter, const size_t Length)
+	{
+		Counter[0] += static_cast<uint>(Length);
+		if (Counter[0] < static_cast<uint>(Length))
+			++Counter[1];
+	}
+
 	/// <summary>
 	/// Treats a 2x 64bit integer array as a large Little Endian integer, incrementing the total value by a defined length
 	/// </summary>
@@ -354,6 +367,19 @@ public:
 			++Output[1];
 	}
 
+	/// <summary>
+	/// Treats a 2x 64bit integer array in place as a large Little Endian integer, incrementing the total value by a defined length
+	/// </summary>
+	/// 
+	/// <param name="Counter">Pointer to the two counter words</param>
+	/// <param name="Length">The number to increase by</param>
+	static inline void IncreaseLE64(ulong* Counter, const size_t Length)
+	{
+		Counter[0] += Length;
+		if (Counter[0] < Length)
+			++Counter[1];
+	}
+
 	/// <summary>
 	/// Shuffle array values to randomly chosen positions
 	/// </summary>
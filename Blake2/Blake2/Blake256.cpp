@@ -1,5 +1,4 @@
 #include "Blake256.h"
-#include "Blake256Compress.h"
 #include "ArrayUtils.h"
 #include "CpuDetect.h"
 #include "IntUtils.h"
@@ -16,49 +15,75 @@ static const std::vector<uint> SCIV = { 0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL
 
 Blake256::Blake256(bool Parallel)
 	:
-	m_cIV(SCIV),
-	m_dgtState(Parallel ? 8 : 1),
+	Blake256(DIGEST_SIZE, Parallel)
+{
+}
+
+Blake256::Blake256(size_t DigestSize, bool Parallel)
+	:
+	m_dgtState(1),
+	m_digestSize(DigestSize),
 	m_isDestroyed(false),
+	m_isKeyedChain(false),
+	m_isParallelSimd(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyedCode(),
+	m_laneInput(0),
+	m_laneState(0),
+	m_leafHashes(0),
 	m_leafSize(Parallel ? DEF_LEAFSIZE : BLOCK_SIZE),
-	m_msgBuffer(Parallel ? 2 * DEF_PRLDEGREE * BLOCK_SIZE : BLOCK_SIZE),
+	m_msgBuffer(BLOCK_SIZE),
 	m_msgLength(0),
 	m_parallelProfile(BLOCK_SIZE, false, STATE_PRECACHED, false, DEF_PRLDEGREE),
-	m_treeConfig(CHAIN_SIZE),
+	m_treeConfig(),
 	m_treeDestroy(true)
 {
-	if (m_parallelProfile.IsParallel())
-		m_parallelProfile.IsParallel() = Parallel;
+	if (DigestSize == 0 || DigestSize > DIGEST_SIZE)
+		throw CryptoDigestException("Blake256:Ctor", "The DigestSize is invalid! Must be between 1 and 32 bytes.");
+
+	// the tree mode selects the digest, and does not depend on the processor count; a single processor hashes the leaves in turn
+	m_parallelProfile.IsParallel() = Parallel;
 
 	if (m_parallelProfile.IsParallel())
 	{
 		// sets defaults of depth 2, fanout 8, 8 threads
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE), 2, DEF_PRLDEGREE, 0, static_cast<byte>(DIGEST_SIZE));
-		// initialize the leaf nodes 
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize), 2, DEF_PRLDEGREE, 0, static_cast<byte>(DIGEST_SIZE));
+		// size the tree state to the fanout, and initialize the leaf nodes
+		LoadTree();
 		Reset();
 	}
 	else
 	{
 		// default depth 1, fanout 1, leaf length unlimited
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE));
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize));
 		LoadState(m_dgtState[0]);
 	}
 }
 
 Blake256::Blake256(BlakeParams &Params)
 	:
-	m_cIV(SCIV),
-	m_dgtState(Params.FanOut() > 0 ? Params.FanOut() : 1),
+	m_dgtState(1),
+	m_digestSize(Params.OutputSize()),
 	m_isDestroyed(false),
+	m_isKeyedChain(false),
+	m_isParallelSimd(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyedCode(),
+	m_laneInput(0),
+	m_laneState(0),
+	m_leafHashes(0),
 	m_leafSize(BLOCK_SIZE),
-	m_msgBuffer(Params.FanOut() > 0 ? 2 * Params.FanOut() * BLOCK_SIZE : BLOCK_SIZE),
+	m_msgBuffer(BLOCK_SIZE),
 	m_msgLength(0),
 	m_parallelProfile(BLOCK_SIZE, false, STATE_PRECACHED, false, Params.FanOut()),
-	m_treeConfig(CHAIN_SIZE),
+	m_treeConfig(),
 	m_treeDestroy(false),
 	m_treeParams(Params)
 {
-	if (m_parallelProfile.IsParallel())
-		m_parallelProfile.IsParallel() = m_treeParams.FanOut() > 1;
+	if (m_digestSize == 0 || m_digestSize > DIGEST_SIZE)
+		throw CryptoDigestException("Blake256:Ctor", "The OutputSize parameter is invalid! Must be between 1 and 32 bytes.");
+
+	m_parallelProfile.IsParallel() = m_treeParams.FanOut() > 1;
 
 	if (m_parallelProfile.IsParallel())
 	{
@@ -68,12 +93,14 @@ Blake256::Blake256(BlakeParams &Params)
 			throw CryptoDigestException("BlakeSP256:Ctor", "The FanOut parameter is invalid! Must be an even number greater than 1.");
 
 		m_leafSize = (Params.LeafLength() == 0) ? DEF_LEAFSIZE : Params.LeafLength();
+		// size the tree state to the fanout
+		LoadTree();
 		Reset();
 	}
 	else
 	{
 		// fixed at defaults for sequential; depth 1, fanout 1, leaf length unlimited
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE), 0, 1, 1, 0, 0, 0, 0, Params.DistributionCode());
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize), 0, 1, 1, 0, 0, 0, 0, Params.DistributionCode());
 		LoadState(m_dgtState[0]);
 	}
 }
@@ -85,6 +112,14 @@ Blake256::~Blake256()
 
 //~~~Public Functions~~~//
 
+Blake256* Blake256::Clone()
+{
+	Blake256* dgt = new Blake256(m_digestSize, m_parallelProfile.IsParallel());
+	dgt->Import(*this);
+
+	return dgt;
+}
+
 void Blake256::Compute(const std::vector<byte> &Input, std::vector<byte> &Output)
 {
 	Update(Input, 0, Input.size());
@@ -92,15 +127,228 @@ void Blake256::Compute(const std::vector<byte> &Input, std::vector<byte> &Output
 	Reset();
 }
 
+void Blake256::ComputeBatch(const std::vector<std::vector<byte>> &Input, std::vector<std::vector<byte>> &Output)
+{
+	if (m_parallelProfile.IsParallel())
+		throw CryptoDigestException("Blake256:ComputeBatch", "Batch hashing is not available in parallel mode!");
+
+	const size_t MSGCNT = Input.size();
+	// buffered bytes (the key block when keyed) are prepended to every message
+	const size_t PFXLEN = m_msgLength;
+	const ulong STRCTR = (static_cast<ulong>(m_dgtState[0].T[1]) << 32) | m_dgtState[0].T[0];
+	const size_t LNECNT = m_kernels->Lanes64W;
+	std::vector<size_t> lneBlk(LNECNT, 0);
+	std::vector<byte> lneBuf(LNECNT * BLOCK_SIZE, 0);
+	std::vector<size_t> lneCnt(LNECNT, 0);
+	std::vector<size_t> lneMsg(LNECNT, MSGCNT);
+	std::vector<const byte*> lnePtr(LNECNT);
+	Blake2sWideState wState(LNECNT);
+	size_t actCnt = 0;
+	size_t nxtMsg = 0;
+
+	// an empty message under a keyed template is not compressed; its code was finalized with the key block
+	const std::function<void()> SKIPEMPTY = [&]()
+	{
+		while (m_isKeyedChain && nxtMsg < MSGCNT && Input[nxtMsg].size() == 0)
+		{
+			Output[nxtMsg].assign(m_keyedCode.begin(), m_keyedCode.begin() + m_digestSize);
+			++nxtMsg;
+		}
+	};
+
+	Output.resize(MSGCNT);
+
+	for (size_t i = 0; i < LNECNT; ++i)
+	{
+		lnePtr[i] = &lneBuf[i * BLOCK_SIZE];
+		SKIPEMPTY();
+
+		if (nxtMsg < MSGCNT)
+		{
+			LoadLane(wState, i, Input[nxtMsg].size() + PFXLEN, lneCnt[i]);
+			lneMsg[i] = nxtMsg;
+			lneBlk[i] = 0;
+			++nxtMsg;
+			++actCnt;
+		}
+	}
+
+	while (actCnt != 0)
+	{
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			// idle lanes compress their zero block and are masked from the output
+			if (lneMsg[i] == MSGCNT)
+				continue;
+
+			const std::vector<byte> &msg = Input[lneMsg[i]];
+			const size_t MSGLEN = msg.size() + PFXLEN;
+			const size_t BLKPOS = lneBlk[i] * BLOCK_SIZE;
+			const size_t BLKEND = (BLKPOS + BLOCK_SIZE < MSGLEN) ? BLKPOS + BLOCK_SIZE : MSGLEN;
+
+			if (BLKPOS >= PFXLEN && BLKPOS + BLOCK_SIZE <= MSGLEN)
+			{
+				// full block within the message; read it in place
+				lnePtr[i] = &msg[BLKPOS - PFXLEN];
+			}
+			else
+			{
+				// block overlaps the prefix or the message tail; stage a padded copy
+				const size_t MSGPOS = (BLKPOS > PFXLEN) ? BLKPOS : PFXLEN;
+				byte* blk = &lneBuf[i * BLOCK_SIZE];
+
+				memset(blk, 0, BLOCK_SIZE);
+				if (BLKPOS < PFXLEN)
+					memcpy(blk, &m_msgBuffer[BLKPOS], PFXLEN - BLKPOS);
+				if (BLKEND > MSGPOS)
+					memcpy(blk + (MSGPOS - BLKPOS), &msg[MSGPOS - PFXLEN], BLKEND - MSGPOS);
+
+				lnePtr[i] = blk;
+			}
+
+			// set the 64 bit lane counter and the final block flag
+			const ulong CTR = STRCTR + BLKEND;
+			wState.T[i] = static_cast<uint>(CTR);
+			wState.T[LNECNT + i] = static_cast<uint>(CTR >> 32);
+			wState.F[i] = (lneBlk[i] == lneCnt[i] - 1) ? UL_MAX : 0;
+		}
+
+		m_kernels->Compress64W(lnePtr, wState, SCIV);
+
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			if (lneMsg[i] == MSGCNT)
+				continue;
+
+			++lneBlk[i];
+
+			if (lneBlk[i] == lneCnt[i])
+			{
+				// lane is finished; output the hash and load the next message
+				std::vector<byte> &otp = Output[lneMsg[i]];
+				otp.resize(m_digestSize);
+
+				// only the bytes of the output size are written
+				for (size_t j = 0; j < m_digestSize; ++j)
+					otp[j] = static_cast<byte>(wState.H[((j / sizeof(uint)) * LNECNT) + i] >> ((j % sizeof(uint)) * 8));
+
+				lneMsg[i] = MSGCNT;
+				lnePtr[i] = &lneBuf[i * BLOCK_SIZE];
+				--actCnt;
+				SKIPEMPTY();
+
+				if (nxtMsg < MSGCNT)
+				{
+					LoadLane(wState, i, Input[nxtMsg].size() + PFXLEN, lneCnt[i]);
+					lneMsg[i] = nxtMsg;
+					lneBlk[i] = 0;
+					++nxtMsg;
+					++actCnt;
+				}
+			}
+		}
+	}
+
+	Reset();
+}
+
+void Blake256::DeSerialize(const std::vector<byte> &State)
+{
+	if (State.size() < SERIAL_HEADER)
+		throw CryptoDigestException("Blake256:DeSerialize", "The state is too short!");
+	if (State[0] != SERIAL_VERSION)
+		throw CryptoDigestException("Blake256:DeSerialize", "The state format version is not supported!");
+	if (State[1] != static_cast<byte>(Enumeral()))
+		throw CryptoDigestException("Blake256:DeSerialize", "The state is not a Blake256 state!");
+
+	const bool PRLMODE = (State[2] & 1) != 0;
+	const bool PRLSIMD = (State[2] & 2) != 0;
+	const bool KEYCHAIN = (State[2] & 4) != 0;
+	const size_t STECNT = State[3];
+	const uint LEAFLEN = IntUtils::BytesToLe32(State, 4);
+	const size_t MSGLEN = IntUtils::BytesToLe32(State, 8);
+	size_t stateOff = SERIAL_HEADER;
+
+	// tree parameters; 12 bytes, then the distribution code length and code
+	if (State.size() < stateOff + 13 || State.size() < stateOff + 13 + State[stateOff + 12])
+		throw CryptoDigestException("Blake256:DeSerialize", "The state is too short!");
+
+	std::vector<byte> dstCode(State.begin() + stateOff + 13, State.begin() + stateOff + 13 + State[stateOff + 12]);
+	BlakeParams params(State[stateOff], State[stateOff + 1], State[stateOff + 2], State[stateOff + 3], IntUtils::BytesToLe32(State, stateOff + 4),
+		State[stateOff + 8], State[stateOff + 9], State[stateOff + 10], dstCode);
+	params.Reserved() = State[stateOff + 11];
+	stateOff += 13 + dstCode.size();
+
+	const size_t BUFLEN = PRLMODE ? 2 * params.FanOut() * BLOCK_SIZE : BLOCK_SIZE;
+	const size_t STELEN = (CHAIN_SIZE + COUNTER_SIZE + FLAG_SIZE) * sizeof(uint);
+
+	if (params.OutputSize() == 0 || params.OutputSize() > DIGEST_SIZE || STECNT != (PRLMODE ? params.FanOut() : 1) || STECNT == 0 || MSGLEN > BUFLEN)
+		throw CryptoDigestException("Blake256:DeSerialize", "The state is malformed!");
+	if (PRLMODE && (params.FanOut() < 2 || params.FanOut() % 2 != 0 || LEAFLEN < BLOCK_SIZE || LEAFLEN % BLOCK_SIZE != 0))
+		throw CryptoDigestException("Blake256:DeSerialize", "The state is malformed!");
+	if (State.size() != stateOff + (CHAIN_SIZE * sizeof(uint)) + (STECNT * STELEN) + MSGLEN + (KEYCHAIN ? DIGEST_SIZE : 0))
+		throw CryptoDigestException("Blake256:DeSerialize", "The state length is invalid!");
+
+	m_digestSize = params.OutputSize();
+	m_treeParams = params;
+	m_parallelProfile.IsParallel() = PRLMODE;
+	m_isParallelSimd = PRLSIMD;
+	m_leafSize = LEAFLEN;
+
+	if (PRLMODE)
+	{
+		LoadTree();
+	}
+	else
+	{
+		m_msgBuffer.resize(BLOCK_SIZE);
+		if (m_dgtState.size() == 0)
+			m_dgtState.resize(1);
+	}
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+	{
+		m_treeConfig[i] = IntUtils::BytesToLe32(State, stateOff);
+		stateOff += sizeof(uint);
+	}
+
+	for (size_t i = 0; i < STECNT; ++i)
+	{
+		Blake2sState &dgtState = m_dgtState[i];
+
+		for (size_t j = 0; j < CHAIN_SIZE; ++j, stateOff += sizeof(uint))
+			dgtState.H[j] = IntUtils::BytesToLe32(State, stateOff);
+		for (size_t j = 0; j < COUNTER_SIZE; ++j, stateOff += sizeof(uint))
+			dgtState.T[j] = IntUtils::BytesToLe32(State, stateOff);
+		for (size_t j = 0; j < FLAG_SIZE; ++j, stateOff += sizeof(uint))
+			dgtState.F[j] = IntUtils::BytesToLe32(State, stateOff);
+	}
+
+	memset(&m_msgBuffer[0], 0, m_msgBuffer.size());
+	if (MSGLEN != 0)
+		memcpy(&m_msgBuffer[0], &State[stateOff], MSGLEN);
+	m_msgLength = MSGLEN;
+	stateOff += MSGLEN;
+
+	m_isKeyedChain = KEYCHAIN;
+	m_keyedCode.fill(0);
+	if (KEYCHAIN)
+		memcpy(&m_keyedCode[0], &State[stateOff], DIGEST_SIZE);
+
+	m_isDestroyed = false;
+}
+
 void Blake256::Destroy()
 {
 	if (!m_isDestroyed)
 	{
 		m_isDestroyed = true;
 
-		ArrayUtils::ClearVector(m_cIV);
+		ArrayUtils::ClearVector(m_leafHashes);
 		ArrayUtils::ClearVector(m_msgBuffer);
-		ArrayUtils::ClearVector(m_treeConfig);
+		m_keyedCode.fill(0);
+		m_treeConfig.fill(0);
+		m_isKeyedChain = false;
 		m_leafSize = 0;
 		m_msgLength = 0;
 
@@ -119,12 +367,10 @@ void Blake256::Destroy()
 	}
 }
 
-size_t Blake256::Finalize(std::vector<byte> &Output, const size_t OutOffset)
+size_t Blake256::Finalize(byte* Output)
 {
 	if (m_parallelProfile.IsParallel())
 	{
-		std::vector<byte> hashCodes(m_treeParams.FanOut() * DIGEST_SIZE);
-
 		// padding
 		if (m_msgLength < m_msgBuffer.size())
 			memset(&m_msgBuffer[m_msgLength], 0, m_msgBuffer.size() - m_msgLength);
@@ -141,7 +387,7 @@ size_t Blake256::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 			for (size_t i = 0; i < blkCount; ++i)
 			{
 				// process partial block set
-				Compress(m_msgBuffer, (i * BLOCK_SIZE), m_dgtState[i], BLOCK_SIZE);
+				Compress(&m_msgBuffer[(i * BLOCK_SIZE)], m_dgtState[i], BLOCK_SIZE);
 				memcpy(&m_msgBuffer[i * BLOCK_SIZE], &m_msgBuffer[m_parallelProfile.ParallelMinimumSize() + (i * BLOCK_SIZE)], BLOCK_SIZE);
 				m_msgLength -= BLOCK_SIZE;
 			}
@@ -177,10 +423,10 @@ size_t Blake256::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 				memset(&m_msgBuffer[(i * BLOCK_SIZE) + blkLen], 0, BLOCK_SIZE - blkLen);
 			}
 
-			Compress(m_msgBuffer, i * BLOCK_SIZE, m_dgtState[i], blkLen);
+			Compress(&m_msgBuffer[i * BLOCK_SIZE], m_dgtState[i], blkLen);
 			m_msgLength -= BLOCK_SIZE;
 
-			IntUtils::LeUL256ToBlock(m_dgtState[i].H, hashCodes, i * DIGEST_SIZE);
+			IntUtils::LeUL256ToBlock(m_dgtState[i].H, &m_leafHashes[i * DIGEST_SIZE]);
 		}
 
 		// set up the root node
@@ -192,19 +438,24 @@ size_t Blake256::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 
 		// load blocks
 		for (size_t i = 0; i < m_treeParams.FanOut(); ++i)
-			Update(hashCodes, i * DIGEST_SIZE, DIGEST_SIZE);
+			Update(m_leafHashes, i * DIGEST_SIZE, DIGEST_SIZE);
 
 		// compress all but last block
-		for (size_t i = 0; i < hashCodes.size() - BLOCK_SIZE; i += BLOCK_SIZE)
-			Compress(m_msgBuffer, i, m_dgtState[0], BLOCK_SIZE);
+		for (size_t i = 0; i < m_leafHashes.size() - BLOCK_SIZE; i += BLOCK_SIZE)
+			Compress(&m_msgBuffer[i], m_dgtState[0], BLOCK_SIZE);
 
 		// apply f0 and f1 flags
 		m_dgtState[0].F[0] = UL_MAX;
 		m_dgtState[0].F[1] = UL_MAX;
 		// last compression
-		Compress(m_msgBuffer, m_msgLength - BLOCK_SIZE, m_dgtState[0], BLOCK_SIZE);
+		Compress(&m_msgBuffer[m_msgLength - BLOCK_SIZE], m_dgtState[0], BLOCK_SIZE);
 		// output the code
-		IntUtils::LeUL256ToBlock(m_dgtState[0].H, Output, OutOffset);
+		IntUtils::LeUL256ToBlock(m_dgtState[0].H, Output, m_digestSize);
+	}
+	else if (m_isKeyedChain && m_msgLength == 0)
+	{
+		// an empty message under a keyed template; the key block was its only block
+		memcpy(Output, &m_keyedCode[0], m_digestSize);
 	}
 	else
 	{
@@ -213,13 +464,65 @@ size_t Blake256::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 			memset(&m_msgBuffer[m_msgLength], 0, padLen);
 
 		m_dgtState[0].F[0] = UL_MAX;
-		Compress(m_msgBuffer, 0, m_dgtState[0], m_msgLength);
-		IntUtils::LeUL256ToBlock(m_dgtState[0].H, Output, OutOffset);
+		Compress(&m_msgBuffer[0], m_dgtState[0], m_msgLength);
+		IntUtils::LeUL256ToBlock(m_dgtState[0].H, Output, m_digestSize);
 	}
 
 	Reset();
 
-	return DIGEST_SIZE;
+	return m_digestSize;
+}
+
+size_t Blake256::Finalize(std::vector<byte> &Output, const size_t OutOffset)
+{
+	if (Output.size() < OutOffset + m_digestSize)
+		throw CryptoDigestException("Blake256:Finalize", "The Output buffer is too short!");
+
+	return Finalize(&Output[OutOffset]);
+}
+
+void Blake256::GetKeyedState(Blake2sKeyedState &State)
+{
+	if (m_parallelProfile.IsParallel())
+		throw CryptoDigestException("Blake256:GetKeyedState", "The keyed state is not available in parallel mode!");
+	if (m_isKeyedChain || m_msgLength != BLOCK_SIZE || m_dgtState[0].T[0] != 0)
+		throw CryptoDigestException("Blake256:GetKeyedState", "The digest must hold exactly one buffered block; a key, or a single block of message data!");
+
+	// the key block is buffered; chain it for messages with data, and finalize it for the empty message
+	State.Chain = m_dgtState[0];
+	Compress(&m_msgBuffer[0], State.Chain, BLOCK_SIZE);
+
+	Blake2sState empty = m_dgtState[0];
+	empty.F[0] = UL_MAX;
+	Compress(&m_msgBuffer[0], empty, BLOCK_SIZE);
+	IntUtils::LeUL256ToBlock(empty.H, State.EmptyCode);
+
+	State.IsKeyed = true;
+}
+
+void Blake256::Import(const Blake256 &Source)
+{
+	if (&Source == this)
+		return;
+
+	m_dgtState = Source.m_dgtState;
+	m_digestSize = Source.m_digestSize;
+	m_isDestroyed = Source.m_isDestroyed;
+	m_isKeyedChain = Source.m_isKeyedChain;
+	m_isParallelSimd = Source.m_isParallelSimd;
+	m_kernels = Source.m_kernels;
+	m_keyedCode = Source.m_keyedCode;
+	m_leafSize = Source.m_leafSize;
+	m_msgBuffer = Source.m_msgBuffer;
+	m_msgLength = Source.m_msgLength;
+	m_parallelProfile = Source.m_parallelProfile;
+	m_treeConfig = Source.m_treeConfig;
+	m_treeDestroy = Source.m_treeDestroy;
+	m_treeParams = Source.m_treeParams;
+
+	// the working buffers are not copied; they are sized to the tree
+	if (m_parallelProfile.IsParallel())
+		LoadTree();
 }
 
 void Blake256::Initialize(Key::Symmetric::ISymmetricKey &MacKey)
@@ -227,23 +530,25 @@ void Blake256::Initialize(Key::Symmetric::ISymmetricKey &MacKey)
 	if (MacKey.Key().size() < 16 || MacKey.Key().size() > 32)
 		throw CryptoDigestException("Blake256", "Mac Key has invalid length!");
 
-	if (MacKey.Nonce().size() != 0)
-	{
-		if (MacKey.Nonce().size() != 8)
-			throw CryptoDigestException("Blake256", "Salt has invalid length!");
+	if (MacKey.Nonce().size() != 0 && MacKey.Nonce().size() != 8)
+		throw CryptoDigestException("Blake256", "Salt has invalid length!");
+	if (MacKey.Info().size() != 0 && MacKey.Info().size() != 8)
+		throw CryptoDigestException("Blake256", "Info has invalid length!");
 
-		m_treeConfig[4] = IntUtils::BytesToLe32(MacKey.Nonce(), 0);
-		m_treeConfig[5] = IntUtils::BytesToLe32(MacKey.Nonce(), 4);
-	}
+	// the salt and personalization are parameter block words 4 to 7; they are held in the distribution code,
+	// so that they are loaded with the rest of the parameter block on every Reset
+	std::vector<byte> &dstCode = m_treeParams.DistributionCode();
 
-	if (MacKey.Info().size() != 0)
-	{
-		if (MacKey.Info().size() != 8)
-			throw CryptoDigestException("Blake256", "Info has invalid length!");
+	if (dstCode.size() < DSTCODE_SIZE)
+		dstCode.resize(DSTCODE_SIZE, 0);
 
-		m_treeConfig[6] = IntUtils::BytesToLe32(MacKey.Info(), 0);
-		m_treeConfig[7] = IntUtils::BytesToLe32(MacKey.Info(), 4);
-	}
+	// each key sets its own salt and personalization; those of a previous key are cleared, and an absent value is all zeroes
+	memset(&dstCode[0], 0, 16);
+
+	if (MacKey.Nonce().size() != 0)
+		memcpy(&dstCode[0], &MacKey.Nonce()[0], 8);
+	if (MacKey.Info().size() != 0)
+		memcpy(&dstCode[8], &MacKey.Info()[0], 8);
 
 	std::vector<byte> mkey(BLOCK_SIZE, 0);
 	memcpy(&mkey[0], &MacKey.Key()[0], MacKey.Key().size());
@@ -269,6 +574,19 @@ void Blake256::Initialize(Key::Symmetric::ISymmetricKey &MacKey)
 	}
 }
 
+void Blake256::LoadKeyedState(const Blake2sKeyedState &State)
+{
+	if (m_parallelProfile.IsParallel())
+		throw CryptoDigestException("Blake256:LoadKeyedState", "The keyed state is not available in parallel mode!");
+	if (!State.IsKeyed)
+		throw CryptoDigestException("Blake256:LoadKeyedState", "The keyed state has not been created!");
+
+	m_dgtState[0] = State.Chain;
+	memcpy(&m_keyedCode[0], State.EmptyCode, DIGEST_SIZE);
+	m_msgLength = 0;
+	m_isKeyedChain = true;
+}
+
 void Blake256::ParallelMaxDegree(size_t Degree)
 {
 	if (Degree == 0)
@@ -278,35 +596,51 @@ void Blake256::ParallelMaxDegree(size_t Degree)
 	if (Degree % 2 != 0)
 		throw CryptoDigestException("Blake512:ParallelMaxDegree", "Parallel degree must be an even number!");
 
-	m_parallelProfile.SetMaxDegree(Degree);
-	m_dgtState.clear();
-	m_dgtState.resize(Degree);
-	m_msgBuffer.clear();
-	m_msgBuffer.resize(Degree * BLOCK_SIZE);
-
-	if (Degree > 1 && m_parallelProfile.ProcessorCount() > 1)
+	if (Degree > 1)
 	{
 		m_treeParams.FanOut() = static_cast<byte>(Degree);
 		m_treeParams.MaxDepth() = 2;
 		m_treeParams.InnerLength() = static_cast<byte>(DIGEST_SIZE);
 		m_parallelProfile.IsParallel() = true;
+		LoadTree();
 	}
 	else
 	{
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE));
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize));
 		m_parallelProfile.IsParallel() = false;
+		m_isParallelSimd = false;
 	}
 
 	Reset();
 }
 
+void Blake256::ParallelSimd(bool Enable)
+{
+	if (Enable && !m_parallelProfile.IsParallel())
+	{
+		// no tree is configured; use the Blake2sp defaults of depth 2, fanout 8
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize), 2, DEF_PRLDEGREE, 0, static_cast<byte>(DIGEST_SIZE));
+		m_parallelProfile.IsParallel() = true;
+	}
+
+	if (Enable)
+		LoadTree();
+
+	m_isParallelSimd = Enable;
+	Reset();
+}
+
 void Blake256::Reset()
 {
+	m_isKeyedChain = false;
 	m_msgLength = 0;
 	memset(&m_msgBuffer[0], 0, m_msgBuffer.size());
 
 	if (m_parallelProfile.IsParallel())
 	{
+		// the leaf depth; Finalize leaves the root depth in the tree parameters
+		m_treeParams.NodeDepth() = 0;
+
 		for (size_t i = 0; i < m_treeParams.FanOut(); ++i)
 		{
 			m_treeParams.NodeOffset() = static_cast<byte>(i);
@@ -320,13 +654,64 @@ void Blake256::Reset()
 	}
 }
 
+std::vector<byte> Blake256::Serialize()
+{
+	const size_t STECNT = m_parallelProfile.IsParallel() ? m_treeParams.FanOut() : 1;
+	const size_t STELEN = (CHAIN_SIZE + COUNTER_SIZE + FLAG_SIZE) * sizeof(uint);
+	const size_t PRMLEN = 13 + m_treeParams.DistributionCode().size();
+	std::vector<byte> state(SERIAL_HEADER + PRMLEN + (CHAIN_SIZE * sizeof(uint)) + (STECNT * STELEN) + m_msgLength + (m_isKeyedChain ? DIGEST_SIZE : 0));
+	size_t stateOff = SERIAL_HEADER;
+
+	state[0] = SERIAL_VERSION;
+	state[1] = static_cast<byte>(Enumeral());
+	state[2] = static_cast<byte>((m_parallelProfile.IsParallel() ? 1 : 0) | (m_isParallelSimd ? 2 : 0) | (m_isKeyedChain ? 4 : 0));
+	state[3] = static_cast<byte>(STECNT);
+	IntUtils::Le32ToBytes(m_leafSize, state, 4);
+	IntUtils::Le32ToBytes(static_cast<uint>(m_msgLength), state, 8);
+
+	state[stateOff] = m_treeParams.OutputSize();
+	state[stateOff + 1] = m_treeParams.KeyLength();
+	state[stateOff + 2] = m_treeParams.FanOut();
+	state[stateOff + 3] = m_treeParams.MaxDepth();
+	IntUtils::Le32ToBytes(m_treeParams.LeafLength(), state, stateOff + 4);
+	state[stateOff + 8] = m_treeParams.NodeOffset();
+	state[stateOff + 9] = m_treeParams.NodeDepth();
+	state[stateOff + 10] = m_treeParams.InnerLength();
+	state[stateOff + 11] = m_treeParams.Reserved();
+	state[stateOff + 12] = static_cast<byte>(m_treeParams.DistributionCode().size());
+	if (m_treeParams.DistributionCode().size() != 0)
+		memcpy(&state[stateOff + 13], &m_treeParams.DistributionCode()[0], m_treeParams.DistributionCode().size());
+	stateOff += PRMLEN;
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i, stateOff += sizeof(uint))
+		IntUtils::Le32ToBytes(m_treeConfig[i], state, stateOff);
+
+	for (size_t i = 0; i < STECNT; ++i)
+	{
+		for (size_t j = 0; j < CHAIN_SIZE; ++j, stateOff += sizeof(uint))
+			IntUtils::Le32ToBytes(m_dgtState[i].H[j], state, stateOff);
+		for (size_t j = 0; j < COUNTER_SIZE; ++j, stateOff += sizeof(uint))
+			IntUtils::Le32ToBytes(m_dgtState[i].T[j], state, stateOff);
+		for (size_t j = 0; j < FLAG_SIZE; ++j, stateOff += sizeof(uint))
+			IntUtils::Le32ToBytes(m_dgtState[i].F[j], state, stateOff);
+	}
+
+	if (m_msgLength != 0)
+		memcpy(&state[stateOff], &m_msgBuffer[0], m_msgLength);
+	stateOff += m_msgLength;
+
+	if (m_isKeyedChain)
+		memcpy(&state[stateOff], &m_keyedCode[0], DIGEST_SIZE);
+
+	return state;
+}
+
 void Blake256::Update(byte Input)
 {
-	std::vector<byte> inp(1, Input);
-	Update(inp, 0, 1);
+	Update(&Input, 1);
 }
 
-void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length)
+void Blake256::Update(const byte* Input, size_t Length)
 {
 	if (Length == 0)
 		return;
@@ -342,19 +727,26 @@ void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 			// fill buffer
 			size_t rmd = m_msgBuffer.size() - m_msgLength;
 			if (rmd != 0)
-				memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], rmd);
+				memcpy(&m_msgBuffer[m_msgLength], Input, rmd);
 
 			m_msgLength = 0;
 			Length -= rmd;
-			InOffset += rmd;
+			Input += rmd;
 			ttlLen -= m_msgBuffer.size();
 
 			// empty the entire message buffer
-			Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, &Input, InOffset](size_t i)
+			if (m_isParallelSimd)
 			{
-				Compress(m_msgBuffer, i * BLOCK_SIZE, m_dgtState[i], BLOCK_SIZE);
-				Compress(m_msgBuffer, (i * BLOCK_SIZE) + (m_treeParams.FanOut() * BLOCK_SIZE), m_dgtState[i], BLOCK_SIZE);
-			});
+				ProcessLeaves(&m_msgBuffer[0], m_msgBuffer.size());
+			}
+			else
+			{
+				Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this](size_t i)
+				{
+					Compress(&m_msgBuffer[i * BLOCK_SIZE], m_dgtState[i], BLOCK_SIZE);
+					Compress(&m_msgBuffer[(i * BLOCK_SIZE) + (m_treeParams.FanOut() * BLOCK_SIZE)], m_dgtState[i], BLOCK_SIZE);
+				});
+			}
 
 			// loop in the remainder (no buffering)
 			if (Length > PRLMIN)
@@ -365,13 +757,20 @@ void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 					prcLen -= (prcLen % m_parallelProfile.ParallelMinimumSize());
 
 				// process large blocks
-				Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, &Input, InOffset, prcLen](size_t i)
+				if (m_isParallelSimd)
 				{
-					ProcessLeaf(Input, InOffset + (i * BLOCK_SIZE), m_dgtState[i], prcLen);
-				});
+					ProcessLeaves(Input, prcLen);
+				}
+				else
+				{
+					Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, Input, prcLen](size_t i)
+					{
+						ProcessLeaf(Input + (i * BLOCK_SIZE), m_dgtState[i], prcLen);
+					});
+				}
 
 				Length -= prcLen;
-				InOffset += prcLen;
+				Input += prcLen;
 				ttlLen -= prcLen;
 			}
 		}
@@ -382,17 +781,24 @@ void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 			// fill buffer
 			size_t rmd = m_msgBuffer.size() - m_msgLength;
 			if (rmd != 0)
-				memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], rmd);
+				memcpy(&m_msgBuffer[m_msgLength], Input, rmd);
 
 			Length -= rmd;
-			InOffset += rmd;
+			Input += rmd;
 			m_msgLength = m_msgBuffer.size();
 
 			// process first half of buffer
-			Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, &Input, InOffset](size_t i)
+			if (m_isParallelSimd)
+			{
+				ProcessLeaves(&m_msgBuffer[0], m_msgBuffer.size() / 2);
+			}
+			else
 			{
-				Compress(m_msgBuffer, i * BLOCK_SIZE, m_dgtState[i], BLOCK_SIZE);
-			});
+				Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this](size_t i)
+				{
+					Compress(&m_msgBuffer[i * BLOCK_SIZE], m_dgtState[i], BLOCK_SIZE);
+				});
+			}
 
 			// left rotate the buffer
 			m_msgLength -= m_parallelProfile.ParallelMinimumSize();
@@ -406,19 +812,19 @@ void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 		{
 			size_t rmd = BLOCK_SIZE - m_msgLength;
 			if (rmd != 0)
-				memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], rmd);
+				memcpy(&m_msgBuffer[m_msgLength], Input, rmd);
 
-			Compress(m_msgBuffer, 0, m_dgtState[0], BLOCK_SIZE);
+			Compress(&m_msgBuffer[0], m_dgtState[0], BLOCK_SIZE);
 			m_msgLength = 0;
-			InOffset += rmd;
+			Input += rmd;
 			Length -= rmd;
 		}
 
 		// loop until last block
 		while (Length > BLOCK_SIZE)
 		{
-			Compress(Input, InOffset, m_dgtState[0], BLOCK_SIZE);
-			InOffset += BLOCK_SIZE;
+			Compress(Input, m_dgtState[0], BLOCK_SIZE);
+			Input += BLOCK_SIZE;
 			Length -= BLOCK_SIZE;
 		}
 	}
@@ -426,38 +832,126 @@ void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 	// store unaligned bytes
 	if (Length != 0)
 	{
-		memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], Length);
+		memcpy(&m_msgBuffer[m_msgLength], Input, Length);
 		m_msgLength += Length;
 	}
 }
 
+void Blake256::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length)
+{
+	if (Length == 0)
+		return;
+
+	Update(&Input[InOffset], Length);
+}
+
 //~~~Private Functions~~~//
 
-void Blake256::Compress(const std::vector<byte> &Input, size_t InOffset, Blake2sState &State, size_t Length)
+void Blake256::Compress(const byte* Input, Blake2sState &State, size_t Length)
 {
-	ArrayUtils::IncreaseLE32(State.T, State.T, Length);
-	Blake256Compress::Compress64(Input, InOffset, State, m_cIV);
+	ArrayUtils::IncreaseLE32(State.T, Length);
+	m_kernels->Compress64(Input, State, SCIV);
 }
 
-void Blake256::LoadState(Blake2sState &State)
+void Blake256::LoadLane(Blake2sWideState &State, size_t Lane, size_t Length, size_t &BlockCount)
+{
+	// the lane starts from the current sequential state
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+		State.H[(i * State.Lanes) + Lane] = m_dgtState[0].H[i];
+
+	State.F[State.Lanes + Lane] = 0;
+	// an empty message is still compressed as one zero block
+	BlockCount = (Length == 0) ? 1 : (Length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+void Blake256::LoadTree()
 {
-	memset(&State.T[0], 0, COUNTER_SIZE * sizeof(uint));
-	memset(&State.F[0], 0, FLAG_SIZE * sizeof(uint));
-	memcpy(&State.H[0], &m_cIV[0], CHAIN_SIZE * sizeof(uint));
+	// the only place the tree state is sized; called by every path that enables parallel mode.
+	// the leaf blocks are interleaved FanOut blocks apart, independent of the processor count
+	m_parallelProfile.SetMaxDegree(m_treeParams.FanOut());
 
+	if (m_dgtState.size() < m_treeParams.FanOut())
+		m_dgtState.resize(m_treeParams.FanOut());
+
+	m_msgBuffer.resize(2 * m_treeParams.FanOut() * BLOCK_SIZE);
+	m_leafHashes.resize(m_treeParams.FanOut() * DIGEST_SIZE);
+
+	// the multi-buffer lane state is sized here rather than on every update
+	const size_t LNECNT = m_kernels->Lanes64W;
+
+	if (m_laneState.Lanes != LNECNT)
+	{
+		m_laneInput.resize(LNECNT);
+		m_laneState = Blake2sWideState(LNECNT);
+	}
+}
+
+void Blake256::LoadState(Blake2sState &State)
+{
+	State.Reset();
+	// the code size follows the digest type; only the salt and personalization words are in the Blake2s block
+	m_treeParams.DistributionCode().resize(DSTCODE_SIZE, 0);
 	m_treeParams.GetConfig<uint>(m_treeConfig);
-	IntUtils::XORUL256(m_treeConfig, 0, State.H, 0);
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+		State.H[i] = SCIV[i] ^ m_treeConfig[i];
 }
 
-void Blake256::ProcessLeaf(const std::vector<byte> &Input, size_t InOffset, Blake2sState &State, ulong Length)
+void Blake256::ProcessLeaf(const byte* Input, Blake2sState &State, ulong Length)
 {
 	do
 	{
-		Compress(Input, InOffset, State, BLOCK_SIZE);
-		InOffset += m_parallelProfile.ParallelMinimumSize();
+		Compress(Input, State, BLOCK_SIZE);
+		Input += m_parallelProfile.ParallelMinimumSize();
 		Length -= m_parallelProfile.ParallelMinimumSize();
 	} 
 	while (Length > 0);
 }
 
+void Blake256::ProcessLeaves(const byte* Input, size_t Length)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	// the lane state is sized by LoadTree
+	const size_t LNECNT = m_laneState.Lanes;
+	const size_t STRIDE = FNOUT * BLOCK_SIZE;
+	std::vector<const byte*> &lnePtr = m_laneInput;
+	Blake2sWideState &wState = m_laneState;
+
+	// leaf i is lane (i % LNECNT) of group (i / LNECNT); the kernel runs every block of the group in one call
+	for (size_t i = 0; i < FNOUT; i += LNECNT)
+	{
+		const size_t GRPLEN = (FNOUT - i < LNECNT) ? FNOUT - i : LNECNT;
+
+		for (size_t j = 0; j < LNECNT; ++j)
+		{
+			// idle lanes of a partial group repeat the first leaf, their output is discarded
+			const size_t LEAF = i + ((j < GRPLEN) ? j : 0);
+			const Blake2sState &leaf = m_dgtState[LEAF];
+
+			lnePtr[j] = Input + (LEAF * BLOCK_SIZE);
+
+			for (size_t k = 0; k < CHAIN_SIZE; ++k)
+				wState.H[(k * LNECNT) + j] = leaf.H[k];
+
+			wState.T[j] = leaf.T[0];
+			wState.T[LNECNT + j] = leaf.T[1];
+			wState.F[j] = leaf.F[0];
+			wState.F[LNECNT + j] = leaf.F[1];
+		}
+
+		m_kernels->Compress64WBlocks(lnePtr, STRIDE, Length / STRIDE, wState, SCIV);
+
+		for (size_t j = 0; j < GRPLEN; ++j)
+		{
+			Blake2sState &leaf = m_dgtState[i + j];
+
+			for (size_t k = 0; k < CHAIN_SIZE; ++k)
+				leaf.H[k] = wState.H[(k * LNECNT) + j];
+
+			leaf.T[0] = wState.T[j];
+			leaf.T[1] = wState.T[LNECNT + j];
+		}
+	}
+}
+
 NAMESPACE_DIGESTEND
\ No newline at end of file
@@ -32,9 +32,12 @@
 #ifndef _CEX_BLAKE2SP256_H
 #define _CEX_BLAKE2SP256_H
 
+#include "BlakeDispatch.h"
 #include "BlakeParams.h"
+#include "BlakeState.h"
 #include "IDigest.h"
 #include "ISymmetricKey.h"
+#include <array>
 
 NAMESPACE_DIGEST
 
@@ -86,11 +89,14 @@ using Key::Symmetric::ISymmetricKey;
 /// <item><description>Parallel Block input size to the Update function should be aligned to a multiple of ParallelMinimumSize() for best performance.</description></item>
 /// <item><description>Best performance for parallel mode is to use a large input block size to minimize parallel loop creation cost, block size should be in a range of 32KiB to 25MiB.</description></item>
 /// <item><description>The number of threads used in parallel mode can be user defined through the BlakeParams->ThreadCount property to any even number of threads; note that hash value will change with threadcount.</description></item>
-/// <item><description>Digest output size is fixed at 32 bytes, (256 bits).</description></item>
+/// <item><description>The ParallelSimd(bool) method hashes the eight Blake2SP leaves in the lanes of the AVX2 kernel on one thread, rather than one leaf per thread.</description></item>
+/// <item><description>Digest output size is 32 bytes, (256 bits) by default; a shorter output of 1 to 32 bytes is set through the constructor, or the BlakeParams OutputSize() parameter.</description></item>
+/// <item><description>The output size is written to the parameter block, so a shorter output is a different hash, not a truncation of the 32 byte hash; Finalize writes only the requested bytes.</description></item>
+/// <item><description>The ComputeBatch method hashes many independent messages at once, compressing eight messages in lockstep with the AVX2 multi-buffer kernel.</description></item>
 /// <item><description>The <see cref="Compute(byte[])"/> method wraps the <see cref="Update(byte[], size_t, size_t)"/> and Finalize methods</description>/></item>
 /// <item><description>The <see cref="Finalize(byte[], size_t)"/> method resets the internal state.</description></item>
 /// <item><description>Optional intrinsics are runtime enabled automatically based on cpu support.</description></item>
-/// <item><description>SIMD implementation requires compilation with SSE3 or higher.</description></item>
+/// <item><description>The SSE4.1 and AVX2 kernels are selected at runtime by BlakeDispatch; no instruction set option is required at compilation.</description></item>
 /// </list>
 /// 
 /// <description>Guiding Publications:</description>
@@ -113,49 +119,35 @@ private:
 	static const uint DEF_PRLDEGREE = 8;
 	static const uint DEF_LEAFSIZE = 16384;
 	static const size_t DIGEST_SIZE = 32;
+	static const size_t DSTCODE_SIZE = 16;
 	static const uint FLAG_SIZE = 2;
 	static const uint MAX_PRLBLOCK = 5120000;
 	static const uint MIN_PRLBLOCK = 256;
 	static const size_t ROUND_COUNT = 10;
+	// the serialized state header; version, digest, mode flags, state count, leaf size and buffered length
+	static const size_t SERIAL_HEADER = 12;
+	static const byte SERIAL_VERSION = 1;
 	// size of reserved state buffer subtracted from parallel size calculations
 	static const size_t STATE_PRECACHED = 2048;
 	static const uint UL_MAX = 4294967295;
 
-	struct Blake2sState
-	{
-		std::vector<uint> F;
-		std::vector<uint> H;
-		std::vector<uint> T;
-
-		Blake2sState()
-			:
-			F(2),
-			H(8),
-			T(2)
-		{
-		}
-
-		void Reset()
-		{
-			if (F.size() > 0)
-				memset(&F[0], 0, F.size() * sizeof(uint));
-			if (H.size() > 0)
-				memset(&H[0], 0, H.size() * sizeof(uint));
-			if (T.size() > 0)
-				memset(&T[0], 0, T.size() * sizeof(uint));
-		}
-	};
-
-	std::vector<uint> m_cIV;
-	std::vector<Blake2sState> m_dgtState;
+	Blake2sStateArray m_dgtState;
+	size_t m_digestSize;
 	bool m_isDestroyed;
+	bool m_isKeyedChain;
+	bool m_isParallelSimd;
+	const BlakeDispatch::Kernels* m_kernels;
+	std::array<byte, DIGEST_SIZE> m_keyedCode;
+	std::vector<const byte*> m_laneInput;
+	Blake2sWideState m_laneState;
+	std::vector<byte> m_leafHashes;
 	uint m_leafSize;
 	std::vector<byte> m_msgBuffer;
 	size_t m_msgLength;
-	std::vector<uint> m_treeConfig;
+	ParallelOptions m_parallelProfile;
+	std::array<uint, CHAIN_SIZE> m_treeConfig;
 	bool m_treeDestroy;
 	BlakeParams m_treeParams;
-	ParallelOptions m_parallelProfile;
 
 public:
 
@@ -173,7 +165,7 @@ public:
 	/// <summary>
 	/// Get: Size of returned digest in bytes
 	/// </summary>
-	virtual size_t DigestSize() { return DIGEST_SIZE; }
+	virtual size_t DigestSize() { return m_digestSize; }
 
 	/// <summary>
 	/// Get: The digests type name
@@ -190,6 +182,11 @@ public:
 	/// </summary>
 	virtual const bool IsParallel() { return m_parallelProfile.IsParallel(); }
 
+	/// <summary>
+	/// Get: The tree leaves are hashed together by the multi-buffer kernel on the calling thread, see ParallelSimd(bool)
+	/// </summary>
+	const bool IsParallelSimd() { return m_isParallelSimd; }
+
 	/// <summary>
 	/// Get: The digests class name
 	/// </summary>
@@ -223,6 +220,17 @@ public:
 	/// <param name="Parallel">Setting the Parallel flag to true, instantiates the Blake2SP variant.</param>
 	explicit Blake256(bool Parallel = false);
 
+	/// <summary>
+	/// Initialize the class with a digest output size.
+	/// <para>The output size is part of the parameter block; a 16 byte output is not the first 16 bytes of the default output.</para>
+	/// </summary>
+	/// 
+	/// <param name="DigestSize">The digest output size in bytes, between 1 and 32.</param>
+	/// <param name="Parallel">Setting the Parallel flag to true, instantiates the Blake2SP variant.</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest size is invalid</exception>
+	Blake256(size_t DigestSize, bool Parallel);
+
 	/// <summary>
 	/// Initialize the class with a BlakeParams structure.
 	/// <para>The parameters structure allows for tuning of the internal configuration string,
@@ -241,6 +249,15 @@ public:
 
 	//~~~Public Functions~~~//
 
+	/// <summary>
+	/// Create a deep copy of this digest; the configuration, and the state of the message processed so far.
+	/// <para>The copy continues the message independently of this instance, e.g. a shared prefix is processed once, and each copy completes a different suffix.
+	/// Includes the leaf states of a parallel digest, and a keyed or template state. Caller must delete the returned instance.</para>
+	/// </summary>
+	/// 
+	/// <returns>A pointer to the new digest instance</returns>
+	Blake256* Clone();
+
 	/// <summary>
 	/// Process the message data and return the Hash value
 	/// </summary>
@@ -249,6 +266,30 @@ public:
 	/// <param name="Output">The hash value output array</param>
 	virtual void Compute(const std::vector<byte> &Input, std::vector<byte> &Output);
 
+	/// <summary>
+	/// Hash a batch of independent messages and return a hash value for each.
+	/// <para>Messages are compressed eight at a time in lockstep by the multi-buffer kernel, with each message occupying one 32 bit lane of the state.
+	/// Each message is processed as a continuation of the current state, so a digest that was initialized with a MAC key produces a keyed hash for every message.
+	/// The digest is reset when the function returns. Available in sequential mode only.</para>
+	/// </summary>
+	/// 
+	/// <param name="Input">The message input data; messages may have different lengths</param>
+	/// <param name="Output">Receives the hash values, in the same order as the input messages</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest is in parallel mode</exception>
+	void ComputeBatch(const std::vector<std::vector<byte>> &Input, std::vector<std::vector<byte>> &Output);
+
+	/// <summary>
+	/// Restore a digest state written by Serialize; the message continues from the point at which it was serialized.
+	/// <para>Replaces the configuration and state of this instance, including the tree parameters and parallel mode of the serialized digest.
+	/// The state may be restored by another process, or on another machine.</para>
+	/// </summary>
+	/// 
+	/// <param name="State">The serialized digest state</param>
+	/// 
+	/// <exception cref="CryptoDigestException">Thrown if the state is not a Blake256 state of a supported version, or is malformed</exception>
+	void DeSerialize(const std::vector<byte> &State);
+
 	/// <summary>
 	/// Release all resources associated with the object
 	/// </summary>
@@ -266,6 +307,35 @@ public:
 	/// <exception cref="CryptoDigestException">Thrown if the output buffer is too short</exception>
 	virtual size_t Finalize(std::vector<byte> &Output, const size_t OutOffset);
 
+	/// <summary>
+	/// Perform final processing and write the hash value to caller memory
+	/// </summary>
+	/// 
+	/// <param name="Output">Pointer to the destination; must have room for DigestSize() bytes</param>
+	/// 
+	/// <returns>Size of Hash value</returns>
+	virtual size_t Finalize(byte* Output);
+
+	/// <summary>
+	/// Create a keyed template from the key loaded by Initialize(ISymmetricKey), or from a single block of message data, e.g. an HMAC pad.
+	/// <para>The buffered block is compressed once, into the template; the digest state is unchanged.
+	/// Must be called after Initialize and before any message data is added, or after exactly BlockSize() bytes have been added to a reset digest.
+	/// Available in sequential mode only.</para>
+	/// </summary>
+	///
+	/// <param name="State">Receives the keyed template</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest is parallel, or does not hold exactly one buffered block</exception>
+	void GetKeyedState(Blake2sKeyedState &State);
+
+	/// <summary>
+	/// Replace the configuration and message state of this digest with a copy of another instance.
+	/// <para>The allocation free counterpart of Clone; a digest that is reused for each suffix imports the prefix state before every message.</para>
+	/// </summary>
+	/// 
+	/// <param name="Source">The digest to copy</param>
+	void Import(const Blake256 &Source);
+
 	/// <summary>
 	/// Initialize the digest as a MAC code generator
 	/// </summary>
@@ -276,6 +346,18 @@ public:
 	/// The maximum combined size of Key, Salt, and Info, must be 64 bytes or less.</para></param>
 	virtual void Initialize(ISymmetricKey &MacKey);
 
+	/// <summary>
+	/// Load a keyed template created by GetKeyedState; the digest is ready for a message under the template key.
+	/// <para>Replaces Initialize for each new message under the same key; only the chain state and the empty message code are copied.
+	/// As with Initialize, the template is discarded by Finalize and Reset. Available in sequential mode only.
+	/// The template must be created by a digest with the same output size.</para>
+	/// </summary>
+	///
+	/// <param name="State">The keyed template</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest is parallel, or the template has not been created</exception>
+	void LoadKeyedState(const Blake2sKeyedState &State);
+
 	/// <summary>
 	/// Set the number of threads allocated when using multi-threaded tree hashing processing.
 	/// <para>Thread count must be an even number, and not exceed the number of processor cores.
@@ -287,11 +369,32 @@ public:
 	/// <exception cref="Exception::CryptoDigestException">Thrown if an invalid degree setting is used</exception>
 	virtual void ParallelMaxDegree(size_t Degree);
 
+	/// <summary>
+	/// Enable or disable single-threaded SIMD tree hashing.
+	/// <para>When enabled, the eight leaves of a Blake2SP tree occupy the eight 32-bit lanes of the AVX2 kernel, which compresses each
+	/// run of interleaved leaf blocks with the leaf states held in registers; no threads are created, and the mode is available on any processor count.
+	/// If the digest is sequential, the Blake2SP defaults (depth 2, fanout 8) are loaded; an existing tree configuration is kept.
+	/// The output is identical to the multi-threaded Blake2SP with the same tree parameters.
+	/// The internal state is reset, so this must be called before Initialize(ISymmetricKey).</para>
+	/// </summary>
+	///
+	/// <param name="Enable">Process the leaves with the multi-buffer kernel, or with threads if false</param>
+	void ParallelSimd(bool Enable);
+
 	/// <summary>
 	/// Reset the internal state to sequential defaults
 	/// </summary>
 	virtual void Reset();
 
+	/// <summary>
+	/// Write the digest state to a compact, versioned byte array; used to checkpoint a long message, and resume it with DeSerialize.
+	/// <para>Contains the tree parameters, the chaining values, counters and flags of every active leaf, and the buffered message bytes.
+	/// Integers are little endian; the array contains keyed state, and should be protected as key material.</para>
+	/// </summary>
+	/// 
+	/// <returns>The serialized digest state</returns>
+	std::vector<byte> Serialize();
+
 	/// <summary>
 	/// Update the message digest with a single byte
 	/// </summary>
@@ -313,11 +416,23 @@ public:
 	/// <param name="Length">The amount of data to process in bytes</param>
 	virtual void Update(const std::vector<byte> &Input, size_t InOffset, size_t Length);
 
+	/// <summary>
+	/// Update the buffer from caller memory, such as a mapped file or a network buffer.
+	/// <para>Whole blocks are compressed in place from the caller's memory; only a trailing partial block is copied to the internal buffer.</para>
+	/// </summary>
+	/// 
+	/// <param name="Input">Pointer to the input data</param>
+	/// <param name="Length">Amount of data to process in bytes</param>
+	virtual void Update(const byte* Input, size_t Length);
+
 private:
 
-	void Compress(const std::vector<byte> &Input, size_t InOffset, Blake2sState &State, size_t Length);
+	void Compress(const byte* Input, Blake2sState &State, size_t Length);
+	void LoadLane(Blake2sWideState &State, size_t Lane, size_t Length, size_t &BlockCount);
 	void LoadState(Blake2sState &State);
-	void ProcessLeaf(const std::vector<byte> &Input, size_t InOffset, Blake2sState &State, ulong Length);
+	void LoadTree();
+	void ProcessLeaf(const byte* Input, Blake2sState &State, ulong Length);
+	void ProcessLeaves(const byte* Input, size_t Length);
 };
 
 NAMESPACE_DIGESTEND
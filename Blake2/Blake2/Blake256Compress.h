@@ -31,20 +31,40 @@ class Blake256Compress
 {
 private:
 
-#if defined(__AVX__)
+#if defined(CEX_TARGET_DISPATCH)
 #	define TOF(reg) _mm_castsi128_ps((reg))
 #	define TOI(reg) _mm_castps_si128((reg))
 #	define _mm_roti_epi32(r, c) ( \
         (8==-(c)) ? _mm_shuffle_epi8(r,R8) \
         : (16==-(c)) ? _mm_shuffle_epi8(r,R16) \
         : _mm_xor_si128(_mm_srli_epi32( (r), -(c) ),_mm_slli_epi32( (r), 32-(-(c)) )) )
+
+#	define _mm256_roti_epi32(r, c) ( \
+        (8==-(c)) ? _mm256_shuffle_epi8(r,R8W) \
+        : (16==-(c)) ? _mm256_shuffle_epi8(r,R16W) \
+        : _mm256_xor_si256(_mm256_srli_epi32( (r), -(c) ),_mm256_slli_epi32( (r), 32-(-(c)) )) )
+
+#	define G8W(A, B, C, D, X, Y) \
+		A = _mm256_add_epi32(_mm256_add_epi32(A, X), B); \
+		D = _mm256_roti_epi32(_mm256_xor_si256(D, A), -16); \
+		C = _mm256_add_epi32(C, D); \
+		B = _mm256_roti_epi32(_mm256_xor_si256(B, C), -12); \
+		A = _mm256_add_epi32(_mm256_add_epi32(A, Y), B); \
+		D = _mm256_roti_epi32(_mm256_xor_si256(D, A), -8); \
+		C = _mm256_add_epi32(C, D); \
+		B = _mm256_roti_epi32(_mm256_xor_si256(B, C), -7);
 #endif
 
 public:
 
-#if defined(__AVX__)
+#if defined(CEX_TARGET_DISPATCH)
+
+	/// <summary>
+	/// Compress a message block using SSSE3 and SSE4.1 intrinsics.
+	/// <para>Compiled with a function level target; the caller must check for SSE4.1 support at runtime.</para>
+	/// </summary>
 	template <typename T>
-	static void Compress64(const std::vector<byte> &Input, size_t InOffset, T &State, const std::vector<uint> &IV)
+	CEX_TARGET_SSE41 static void Compress64Sse41(const byte* Input, T &State, const std::vector<uint> &IV)
 	{
 		__m128i R1, R2, R3, R4;
 		__m128i B1, B2, B3, B4;
@@ -53,18 +73,15 @@ public:
 
 		const __m128i R8 = _mm_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
 		const __m128i R16 = _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
-		const __m128i M0 = _mm_loadu_si128((const __m128i*)&Input[InOffset]);
-		const __m128i M1 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 16]);
-		const __m128i M2 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 32]);
-		const __m128i M3 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 48]);
+		const __m128i M0 = _mm_loadu_si128((const __m128i*)Input);
+		const __m128i M1 = _mm_loadu_si128((const __m128i*)(Input + 16));
+		const __m128i M2 = _mm_loadu_si128((const __m128i*)(Input + 32));
+		const __m128i M3 = _mm_loadu_si128((const __m128i*)(Input + 48));
 
 		R1 = FF0 = _mm_loadu_si128((const __m128i*)&State.H[0]);
 		R2 = FF1 = _mm_loadu_si128((const __m128i*)&State.H[4]);
 		R3 = _mm_loadu_si128((const __m128i*)&IV[0]);
-		std::vector<byte> taf(16);
-		memcpy(&taf[0], &State.T[0], 8);
-		memcpy(&taf[8], &State.F[0], 8);
-		R4 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&IV[4]), _mm_loadu_si128((const __m128i*)&taf[0]));
+		R4 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&IV[4]), _mm_set_epi32(State.F[1], State.F[0], State.T[1], State.T[0]));
 
 		// round 0
 		// lm 0.1
@@ -607,13 +624,13 @@ public:
 		_mm_storeu_si128((__m128i*)&State.H[4], _mm_xor_si128(FF1, _mm_xor_si128(R2, R4)));
 	}
 
-#else
+#endif
 
 	template <typename T>
-	static void Compress64(const std::vector<byte> &Input, size_t InOffset, T &State, const std::vector<uint> &IV)
+	static void Compress64(const byte* Input, T &State, const std::vector<uint> &IV)
 	{
-		std::vector<uint> M(16);
-		Utility::IntUtils::BytesToLeUL512(Input, InOffset, M, 0);
+		uint M[16];
+		Utility::IntUtils::BytesToLeUL512(Input, M);
 
 		uint R0 = State.H[0];
 		uint R1 = State.H[1];
@@ -1691,6 +1708,254 @@ public:
 		State.H[6] ^= R6 ^ R14;
 		State.H[7] ^= R7 ^ R15;
 	}
+
+#if defined(CEX_TARGET_DISPATCH)
+
+	/// <summary>
+	/// Compress eight independent message blocks using AVX2, one per state lane.
+	/// <para>The wide state is stored transposed; word j of lane i is at H[(j * 8) + i], T[i] and T[8 + i] hold the lane counter, F[i] and F[8 + i] the lane flags.
+	/// Compiled with a function level target; the caller must check for AVX2 support at runtime.</para>
+	/// </summary>
+	template <typename T>
+	CEX_TARGET_AVX2 static void Compress64WAvx2(const byte* const* Input, T &State, const uint* IV)
+	{
+		static const byte SIGMA[10][16] =
+		{
+			{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+			{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+			{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+			{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+			{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+			{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+			{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+			{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+			{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 }
+		};
+
+		const __m256i R8W = _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1, 12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
+		const __m256i R16W = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+		__m256i M[16];
+		__m256i P[8];
+		__m256i T0, T1, T2, T3, T4, T5, T6, T7;
+
+		// load and transpose the eight message blocks, eight words at a time
+		for (size_t i = 0; i < 2; ++i)
+		{
+			for (size_t j = 0; j < 8; ++j)
+				P[j] = _mm256_loadu_si256((const __m256i*)(Input[j] + (i * 32)));
+
+			T0 = _mm256_unpacklo_epi32(P[0], P[1]);
+			T1 = _mm256_unpackhi_epi32(P[0], P[1]);
+			T2 = _mm256_unpacklo_epi32(P[2], P[3]);
+			T3 = _mm256_unpackhi_epi32(P[2], P[3]);
+			T4 = _mm256_unpacklo_epi32(P[4], P[5]);
+			T5 = _mm256_unpackhi_epi32(P[4], P[5]);
+			T6 = _mm256_unpacklo_epi32(P[6], P[7]);
+			T7 = _mm256_unpackhi_epi32(P[6], P[7]);
+
+			P[0] = _mm256_unpacklo_epi64(T0, T2);
+			P[1] = _mm256_unpackhi_epi64(T0, T2);
+			P[2] = _mm256_unpacklo_epi64(T1, T3);
+			P[3] = _mm256_unpackhi_epi64(T1, T3);
+			P[4] = _mm256_unpacklo_epi64(T4, T6);
+			P[5] = _mm256_unpackhi_epi64(T4, T6);
+			P[6] = _mm256_unpacklo_epi64(T5, T7);
+			P[7] = _mm256_unpackhi_epi64(T5, T7);
+
+			M[(i * 8)] = _mm256_permute2x128_si256(P[0], P[4], 0x20);
+			M[(i * 8) + 1] = _mm256_permute2x128_si256(P[1], P[5], 0x20);
+			M[(i * 8) + 2] = _mm256_permute2x128_si256(P[2], P[6], 0x20);
+			M[(i * 8) + 3] = _mm256_permute2x128_si256(P[3], P[7], 0x20);
+			M[(i * 8) + 4] = _mm256_permute2x128_si256(P[0], P[4], 0x31);
+			M[(i * 8) + 5] = _mm256_permute2x128_si256(P[1], P[5], 0x31);
+			M[(i * 8) + 6] = _mm256_permute2x128_si256(P[2], P[6], 0x31);
+			M[(i * 8) + 7] = _mm256_permute2x128_si256(P[3], P[7], 0x31);
+		}
+
+		__m256i R0 = _mm256_loadu_si256((const __m256i*)&State.H[0]);
+		__m256i R1 = _mm256_loadu_si256((const __m256i*)&State.H[8]);
+		__m256i R2 = _mm256_loadu_si256((const __m256i*)&State.H[16]);
+		__m256i R3 = _mm256_loadu_si256((const __m256i*)&State.H[24]);
+		__m256i R4 = _mm256_loadu_si256((const __m256i*)&State.H[32]);
+		__m256i R5 = _mm256_loadu_si256((const __m256i*)&State.H[40]);
+		__m256i R6 = _mm256_loadu_si256((const __m256i*)&State.H[48]);
+		__m256i R7 = _mm256_loadu_si256((const __m256i*)&State.H[56]);
+		__m256i R8 = _mm256_set1_epi32(IV[0]);
+		__m256i R9 = _mm256_set1_epi32(IV[1]);
+		__m256i R10 = _mm256_set1_epi32(IV[2]);
+		__m256i R11 = _mm256_set1_epi32(IV[3]);
+		__m256i R12 = _mm256_xor_si256(_mm256_set1_epi32(IV[4]), _mm256_loadu_si256((const __m256i*)&State.T[0]));
+		__m256i R13 = _mm256_xor_si256(_mm256_set1_epi32(IV[5]), _mm256_loadu_si256((const __m256i*)&State.T[8]));
+		__m256i R14 = _mm256_xor_si256(_mm256_set1_epi32(IV[6]), _mm256_loadu_si256((const __m256i*)&State.F[0]));
+		__m256i R15 = _mm256_xor_si256(_mm256_set1_epi32(IV[7]), _mm256_loadu_si256((const __m256i*)&State.F[8]));
+
+		for (size_t i = 0; i < 10; ++i)
+		{
+			const byte* S = SIGMA[i];
+
+			// column step
+			G8W(R0, R4, R8, R12, M[S[0]], M[S[1]]);
+			G8W(R1, R5, R9, R13, M[S[2]], M[S[3]]);
+			G8W(R2, R6, R10, R14, M[S[4]], M[S[5]]);
+			G8W(R3, R7, R11, R15, M[S[6]], M[S[7]]);
+			// diagonal step
+			G8W(R0, R5, R10, R15, M[S[8]], M[S[9]]);
+			G8W(R1, R6, R11, R12, M[S[10]], M[S[11]]);
+			G8W(R2, R7, R8, R13, M[S[12]], M[S[13]]);
+			G8W(R3, R4, R9, R14, M[S[14]], M[S[15]]);
+		}
+
+		_mm256_storeu_si256((__m256i*)&State.H[0], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[0]), _mm256_xor_si256(R0, R8)));
+		_mm256_storeu_si256((__m256i*)&State.H[8], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[8]), _mm256_xor_si256(R1, R9)));
+		_mm256_storeu_si256((__m256i*)&State.H[16], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[16]), _mm256_xor_si256(R2, R10)));
+		_mm256_storeu_si256((__m256i*)&State.H[24], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[24]), _mm256_xor_si256(R3, R11)));
+		_mm256_storeu_si256((__m256i*)&State.H[32], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[32]), _mm256_xor_si256(R4, R12)));
+		_mm256_storeu_si256((__m256i*)&State.H[40], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[40]), _mm256_xor_si256(R5, R13)));
+		_mm256_storeu_si256((__m256i*)&State.H[48], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[48]), _mm256_xor_si256(R6, R14)));
+		_mm256_storeu_si256((__m256i*)&State.H[56], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[56]), _mm256_xor_si256(R7, R15)));
+	}
+
+	/// <summary>
+	/// Compress a run of strided message blocks in each of eight state lanes using AVX2.
+	/// <para>Block k of lane i is read at Input[i] + (k * Stride), and the lane counter is increased by the block size before each compression.
+	/// The chaining values and counters are held in registers for the whole run; the wide state layout is that of Compress64WAvx2.
+	/// Compiled with a function level target; the caller must check for AVX2 support at runtime.</para>
+	/// </summary>
+	template <typename T>
+	CEX_TARGET_AVX2 static void Compress64WBlocksAvx2(const byte* const* Input, size_t Stride, size_t BlockCount, T &State, const uint* IV)
+	{
+		static const byte SIGMA[10][16] =
+		{
+			{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+			{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+			{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+			{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+			{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+			{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+			{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+			{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+			{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 }
+		};
+
+		const __m256i R8W = _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1, 12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
+		const __m256i R16W = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+		const __m256i BLKLEN = _mm256_set1_epi32(64);
+		const __m256i CTRMAX = _mm256_set1_epi32(63);
+		const __m256i F0 = _mm256_loadu_si256((const __m256i*)&State.F[0]);
+		const __m256i F1 = _mm256_loadu_si256((const __m256i*)&State.F[8]);
+		__m256i M[16];
+		__m256i P[8];
+		__m256i T0, T1, T2, T3, T4, T5, T6, T7;
+		__m256i H0 = _mm256_loadu_si256((const __m256i*)&State.H[0]);
+		__m256i H1 = _mm256_loadu_si256((const __m256i*)&State.H[8]);
+		__m256i H2 = _mm256_loadu_si256((const __m256i*)&State.H[16]);
+		__m256i H3 = _mm256_loadu_si256((const __m256i*)&State.H[24]);
+		__m256i H4 = _mm256_loadu_si256((const __m256i*)&State.H[32]);
+		__m256i H5 = _mm256_loadu_si256((const __m256i*)&State.H[40]);
+		__m256i H6 = _mm256_loadu_si256((const __m256i*)&State.H[48]);
+		__m256i H7 = _mm256_loadu_si256((const __m256i*)&State.H[56]);
+		__m256i C0 = _mm256_loadu_si256((const __m256i*)&State.T[0]);
+		__m256i C1 = _mm256_loadu_si256((const __m256i*)&State.T[8]);
+
+		for (size_t k = 0; k < BlockCount; ++k)
+		{
+			const size_t BLKOFT = k * Stride;
+
+			// load and transpose the eight message blocks, eight words at a time
+			for (size_t i = 0; i < 2; ++i)
+			{
+				for (size_t j = 0; j < 8; ++j)
+					P[j] = _mm256_loadu_si256((const __m256i*)(Input[j] + BLKOFT + (i * 32)));
+
+				T0 = _mm256_unpacklo_epi32(P[0], P[1]);
+				T1 = _mm256_unpackhi_epi32(P[0], P[1]);
+				T2 = _mm256_unpacklo_epi32(P[2], P[3]);
+				T3 = _mm256_unpackhi_epi32(P[2], P[3]);
+				T4 = _mm256_unpacklo_epi32(P[4], P[5]);
+				T5 = _mm256_unpackhi_epi32(P[4], P[5]);
+				T6 = _mm256_unpacklo_epi32(P[6], P[7]);
+				T7 = _mm256_unpackhi_epi32(P[6], P[7]);
+
+				P[0] = _mm256_unpacklo_epi64(T0, T2);
+				P[1] = _mm256_unpackhi_epi64(T0, T2);
+				P[2] = _mm256_unpacklo_epi64(T1, T3);
+				P[3] = _mm256_unpackhi_epi64(T1, T3);
+				P[4] = _mm256_unpacklo_epi64(T4, T6);
+				P[5] = _mm256_unpackhi_epi64(T4, T6);
+				P[6] = _mm256_unpacklo_epi64(T5, T7);
+				P[7] = _mm256_unpackhi_epi64(T5, T7);
+
+				M[(i * 8)] = _mm256_permute2x128_si256(P[0], P[4], 0x20);
+				M[(i * 8) + 1] = _mm256_permute2x128_si256(P[1], P[5], 0x20);
+				M[(i * 8) + 2] = _mm256_permute2x128_si256(P[2], P[6], 0x20);
+				M[(i * 8) + 3] = _mm256_permute2x128_si256(P[3], P[7], 0x20);
+				M[(i * 8) + 4] = _mm256_permute2x128_si256(P[0], P[4], 0x31);
+				M[(i * 8) + 5] = _mm256_permute2x128_si256(P[1], P[5], 0x31);
+				M[(i * 8) + 6] = _mm256_permute2x128_si256(P[2], P[6], 0x31);
+				M[(i * 8) + 7] = _mm256_permute2x128_si256(P[3], P[7], 0x31);
+			}
+
+			// increase the low counter words, and carry into the high words where the low word wrapped
+			C0 = _mm256_add_epi32(C0, BLKLEN);
+			C1 = _mm256_sub_epi32(C1, _mm256_cmpeq_epi32(_mm256_min_epu32(C0, CTRMAX), C0));
+
+			__m256i R0 = H0;
+			__m256i R1 = H1;
+			__m256i R2 = H2;
+			__m256i R3 = H3;
+			__m256i R4 = H4;
+			__m256i R5 = H5;
+			__m256i R6 = H6;
+			__m256i R7 = H7;
+			__m256i R8 = _mm256_set1_epi32(IV[0]);
+			__m256i R9 = _mm256_set1_epi32(IV[1]);
+			__m256i R10 = _mm256_set1_epi32(IV[2]);
+			__m256i R11 = _mm256_set1_epi32(IV[3]);
+			__m256i R12 = _mm256_xor_si256(_mm256_set1_epi32(IV[4]), C0);
+			__m256i R13 = _mm256_xor_si256(_mm256_set1_epi32(IV[5]), C1);
+			__m256i R14 = _mm256_xor_si256(_mm256_set1_epi32(IV[6]), F0);
+			__m256i R15 = _mm256_xor_si256(_mm256_set1_epi32(IV[7]), F1);
+
+			for (size_t i = 0; i < 10; ++i)
+			{
+				const byte* S = SIGMA[i];
+
+				// column step
+				G8W(R0, R4, R8, R12, M[S[0]], M[S[1]]);
+				G8W(R1, R5, R9, R13, M[S[2]], M[S[3]]);
+				G8W(R2, R6, R10, R14, M[S[4]], M[S[5]]);
+				G8W(R3, R7, R11, R15, M[S[6]], M[S[7]]);
+				// diagonal step
+				G8W(R0, R5, R10, R15, M[S[8]], M[S[9]]);
+				G8W(R1, R6, R11, R12, M[S[10]], M[S[11]]);
+				G8W(R2, R7, R8, R13, M[S[12]], M[S[13]]);
+				G8W(R3, R4, R9, R14, M[S[14]], M[S[15]]);
+			}
+
+			H0 = _mm256_xor_si256(H0, _mm256_xor_si256(R0, R8));
+			H1 = _mm256_xor_si256(H1, _mm256_xor_si256(R1, R9));
+			H2 = _mm256_xor_si256(H2, _mm256_xor_si256(R2, R10));
+			H3 = _mm256_xor_si256(H3, _mm256_xor_si256(R3, R11));
+			H4 = _mm256_xor_si256(H4, _mm256_xor_si256(R4, R12));
+			H5 = _mm256_xor_si256(H5, _mm256_xor_si256(R5, R13));
+			H6 = _mm256_xor_si256(H6, _mm256_xor_si256(R6, R14));
+			H7 = _mm256_xor_si256(H7, _mm256_xor_si256(R7, R15));
+		}
+
+		_mm256_storeu_si256((__m256i*)&State.H[0], H0);
+		_mm256_storeu_si256((__m256i*)&State.H[8], H1);
+		_mm256_storeu_si256((__m256i*)&State.H[16], H2);
+		_mm256_storeu_si256((__m256i*)&State.H[24], H3);
+		_mm256_storeu_si256((__m256i*)&State.H[32], H4);
+		_mm256_storeu_si256((__m256i*)&State.H[40], H5);
+		_mm256_storeu_si256((__m256i*)&State.H[48], H6);
+		_mm256_storeu_si256((__m256i*)&State.H[56], H7);
+		_mm256_storeu_si256((__m256i*)&State.T[0], C0);
+		_mm256_storeu_si256((__m256i*)&State.T[8], C1);
+	}
+
 #endif
 };
 
@@ -1,5 +1,4 @@
 #include "Blake512.h"
-#include "Blake512Compress.h"
 #include "ArrayUtils.h"
 #include "CpuDetect.h"
 #include "IntUtils.h"
@@ -19,49 +18,75 @@ static const std::vector<ulong> BCIV = { 0x6A09E667F3BCC908UL, 0xBB67AE8584CAA73
 
 Blake512::Blake512(bool Parallel)
 	:
-	m_cIV(BCIV),
-	m_dgtState(Parallel ? DEF_PRLDEGREE : 1),
+	Blake512(DIGEST_SIZE, Parallel)
+{
+}
+
+Blake512::Blake512(size_t DigestSize, bool Parallel)
+	:
+	m_dgtState(1),
+	m_digestSize(DigestSize),
 	m_isDestroyed(false),
+	m_isKeyedChain(false),
+	m_isParallelSimd(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyedCode(),
+	m_laneInput(0),
+	m_laneState(0),
+	m_leafHashes(0),
 	m_leafSize(Parallel ? DEF_LEAFSIZE : BLOCK_SIZE),
-	m_msgBuffer(Parallel ? 2 * DEF_PRLDEGREE * BLOCK_SIZE : BLOCK_SIZE),
+	m_msgBuffer(BLOCK_SIZE),
 	m_msgLength(0),
 	m_parallelProfile(BLOCK_SIZE, false, STATE_PRECACHED, false, DEF_PRLDEGREE),
-	m_treeConfig(8),
+	m_treeConfig(),
 	m_treeDestroy(true)
 {
-	if (m_parallelProfile.IsParallel())
-		m_parallelProfile.IsParallel() = Parallel;
+	if (DigestSize == 0 || DigestSize > DIGEST_SIZE)
+		throw CryptoDigestException("Blake512:Ctor", "The DigestSize is invalid! Must be between 1 and 64 bytes.");
+
+	// the tree mode selects the digest, and does not depend on the processor count; a single processor hashes the leaves in turn
+	m_parallelProfile.IsParallel() = Parallel;
 
 	if (m_parallelProfile.IsParallel())
 	{
 		// sets defaults of depth 2, fanout 4, 4 threads
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE), 2, DEF_PRLDEGREE, 0, static_cast<byte>(DIGEST_SIZE));
-		// initialize the leaf nodes
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize), 2, DEF_PRLDEGREE, 0, static_cast<byte>(DIGEST_SIZE));
+		// size the tree state to the fanout, and initialize the leaf nodes
+		LoadTree();
 		Reset();
 	}
 	else
 	{
 		// default depth 1, fanout 1, leaf length unlimited
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE));
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize));
 		LoadState(m_dgtState[0]);
 	}
 }
 
 Blake512::Blake512(BlakeParams &Params)
 	:
-	m_cIV(BCIV),
-	m_dgtState(Params.FanOut() > 0 ? Params.FanOut() : 1),
+	m_dgtState(1),
+	m_digestSize(Params.OutputSize()),
 	m_isDestroyed(false),
+	m_isKeyedChain(false),
+	m_isParallelSimd(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyedCode(),
+	m_laneInput(0),
+	m_laneState(0),
+	m_leafHashes(0),
 	m_leafSize(BLOCK_SIZE),
-	m_msgBuffer(Params.FanOut() > 0 ? 2 * Params.FanOut() * BLOCK_SIZE : BLOCK_SIZE),
+	m_msgBuffer(BLOCK_SIZE),
 	m_msgLength(0),
 	m_parallelProfile(BLOCK_SIZE, false, STATE_PRECACHED, false, Params.FanOut()),
-	m_treeConfig(CHAIN_SIZE),
+	m_treeConfig(),
 	m_treeDestroy(false),
 	m_treeParams(Params)
 {
-	if (m_parallelProfile.IsParallel())
-		m_parallelProfile.IsParallel() = m_treeParams.FanOut() > 1;
+	if (m_digestSize == 0 || m_digestSize > DIGEST_SIZE)
+		throw CryptoDigestException("Blake512:Ctor", "The OutputSize parameter is invalid! Must be between 1 and 64 bytes.");
+
+	m_parallelProfile.IsParallel() = m_treeParams.FanOut() > 1;
 
 	if (m_parallelProfile.IsParallel())
 	{
@@ -71,13 +96,14 @@ Blake512::Blake512(BlakeParams &Params)
 			throw CryptoDigestException("BlakeBP512:Ctor", "The FanOut parameter is invalid! Must be an even number greater than 1.");
 
 		m_leafSize = Params.LeafLength() == 0 ? DEF_LEAFSIZE : Params.LeafLength();
-		// initialize leafs
+		// size the tree state to the fanout, and initialize leafs
+		LoadTree();
 		Reset();
 	}
 	else
 	{
 		// fixed at defaults for sequential; depth 1, fanout 1, leaf length unlimited
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE));
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize), 0, 1, 1, 0, 0, 0, 0, Params.DistributionCode());
 		LoadState(m_dgtState[0]);
 	}
 }
@@ -89,25 +115,245 @@ Blake512::~Blake512()
 
 //~~~Public Functions~~~//
 
+Blake512* Blake512::Clone()
+{
+	Blake512* dgt = new Blake512(m_digestSize, m_parallelProfile.IsParallel());
+	dgt->Import(*this);
+
+	return dgt;
+}
+
 void Blake512::Compute(const std::vector<byte> &Input, std::vector<byte> &Output)
 {
 	Update(Input, 0, Input.size());
 	Finalize(Output, 0);
 }
 
+void Blake512::ComputeBatch(const std::vector<std::vector<byte>> &Input, std::vector<std::vector<byte>> &Output)
+{
+	if (m_parallelProfile.IsParallel())
+		throw CryptoDigestException("Blake512:ComputeBatch", "Batch hashing is not available in parallel mode!");
+
+	const size_t MSGCNT = Input.size();
+	// buffered bytes (the key block when keyed) are prepended to every message
+	const size_t PFXLEN = m_msgLength;
+	const size_t LNECNT = m_kernels->Lanes128W;
+	std::vector<size_t> lneBlk(LNECNT, 0);
+	std::vector<byte> lneBuf(LNECNT * BLOCK_SIZE, 0);
+	std::vector<size_t> lneCnt(LNECNT, 0);
+	std::vector<size_t> lneMsg(LNECNT, MSGCNT);
+	std::vector<const byte*> lnePtr(LNECNT);
+	Blake2bWideState wState(LNECNT);
+	size_t actCnt = 0;
+	size_t nxtMsg = 0;
+
+	// an empty message under a keyed template is not compressed; its code was finalized with the key block
+	const std::function<void()> SKIPEMPTY = [&]()
+	{
+		while (m_isKeyedChain && nxtMsg < MSGCNT && Input[nxtMsg].size() == 0)
+		{
+			Output[nxtMsg].assign(m_keyedCode.begin(), m_keyedCode.begin() + m_digestSize);
+			++nxtMsg;
+		}
+	};
+
+	Output.resize(MSGCNT);
+
+	for (size_t i = 0; i < LNECNT; ++i)
+	{
+		lnePtr[i] = &lneBuf[i * BLOCK_SIZE];
+		SKIPEMPTY();
+
+		if (nxtMsg < MSGCNT)
+		{
+			LoadLane(wState, i, Input[nxtMsg].size() + PFXLEN, lneCnt[i]);
+			lneMsg[i] = nxtMsg;
+			lneBlk[i] = 0;
+			++nxtMsg;
+			++actCnt;
+		}
+	}
+
+	while (actCnt != 0)
+	{
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			if (lneMsg[i] == MSGCNT)
+				continue;
+
+			const std::vector<byte> &msg = Input[lneMsg[i]];
+			const size_t MSGLEN = msg.size() + PFXLEN;
+			const size_t BLKPOS = lneBlk[i] * BLOCK_SIZE;
+			const size_t BLKEND = (BLKPOS + BLOCK_SIZE < MSGLEN) ? BLKPOS + BLOCK_SIZE : MSGLEN;
+
+			if (BLKPOS >= PFXLEN && BLKPOS + BLOCK_SIZE <= MSGLEN)
+			{
+				// full block within the message; read it in place
+				lnePtr[i] = &msg[BLKPOS - PFXLEN];
+			}
+			else
+			{
+				// block overlaps the prefix or the message tail; stage a padded copy
+				const size_t MSGPOS = (BLKPOS > PFXLEN) ? BLKPOS : PFXLEN;
+				byte* blk = &lneBuf[i * BLOCK_SIZE];
+
+				memset(blk, 0, BLOCK_SIZE);
+				if (BLKPOS < PFXLEN)
+					memcpy(blk, &m_msgBuffer[BLKPOS], PFXLEN - BLKPOS);
+				if (BLKEND > MSGPOS)
+					memcpy(blk + (MSGPOS - BLKPOS), &msg[MSGPOS - PFXLEN], BLKEND - MSGPOS);
+
+				lnePtr[i] = blk;
+			}
+
+			// set the lane counter and the final block flag
+			wState.T[i] = m_dgtState[0].T[0] + BLKEND;
+			wState.T[LNECNT + i] = m_dgtState[0].T[1] + (wState.T[i] < m_dgtState[0].T[0] ? 1 : 0);
+			wState.F[i] = (lneBlk[i] == lneCnt[i] - 1) ? ULL_MAX : 0;
+		}
+
+		m_kernels->Compress128W(lnePtr, wState, BCIV);
+
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			if (lneMsg[i] == MSGCNT)
+				continue;
+
+			++lneBlk[i];
+
+			if (lneBlk[i] == lneCnt[i])
+			{
+				// lane is finished; output the hash and load the next message
+				std::vector<byte> &otp = Output[lneMsg[i]];
+				otp.resize(m_digestSize);
+
+				// only the bytes of the output size are written
+				for (size_t j = 0; j < m_digestSize; ++j)
+					otp[j] = static_cast<byte>(wState.H[((j / sizeof(ulong)) * LNECNT) + i] >> ((j % sizeof(ulong)) * 8));
+
+				lneMsg[i] = MSGCNT;
+				lnePtr[i] = &lneBuf[i * BLOCK_SIZE];
+				--actCnt;
+				SKIPEMPTY();
+
+				if (nxtMsg < MSGCNT)
+				{
+					LoadLane(wState, i, Input[nxtMsg].size() + PFXLEN, lneCnt[i]);
+					lneMsg[i] = nxtMsg;
+					lneBlk[i] = 0;
+					++nxtMsg;
+					++actCnt;
+				}
+			}
+		}
+	}
+
+	// the staged blocks may hold the key block of a keyed template
+	ArrayUtils::ClearVector(lneBuf);
+	Reset();
+}
+
+void Blake512::DeSerialize(const std::vector<byte> &State)
+{
+	if (State.size() < SERIAL_HEADER)
+		throw CryptoDigestException("Blake512:DeSerialize", "The state is too short!");
+	if (State[0] != SERIAL_VERSION)
+		throw CryptoDigestException("Blake512:DeSerialize", "The state format version is not supported!");
+	if (State[1] != static_cast<byte>(Enumeral()))
+		throw CryptoDigestException("Blake512:DeSerialize", "The state is not a Blake512 state!");
+
+	const bool PRLMODE = (State[2] & 1) != 0;
+	const bool PRLSIMD = (State[2] & 2) != 0;
+	const bool KEYCHAIN = (State[2] & 4) != 0;
+	const size_t STECNT = State[3];
+	const uint LEAFLEN = IntUtils::BytesToLe32(State, 4);
+	const size_t MSGLEN = IntUtils::BytesToLe32(State, 8);
+	size_t stateOff = SERIAL_HEADER;
+
+	// tree parameters; 12 bytes, then the distribution code length and code
+	if (State.size() < stateOff + 13 || State.size() < stateOff + 13 + State[stateOff + 12])
+		throw CryptoDigestException("Blake512:DeSerialize", "The state is too short!");
+
+	std::vector<byte> dstCode(State.begin() + stateOff + 13, State.begin() + stateOff + 13 + State[stateOff + 12]);
+	BlakeParams params(State[stateOff], State[stateOff + 1], State[stateOff + 2], State[stateOff + 3], IntUtils::BytesToLe32(State, stateOff + 4),
+		State[stateOff + 8], State[stateOff + 9], State[stateOff + 10], dstCode);
+	params.Reserved() = State[stateOff + 11];
+	stateOff += 13 + dstCode.size();
+
+	const size_t BUFLEN = PRLMODE ? 2 * params.FanOut() * BLOCK_SIZE : BLOCK_SIZE;
+	const size_t STELEN = (CHAIN_SIZE + COUNTER_SIZE + FLAG_SIZE) * sizeof(ulong);
+
+	if (params.OutputSize() == 0 || params.OutputSize() > DIGEST_SIZE || STECNT != (PRLMODE ? params.FanOut() : 1) || STECNT == 0 || MSGLEN > BUFLEN)
+		throw CryptoDigestException("Blake512:DeSerialize", "The state is malformed!");
+	if (PRLMODE && (params.FanOut() < 2 || params.FanOut() % 2 != 0 || LEAFLEN < BLOCK_SIZE || LEAFLEN % BLOCK_SIZE != 0))
+		throw CryptoDigestException("Blake512:DeSerialize", "The state is malformed!");
+	if (State.size() != stateOff + (CHAIN_SIZE * sizeof(ulong)) + (STECNT * STELEN) + MSGLEN + (KEYCHAIN ? DIGEST_SIZE : 0))
+		throw CryptoDigestException("Blake512:DeSerialize", "The state length is invalid!");
+
+	m_digestSize = params.OutputSize();
+	m_treeParams = params;
+	m_parallelProfile.IsParallel() = PRLMODE;
+	m_isParallelSimd = PRLSIMD;
+	m_leafSize = LEAFLEN;
+
+	if (PRLMODE)
+	{
+		LoadTree();
+	}
+	else
+	{
+		m_msgBuffer.resize(BLOCK_SIZE);
+		if (m_dgtState.size() == 0)
+			m_dgtState.resize(1);
+	}
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+	{
+		m_treeConfig[i] = IntUtils::BytesToLe64(State, stateOff);
+		stateOff += sizeof(ulong);
+	}
+
+	for (size_t i = 0; i < STECNT; ++i)
+	{
+		Blake2bState &dgtState = m_dgtState[i];
+
+		for (size_t j = 0; j < CHAIN_SIZE; ++j, stateOff += sizeof(ulong))
+			dgtState.H[j] = IntUtils::BytesToLe64(State, stateOff);
+		for (size_t j = 0; j < COUNTER_SIZE; ++j, stateOff += sizeof(ulong))
+			dgtState.T[j] = IntUtils::BytesToLe64(State, stateOff);
+		for (size_t j = 0; j < FLAG_SIZE; ++j, stateOff += sizeof(ulong))
+			dgtState.F[j] = IntUtils::BytesToLe64(State, stateOff);
+	}
+
+	memset(&m_msgBuffer[0], 0, m_msgBuffer.size());
+	if (MSGLEN != 0)
+		memcpy(&m_msgBuffer[0], &State[stateOff], MSGLEN);
+	m_msgLength = MSGLEN;
+	stateOff += MSGLEN;
+
+	m_isKeyedChain = KEYCHAIN;
+	m_keyedCode.fill(0);
+	if (KEYCHAIN)
+		memcpy(&m_keyedCode[0], &State[stateOff], DIGEST_SIZE);
+
+	m_isDestroyed = false;
+}
+
 void Blake512::Destroy()
 {
 	if (!m_isDestroyed)
 	{
 		m_isDestroyed = true;
+		m_isKeyedChain = false;
 		m_leafSize = 0;
 		m_msgLength = 0;
 
 		try
 		{
-			ArrayUtils::ClearVector(m_cIV);
+			ArrayUtils::ClearVector(m_leafHashes);
 			ArrayUtils::ClearVector(m_msgBuffer);
-			ArrayUtils::ClearVector(m_treeConfig);
+			m_keyedCode.fill(0);
+			m_treeConfig.fill(0);
 
 			for (size_t i = 0; i < m_dgtState.size(); ++i)
 				m_dgtState[i].Reset();
@@ -122,17 +368,14 @@ void Blake512::Destroy()
 	}
 }
 
-size_t Blake512::Finalize(std::vector<byte> &Output, const size_t OutOffset)
+size_t Blake512::Finalize(byte* Output)
 {
 	if (m_parallelProfile.IsParallel())
 	{
-		std::vector<byte> hashCodes(m_treeParams.FanOut() * DIGEST_SIZE);
-
 		// padding
 		if (m_msgLength < m_msgBuffer.size())
 			memset(&m_msgBuffer[m_msgLength], 0, m_msgBuffer.size() - m_msgLength);
 
-		std::vector<byte> padLen(m_treeParams.FanOut(), BLOCK_SIZE);
 		ulong prtBlk = ULL_MAX;
 
 		// process unaligned blocks
@@ -145,7 +388,7 @@ size_t Blake512::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 			for (size_t i = 0; i < blkCount; ++i)
 			{
 				// process partial block set
-				Compress(m_msgBuffer, (i * BLOCK_SIZE), m_dgtState[i], BLOCK_SIZE);
+				Compress(&m_msgBuffer[(i * BLOCK_SIZE)], m_dgtState[i], BLOCK_SIZE);
 				memcpy(&m_msgBuffer[i * BLOCK_SIZE], &m_msgBuffer[m_parallelProfile.ParallelMinimumSize() + (i * BLOCK_SIZE)], BLOCK_SIZE);
 				m_msgLength -= BLOCK_SIZE;
 			}
@@ -182,10 +425,10 @@ size_t Blake512::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 				memset(&m_msgBuffer[(i * BLOCK_SIZE) + blkLen], 0, BLOCK_SIZE - blkLen);
 			}
 
-			Compress(m_msgBuffer, i * BLOCK_SIZE, m_dgtState[i], blkLen);
+			Compress(&m_msgBuffer[i * BLOCK_SIZE], m_dgtState[i], blkLen);
 			m_msgLength -= BLOCK_SIZE;
 
-			IntUtils::LeULL512ToBlock(m_dgtState[i].H, hashCodes, i * DIGEST_SIZE);
+			IntUtils::LeULL512ToBlock(m_dgtState[i].H, &m_leafHashes[i * DIGEST_SIZE]);
 		}
 
 		// set up the root node
@@ -197,19 +440,24 @@ size_t Blake512::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 
 		// load blocks
 		for (size_t i = 0; i < m_treeParams.FanOut(); ++i)
-			Update(hashCodes, i * DIGEST_SIZE, DIGEST_SIZE);
+			Update(m_leafHashes, i * DIGEST_SIZE, DIGEST_SIZE);
 
 		// compress all but last block
-		for (size_t i = 0; i < hashCodes.size() - BLOCK_SIZE; i += BLOCK_SIZE)
-			Compress(m_msgBuffer, i, m_dgtState[0], BLOCK_SIZE);
+		for (size_t i = 0; i < m_leafHashes.size() - BLOCK_SIZE; i += BLOCK_SIZE)
+			Compress(&m_msgBuffer[i], m_dgtState[0], BLOCK_SIZE);
 
 		// apply f0 and f1 flags
 		m_dgtState[0].F[0] = ULL_MAX;
 		m_dgtState[0].F[1] = ULL_MAX;
 		// last compression
-		Compress(m_msgBuffer, m_msgLength - BLOCK_SIZE, m_dgtState[0], BLOCK_SIZE);
+		Compress(&m_msgBuffer[m_msgLength - BLOCK_SIZE], m_dgtState[0], BLOCK_SIZE);
 		// output the code
-		IntUtils::LeULL512ToBlock(m_dgtState[0].H, Output, 0);
+		IntUtils::LeULL512ToBlock(m_dgtState[0].H, Output, m_digestSize);
+	}
+	else if (m_isKeyedChain && m_msgLength == 0)
+	{
+		// an empty message under a keyed template; the key block was its only block
+		memcpy(Output, &m_keyedCode[0], m_digestSize);
 	}
 	else
 	{
@@ -218,13 +466,65 @@ size_t Blake512::Finalize(std::vector<byte> &Output, const size_t OutOffset)
 			memset(&m_msgBuffer[m_msgLength], 0, padLen);
 
 		m_dgtState[0].F[0] = ULL_MAX;
-		Compress(m_msgBuffer, 0, m_dgtState[0], m_msgLength);
-		IntUtils::LeULL512ToBlock(m_dgtState[0].H, Output, OutOffset);
+		Compress(&m_msgBuffer[0], m_dgtState[0], m_msgLength);
+		IntUtils::LeULL512ToBlock(m_dgtState[0].H, Output, m_digestSize);
 	}
 
 	Reset();
 
-	return DIGEST_SIZE;
+	return m_digestSize;
+}
+
+size_t Blake512::Finalize(std::vector<byte> &Output, const size_t OutOffset)
+{
+	if (Output.size() < OutOffset + m_digestSize)
+		throw CryptoDigestException("Blake512:Finalize", "The Output buffer is too short!");
+
+	return Finalize(&Output[OutOffset]);
+}
+
+void Blake512::GetKeyedState(Blake2bKeyedState &State)
+{
+	if (m_parallelProfile.IsParallel())
+		throw CryptoDigestException("Blake512:GetKeyedState", "The keyed state is not available in parallel mode!");
+	if (m_isKeyedChain || m_msgLength != BLOCK_SIZE || m_dgtState[0].T[0] != 0)
+		throw CryptoDigestException("Blake512:GetKeyedState", "The digest must hold exactly one buffered block; a key, or a single block of message data!");
+
+	// the key block is buffered; chain it for messages with data, and finalize it for the empty message
+	State.Chain = m_dgtState[0];
+	Compress(&m_msgBuffer[0], State.Chain, BLOCK_SIZE);
+
+	Blake2bState empty = m_dgtState[0];
+	empty.F[0] = ULL_MAX;
+	Compress(&m_msgBuffer[0], empty, BLOCK_SIZE);
+	IntUtils::LeULL512ToBlock(empty.H, State.EmptyCode);
+
+	State.IsKeyed = true;
+}
+
+void Blake512::Import(const Blake512 &Source)
+{
+	if (&Source == this)
+		return;
+
+	m_dgtState = Source.m_dgtState;
+	m_digestSize = Source.m_digestSize;
+	m_isDestroyed = Source.m_isDestroyed;
+	m_isKeyedChain = Source.m_isKeyedChain;
+	m_isParallelSimd = Source.m_isParallelSimd;
+	m_kernels = Source.m_kernels;
+	m_keyedCode = Source.m_keyedCode;
+	m_leafSize = Source.m_leafSize;
+	m_msgBuffer = Source.m_msgBuffer;
+	m_msgLength = Source.m_msgLength;
+	m_parallelProfile = Source.m_parallelProfile;
+	m_treeConfig = Source.m_treeConfig;
+	m_treeDestroy = Source.m_treeDestroy;
+	m_treeParams = Source.m_treeParams;
+
+	// the working buffers are not copied; they are sized to the tree
+	if (m_parallelProfile.IsParallel())
+		LoadTree();
 }
 
 void Blake512::Initialize(Key::Symmetric::ISymmetricKey &MacKey)
@@ -232,23 +532,25 @@ void Blake512::Initialize(Key::Symmetric::ISymmetricKey &MacKey)
 	if (MacKey.Key().size() < 32 || MacKey.Key().size() > 64)
 		throw Exception::CryptoDigestException("Blake512", "Mac Key has invalid length!");
 
-	if (MacKey.Nonce().size() != 0)
-	{
-		if (MacKey.Nonce().size() != 16)
-			throw Exception::CryptoDigestException("Blake512", "Salt has invalid length!");
+	if (MacKey.Nonce().size() != 0 && MacKey.Nonce().size() != 16)
+		throw Exception::CryptoDigestException("Blake512", "Salt has invalid length!");
+	if (MacKey.Info().size() != 0 && MacKey.Info().size() != 16)
+		throw Exception::CryptoDigestException("Blake512", "Info has invalid length!");
 
-		m_treeConfig[4] = IntUtils::BytesToLe64(MacKey.Nonce(), 0);
-		m_treeConfig[5] = IntUtils::BytesToLe64(MacKey.Nonce(), 8);
-	}
+	// the salt and personalization are parameter block words 4 to 7; they are held in the distribution code,
+	// so that they are loaded with the rest of the parameter block on every Reset
+	std::vector<byte> &dstCode = m_treeParams.DistributionCode();
 
-	if (MacKey.Info().size() != 0)
-	{
-		if (MacKey.Info().size() != 16)
-			throw Exception::CryptoDigestException("Blake512", "Info has invalid length!");
+	if (dstCode.size() < DSTCODE_SIZE)
+		dstCode.resize(DSTCODE_SIZE, 0);
 
-		m_treeConfig[6] = IntUtils::BytesToLe64(MacKey.Info(), 0);
-		m_treeConfig[7] = IntUtils::BytesToLe64(MacKey.Info(), 8);
-	}
+	// each key sets its own salt and personalization; those of a previous key are cleared, and an absent value is all zeroes
+	memset(&dstCode[8], 0, 32);
+
+	if (MacKey.Nonce().size() != 0)
+		memcpy(&dstCode[8], &MacKey.Nonce()[0], 16);
+	if (MacKey.Info().size() != 0)
+		memcpy(&dstCode[24], &MacKey.Info()[0], 16);
 
 	std::vector<byte> mkey(BLOCK_SIZE, 0);
 	memcpy(&mkey[0], &MacKey.Key()[0], MacKey.Key().size());
@@ -274,6 +576,19 @@ void Blake512::Initialize(Key::Symmetric::ISymmetricKey &MacKey)
 	}
 }
 
+void Blake512::LoadKeyedState(const Blake2bKeyedState &State)
+{
+	if (m_parallelProfile.IsParallel())
+		throw CryptoDigestException("Blake512:LoadKeyedState", "The keyed state is not available in parallel mode!");
+	if (!State.IsKeyed)
+		throw CryptoDigestException("Blake512:LoadKeyedState", "The keyed state has not been created!");
+
+	m_dgtState[0] = State.Chain;
+	memcpy(&m_keyedCode[0], State.EmptyCode, DIGEST_SIZE);
+	m_msgLength = 0;
+	m_isKeyedChain = true;
+}
+
 void Blake512::ParallelMaxDegree(size_t Degree)
 {
 	if (Degree == 0)
@@ -283,29 +598,51 @@ void Blake512::ParallelMaxDegree(size_t Degree)
 	if (Degree % 2 != 0)
 		throw CryptoDigestException("Blake512:ParallelMaxDegree", "Parallel degree must be an even number!");
 
-	if (Degree > 1 && m_parallelProfile.ProcessorCount() > 1)
+	if (Degree > 1)
 	{
 		m_treeParams.FanOut() = static_cast<byte>(Degree);
 		m_treeParams.MaxDepth() = 2;
 		m_treeParams.InnerLength() = static_cast<byte>(DIGEST_SIZE);
 		m_parallelProfile.IsParallel() = true;
+		LoadTree();
 	}
 	else
 	{
-		m_treeParams = BlakeParams(static_cast<byte>(DIGEST_SIZE));
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize));
 		m_parallelProfile.IsParallel() = false;
+		m_isParallelSimd = false;
+	}
+
+	Reset();
+}
+
+void Blake512::ParallelSimd(bool Enable)
+{
+	if (Enable && !m_parallelProfile.IsParallel())
+	{
+		// no tree is configured; use the Blake2bp defaults of depth 2, fanout 4
+		m_treeParams = BlakeParams(static_cast<byte>(m_digestSize), 2, DEF_PRLDEGREE, 0, static_cast<byte>(DIGEST_SIZE));
+		m_parallelProfile.IsParallel() = true;
 	}
 
+	if (Enable)
+		LoadTree();
+
+	m_isParallelSimd = Enable;
 	Reset();
 }
 
 void Blake512::Reset()
 {
+	m_isKeyedChain = false;
 	m_msgLength = 0;
 	memset(&m_msgBuffer[0], 0, m_msgBuffer.size());
 
 	if (m_parallelProfile.IsParallel())
 	{
+		// the leaf depth; Finalize leaves the root depth in the tree parameters
+		m_treeParams.NodeDepth() = 0;
+
 		for (size_t i = 0; i < m_treeParams.FanOut(); ++i)
 		{
 			m_treeParams.NodeOffset() = static_cast<byte>(i);
@@ -319,13 +656,64 @@ void Blake512::Reset()
 	}
 }
 
+std::vector<byte> Blake512::Serialize()
+{
+	const size_t STECNT = m_parallelProfile.IsParallel() ? m_treeParams.FanOut() : 1;
+	const size_t STELEN = (CHAIN_SIZE + COUNTER_SIZE + FLAG_SIZE) * sizeof(ulong);
+	const size_t PRMLEN = 13 + m_treeParams.DistributionCode().size();
+	std::vector<byte> state(SERIAL_HEADER + PRMLEN + (CHAIN_SIZE * sizeof(ulong)) + (STECNT * STELEN) + m_msgLength + (m_isKeyedChain ? DIGEST_SIZE : 0));
+	size_t stateOff = SERIAL_HEADER;
+
+	state[0] = SERIAL_VERSION;
+	state[1] = static_cast<byte>(Enumeral());
+	state[2] = static_cast<byte>((m_parallelProfile.IsParallel() ? 1 : 0) | (m_isParallelSimd ? 2 : 0) | (m_isKeyedChain ? 4 : 0));
+	state[3] = static_cast<byte>(STECNT);
+	IntUtils::Le32ToBytes(m_leafSize, state, 4);
+	IntUtils::Le32ToBytes(static_cast<uint>(m_msgLength), state, 8);
+
+	state[stateOff] = m_treeParams.OutputSize();
+	state[stateOff + 1] = m_treeParams.KeyLength();
+	state[stateOff + 2] = m_treeParams.FanOut();
+	state[stateOff + 3] = m_treeParams.MaxDepth();
+	IntUtils::Le32ToBytes(m_treeParams.LeafLength(), state, stateOff + 4);
+	state[stateOff + 8] = m_treeParams.NodeOffset();
+	state[stateOff + 9] = m_treeParams.NodeDepth();
+	state[stateOff + 10] = m_treeParams.InnerLength();
+	state[stateOff + 11] = m_treeParams.Reserved();
+	state[stateOff + 12] = static_cast<byte>(m_treeParams.DistributionCode().size());
+	if (m_treeParams.DistributionCode().size() != 0)
+		memcpy(&state[stateOff + 13], &m_treeParams.DistributionCode()[0], m_treeParams.DistributionCode().size());
+	stateOff += PRMLEN;
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i, stateOff += sizeof(ulong))
+		IntUtils::Le64ToBytes(m_treeConfig[i], state, stateOff);
+
+	for (size_t i = 0; i < STECNT; ++i)
+	{
+		for (size_t j = 0; j < CHAIN_SIZE; ++j, stateOff += sizeof(ulong))
+			IntUtils::Le64ToBytes(m_dgtState[i].H[j], state, stateOff);
+		for (size_t j = 0; j < COUNTER_SIZE; ++j, stateOff += sizeof(ulong))
+			IntUtils::Le64ToBytes(m_dgtState[i].T[j], state, stateOff);
+		for (size_t j = 0; j < FLAG_SIZE; ++j, stateOff += sizeof(ulong))
+			IntUtils::Le64ToBytes(m_dgtState[i].F[j], state, stateOff);
+	}
+
+	if (m_msgLength != 0)
+		memcpy(&state[stateOff], &m_msgBuffer[0], m_msgLength);
+	stateOff += m_msgLength;
+
+	if (m_isKeyedChain)
+		memcpy(&state[stateOff], &m_keyedCode[0], DIGEST_SIZE);
+
+	return state;
+}
+
 void Blake512::Update(byte Input)
 {
-	std::vector<byte> inp(1, Input);
-	Update(inp, 0, 1);
+	Update(&Input, 1);
 }
 
-void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length)
+void Blake512::Update(const byte* Input, size_t Length)
 {
 	if (Length == 0)
 		return;
@@ -341,19 +729,26 @@ void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 			// fill buffer
 			size_t rmd = m_msgBuffer.size() - m_msgLength;
 			if (rmd != 0)
-				memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], rmd);
+				memcpy(&m_msgBuffer[m_msgLength], Input, rmd);
 
 			m_msgLength = 0;
 			Length -= rmd;
-			InOffset += rmd;
+			Input += rmd;
 			ttlLen -= m_msgBuffer.size();
 
 			// empty the message buffer
-			Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, &Input, InOffset](size_t i)
+			if (m_isParallelSimd)
+			{
+				ProcessLeaves(&m_msgBuffer[0], m_msgBuffer.size());
+			}
+			else
 			{
-				Compress(m_msgBuffer, i * BLOCK_SIZE, m_dgtState[i], BLOCK_SIZE);
-				Compress(m_msgBuffer, (i * BLOCK_SIZE) + (m_treeParams.FanOut() * BLOCK_SIZE), m_dgtState[i], BLOCK_SIZE);
-			});
+				Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this](size_t i)
+				{
+					Compress(&m_msgBuffer[i * BLOCK_SIZE], m_dgtState[i], BLOCK_SIZE);
+					Compress(&m_msgBuffer[(i * BLOCK_SIZE) + (m_treeParams.FanOut() * BLOCK_SIZE)], m_dgtState[i], BLOCK_SIZE);
+				});
+			}
 
 			// loop in the remainder (no buffering)
 			if (Length > PRLMIN)
@@ -364,13 +759,20 @@ void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 					prcLen -= (prcLen % m_parallelProfile.ParallelMinimumSize());
 
 				// process large blocks
-				Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, &Input, InOffset, prcLen](size_t i)
+				if (m_isParallelSimd)
 				{
-					ProcessLeaf(Input, InOffset + (i * BLOCK_SIZE), m_dgtState[i], prcLen);
-				});
+					ProcessLeaves(Input, prcLen);
+				}
+				else
+				{
+					Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, Input, prcLen](size_t i)
+					{
+						ProcessLeaf(Input + (i * BLOCK_SIZE), m_dgtState[i], prcLen);
+					});
+				}
 
 				Length -= prcLen;
-				InOffset += prcLen;
+				Input += prcLen;
 				ttlLen -= prcLen;
 			}
 		}
@@ -381,17 +783,24 @@ void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 			// fill buffer
 			size_t rmd = m_msgBuffer.size() - m_msgLength;
 			if (rmd != 0)
-				memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], rmd);
+				memcpy(&m_msgBuffer[m_msgLength], Input, rmd);
 
 			Length -= rmd;
-			InOffset += rmd;
+			Input += rmd;
 			m_msgLength = m_msgBuffer.size();
 
 			// process first half of buffer
-			Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this, &Input, InOffset](size_t i)
+			if (m_isParallelSimd)
 			{
-				Compress(m_msgBuffer, i * BLOCK_SIZE, m_dgtState[i], BLOCK_SIZE);
-			});
+				ProcessLeaves(&m_msgBuffer[0], m_msgBuffer.size() / 2);
+			}
+			else
+			{
+				Utility::ParallelUtils::ParallelFor(0, m_treeParams.FanOut(), [this](size_t i)
+				{
+					Compress(&m_msgBuffer[i * BLOCK_SIZE], m_dgtState[i], BLOCK_SIZE);
+				});
+			}
 
 			// left rotate the buffer
 			m_msgLength -= m_parallelProfile.ParallelMinimumSize();
@@ -405,19 +814,19 @@ void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 		{
 			size_t rmd = BLOCK_SIZE - m_msgLength;
 			if (rmd != 0)
-				memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], rmd);
+				memcpy(&m_msgBuffer[m_msgLength], Input, rmd);
 
-			Compress(m_msgBuffer, 0, m_dgtState[0], BLOCK_SIZE);
+			Compress(&m_msgBuffer[0], m_dgtState[0], BLOCK_SIZE);
 			m_msgLength = 0;
-			InOffset += rmd;
+			Input += rmd;
 			Length -= rmd;
 		}
 
 		// loop until last block
 		while (Length > BLOCK_SIZE)
 		{
-			Compress(Input, InOffset, m_dgtState[0], BLOCK_SIZE);
-			InOffset += BLOCK_SIZE;
+			Compress(Input, m_dgtState[0], BLOCK_SIZE);
+			Input += BLOCK_SIZE;
 			Length -= BLOCK_SIZE;
 		}
 	}
@@ -425,38 +834,141 @@ void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Le
 	// store unaligned bytes
 	if (Length != 0)
 	{
-		memcpy(&m_msgBuffer[m_msgLength], &Input[InOffset], Length);
+		memcpy(&m_msgBuffer[m_msgLength], Input, Length);
 		m_msgLength += Length;
 	}
 }
 
+void Blake512::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length)
+{
+	if (Length == 0)
+		return;
+
+	Update(&Input[InOffset], Length);
+}
+
 //~~~Private Functions~~~//
 
-void Blake512::Compress(const std::vector<byte> &Input, size_t InOffset, Blake2bState &State, size_t Length)
+void Blake512::Compress(const byte* Input, Blake2bState &State, size_t Length)
 {
-	ArrayUtils::IncreaseLE64(State.T, State.T, Length);
-	Blake512Compress::Compress128(Input, InOffset, State, m_cIV);
+	ArrayUtils::IncreaseLE64(State.T, Length);
+	m_kernels->Compress128(Input, State, BCIV);
 }
 
-void Blake512::LoadState(Blake2bState &State)
+void Blake512::LoadLane(Blake2bWideState &State, size_t Lane, size_t Length, size_t &BlockCount)
 {
-	memset(&State.T[0], 0, COUNTER_SIZE * sizeof(ulong));
-	memset(&State.F[0], 0, FLAG_SIZE * sizeof(ulong));
-	memcpy(&State.H[0], &m_cIV[0], CHAIN_SIZE * sizeof(ulong));
+	// the lane starts from the current sequential state
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+		State.H[(i * State.Lanes) + Lane] = m_dgtState[0].H[i];
+
+	State.F[State.Lanes + Lane] = 0;
+	// an empty message is still compressed as one zero block
+	BlockCount = (Length == 0) ? 1 : (Length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
 
+void Blake512::LoadTree()
+{
+	// the only place the tree state is sized; called by every path that enables parallel mode.
+	// the leaf blocks are interleaved FanOut blocks apart, independent of the processor count
+	m_parallelProfile.SetMaxDegree(m_treeParams.FanOut());
+
+	if (m_dgtState.size() < m_treeParams.FanOut())
+		m_dgtState.resize(m_treeParams.FanOut());
+
+	m_msgBuffer.resize(2 * m_treeParams.FanOut() * BLOCK_SIZE);
+	m_leafHashes.resize(m_treeParams.FanOut() * DIGEST_SIZE);
+
+	// the multi-buffer lane state is sized here rather than on every update;
+	// a tree narrower than the widest kernel uses the four lane kernel, rather than idle lanes
+	const size_t LNECNT = (m_treeParams.FanOut() < m_kernels->Lanes128W) ? 4 : m_kernels->Lanes128W;
+
+	if (m_laneState.Lanes != LNECNT)
+	{
+		m_laneInput.resize(LNECNT);
+		m_laneState = Blake2bWideState(LNECNT);
+	}
+}
+
+void Blake512::LoadState(Blake2bState &State)
+{
+	State.Reset();
+	// the code size follows the digest type; parameters built for a 32 byte output have the same Blake2b layout
+	m_treeParams.DistributionCode().resize(DSTCODE_SIZE, 0);
 	m_treeParams.GetConfig<ulong>(m_treeConfig);
-	IntUtils::XORULL512(m_treeConfig, 0, State.H, 0);
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+		State.H[i] = BCIV[i] ^ m_treeConfig[i];
 }
 
-void Blake512::ProcessLeaf(const std::vector<byte> &Input, size_t InOffset, Blake2bState &State, ulong Length)
+void Blake512::ProcessLeaf(const byte* Input, Blake2bState &State, ulong Length)
 {
 	do
 	{
-		Compress(Input, InOffset, State, BLOCK_SIZE);
-		InOffset += m_parallelProfile.ParallelMinimumSize();
+		Compress(Input, State, BLOCK_SIZE);
+		Input += m_parallelProfile.ParallelMinimumSize();
 		Length -= m_parallelProfile.ParallelMinimumSize();
 	}
 	while (Length > 0);
 }
 
+void Blake512::ProcessLeaves(const byte* Input, size_t Length)
+{
+	// idle lanes of a partial group compress a zero block, their output is discarded
+	static const byte ZEROBLK[BLOCK_SIZE] = { 0 };
+	const size_t FNOUT = m_treeParams.FanOut();
+	// the lane state is sized by LoadTree; a tree narrower than the widest kernel uses the four lane kernel
+	const size_t LNECNT = m_laneState.Lanes;
+	const BlakeDispatch::Compress128WFn COMPRESS = (LNECNT == m_kernels->Lanes128W) ? m_kernels->Compress128W : m_kernels->Compress128W4;
+	const size_t STRIDE = FNOUT * BLOCK_SIZE;
+	const size_t BLKCNT = Length / STRIDE;
+	std::vector<const byte*> &lnePtr = m_laneInput;
+	Blake2bWideState &wState = m_laneState;
+
+	// leaf i is lane (i % LNECNT) of group (i / LNECNT); every leaf in a group is compressed in one kernel call
+	for (size_t i = 0; i < FNOUT; i += LNECNT)
+	{
+		const size_t GRPLEN = (FNOUT - i < LNECNT) ? FNOUT - i : LNECNT;
+
+		for (size_t j = GRPLEN; j < LNECNT; ++j)
+			lnePtr[j] = ZEROBLK;
+
+		for (size_t j = 0; j < GRPLEN; ++j)
+		{
+			const Blake2bState &leaf = m_dgtState[i + j];
+
+			for (size_t k = 0; k < CHAIN_SIZE; ++k)
+				wState.H[(k * LNECNT) + j] = leaf.H[k];
+
+			wState.T[j] = leaf.T[0];
+			wState.T[LNECNT + j] = leaf.T[1];
+			wState.F[j] = leaf.F[0];
+			wState.F[LNECNT + j] = leaf.F[1];
+		}
+
+		for (size_t j = 0; j < BLKCNT; ++j)
+		{
+			for (size_t k = 0; k < GRPLEN; ++k)
+			{
+				lnePtr[k] = Input + (j * STRIDE) + ((i + k) * BLOCK_SIZE);
+				wState.T[k] += BLOCK_SIZE;
+				if (wState.T[k] < BLOCK_SIZE)
+					++wState.T[LNECNT + k];
+			}
+
+			COMPRESS(lnePtr, wState, BCIV);
+		}
+
+		for (size_t j = 0; j < GRPLEN; ++j)
+		{
+			Blake2bState &leaf = m_dgtState[i + j];
+
+			for (size_t k = 0; k < CHAIN_SIZE; ++k)
+				leaf.H[k] = wState.H[(k * LNECNT) + j];
+
+			leaf.T[0] = wState.T[j];
+			leaf.T[1] = wState.T[LNECNT + j];
+		}
+	}
+}
+
 NAMESPACE_DIGESTEND
\ No newline at end of file
@@ -31,7 +31,7 @@ class Blake512Compress
 {
 private:
 
-#if defined(__AVX__)
+#if defined(CEX_TARGET_DISPATCH)
 #	define _mm_roti_epi64(x, c) \
 		(-(c) == 32) ? _mm_shuffle_epi32((x), _MM_SHUFFLE(2,3,0,1))  \
 		: (-(c) == 24) ? _mm_shuffle_epi8((x), R24) \
@@ -68,22 +68,75 @@ private:
 		T1 = _mm_alignr_epi8(RH4, RL4, 8); \
 		RL4 = T1; \
 		RH4 = T0;
+
+#	define _mm256_roti_epi64(x, c) \
+		(-(c) == 32) ? _mm256_shuffle_epi32((x), _MM_SHUFFLE(2,3,0,1))  \
+		: (-(c) == 24) ? _mm256_shuffle_epi8((x), R24W) \
+		: (-(c) == 16) ? _mm256_shuffle_epi8((x), R16W) \
+		: (-(c) == 63) ? _mm256_xor_si256(_mm256_srli_epi64((x), -(c)), _mm256_add_epi64((x), (x)))  \
+		: _mm256_xor_si256(_mm256_srli_epi64((x), -(c)), _mm256_slli_epi64((x), 64-(-(c))))
+
+#	define G4W(A, B, C, D, X, Y) \
+		A = _mm256_add_epi64(_mm256_add_epi64(A, X), B); \
+		D = _mm256_roti_epi64(_mm256_xor_si256(D, A), -32); \
+		C = _mm256_add_epi64(C, D); \
+		B = _mm256_roti_epi64(_mm256_xor_si256(B, C), -24); \
+		A = _mm256_add_epi64(_mm256_add_epi64(A, Y), B); \
+		D = _mm256_roti_epi64(_mm256_xor_si256(D, A), -16); \
+		C = _mm256_add_epi64(C, D); \
+		B = _mm256_roti_epi64(_mm256_xor_si256(B, C), -63);
+
+	// transposes one 32 byte row of four lane blocks into four message word vectors
+#	define TRANSPOSE4W(P0, P1, P2, P3, W0, W1, W2, W3) \
+		T0 = _mm256_unpacklo_epi64(P0, P1); \
+		T1 = _mm256_unpackhi_epi64(P0, P1); \
+		T2 = _mm256_unpacklo_epi64(P2, P3); \
+		T3 = _mm256_unpackhi_epi64(P2, P3); \
+		W0 = _mm256_permute2x128_si256(T0, T2, 0x20); \
+		W1 = _mm256_permute2x128_si256(T1, T3, 0x20); \
+		W2 = _mm256_permute2x128_si256(T0, T2, 0x31); \
+		W3 = _mm256_permute2x128_si256(T1, T3, 0x31);
+
+#	define G4R(A, B, C, D, X, Y) \
+		A = _mm256_add_epi64(_mm256_add_epi64(A, X), B); \
+		D = _mm256_ror_epi64(_mm256_xor_si256(D, A), 32); \
+		C = _mm256_add_epi64(C, D); \
+		B = _mm256_ror_epi64(_mm256_xor_si256(B, C), 24); \
+		A = _mm256_add_epi64(_mm256_add_epi64(A, Y), B); \
+		D = _mm256_ror_epi64(_mm256_xor_si256(D, A), 16); \
+		C = _mm256_add_epi64(C, D); \
+		B = _mm256_ror_epi64(_mm256_xor_si256(B, C), 63);
+
+#	define G8Z(A, B, C, D, X, Y) \
+		A = _mm512_add_epi64(_mm512_add_epi64(A, X), B); \
+		D = _mm512_ror_epi64(_mm512_xor_si512(D, A), 32); \
+		C = _mm512_add_epi64(C, D); \
+		B = _mm512_ror_epi64(_mm512_xor_si512(B, C), 24); \
+		A = _mm512_add_epi64(_mm512_add_epi64(A, Y), B); \
+		D = _mm512_ror_epi64(_mm512_xor_si512(D, A), 16); \
+		C = _mm512_add_epi64(C, D); \
+		B = _mm512_ror_epi64(_mm512_xor_si512(B, C), 63);
 #endif
 
 public:
 
-#if defined(__AVX__)
+#if defined(CEX_TARGET_DISPATCH)
+
+	/// <summary>
+	/// Compress a message block using SSSE3 and SSE4.1 intrinsics.
+	/// <para>Compiled with a function level target; the caller must check for SSE4.1 support at runtime.</para>
+	/// </summary>
 	template <typename T>
-	static void Compress128(const std::vector<byte> &Input, size_t InOffset, T &State, const std::vector<ulong> &IV)
+	CEX_TARGET_SSE41 static void Compress128Sse41(const byte* Input, T &State, const std::vector<ulong> &IV)
 	{
-		const __m128i M0 = _mm_loadu_si128((const __m128i*)&Input[InOffset]);
-		const __m128i M1 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 16]);
-		const __m128i M2 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 32]);
-		const __m128i M3 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 48]);
-		const __m128i M4 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 64]);
-		const __m128i M5 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 80]);
-		const __m128i M6 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 96]);
-		const __m128i M7 = _mm_loadu_si128((const __m128i*)&Input[InOffset + 112]);
+		const __m128i M0 = _mm_loadu_si128((const __m128i*)Input);
+		const __m128i M1 = _mm_loadu_si128((const __m128i*)(Input + 16));
+		const __m128i M2 = _mm_loadu_si128((const __m128i*)(Input + 32));
+		const __m128i M3 = _mm_loadu_si128((const __m128i*)(Input + 48));
+		const __m128i M4 = _mm_loadu_si128((const __m128i*)(Input + 64));
+		const __m128i M5 = _mm_loadu_si128((const __m128i*)(Input + 80));
+		const __m128i M6 = _mm_loadu_si128((const __m128i*)(Input + 96));
+		const __m128i M7 = _mm_loadu_si128((const __m128i*)(Input + 112));
 		const __m128i R16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
 		const __m128i R24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
 
@@ -895,13 +948,13 @@ public:
 		_mm_storeu_si128((__m128i*)&State.H[6], _mm_xor_si128(_mm_loadu_si128((const __m128i*)&State.H[6]), RH2));
 	}
 
-#else
+#endif
 
 	template <typename T>
-	static void Compress128(const std::vector<byte> &Input, size_t InOffset, T &State, const std::vector<ulong> &IV)
+	static void Compress128(const byte* Input, T &State, const std::vector<ulong> &IV)
 	{
-		std::vector<ulong> M(16);
-		Utility::IntUtils::BytesToLeULL1024(Input, InOffset, M, 0);
+		ulong M[16];
+		Utility::IntUtils::BytesToLeULL1024(Input, M);
 
 		ulong R0 = State.H[0];
 		ulong R1 = State.H[1];
@@ -2189,6 +2242,251 @@ public:
 		State.H[6] ^= R6 ^ R14;
 		State.H[7] ^= R7 ^ R15;
 	}
+
+#if defined(CEX_TARGET_DISPATCH)
+
+	/// <summary>
+	/// Compress four independent message blocks using AVX2, one per state lane.
+	/// <para>The wide state is stored transposed; word j of lane i is at H[(j * 4) + i], T[i] and T[4 + i] hold the lane counter, F[i] and F[4 + i] the lane flags.
+	/// Compiled with a function level target; the caller must check for AVX2 support at runtime.</para>
+	/// </summary>
+	template <typename T>
+	CEX_TARGET_AVX2 static void Compress128WAvx2(const byte* const* Input, T &State, const ulong* IV)
+	{
+		static const byte SIGMA[10][16] =
+		{
+			{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+			{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+			{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+			{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+			{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+			{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+			{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+			{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+			{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 }
+		};
+
+		const __m256i R16W = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+		const __m256i R24W = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+		__m256i M[16];
+		__m256i T0, T1, T2, T3;
+
+		// load and transpose the four message blocks
+		for (size_t i = 0; i < 4; ++i)
+		{
+			TRANSPOSE4W(
+				_mm256_loadu_si256((const __m256i*)(Input[0] + (i * 32))),
+				_mm256_loadu_si256((const __m256i*)(Input[1] + (i * 32))),
+				_mm256_loadu_si256((const __m256i*)(Input[2] + (i * 32))),
+				_mm256_loadu_si256((const __m256i*)(Input[3] + (i * 32))),
+				M[i * 4], M[(i * 4) + 1], M[(i * 4) + 2], M[(i * 4) + 3]);
+		}
+
+		__m256i R0 = _mm256_loadu_si256((const __m256i*)&State.H[0]);
+		__m256i R1 = _mm256_loadu_si256((const __m256i*)&State.H[4]);
+		__m256i R2 = _mm256_loadu_si256((const __m256i*)&State.H[8]);
+		__m256i R3 = _mm256_loadu_si256((const __m256i*)&State.H[12]);
+		__m256i R4 = _mm256_loadu_si256((const __m256i*)&State.H[16]);
+		__m256i R5 = _mm256_loadu_si256((const __m256i*)&State.H[20]);
+		__m256i R6 = _mm256_loadu_si256((const __m256i*)&State.H[24]);
+		__m256i R7 = _mm256_loadu_si256((const __m256i*)&State.H[28]);
+		__m256i R8 = _mm256_set1_epi64x(IV[0]);
+		__m256i R9 = _mm256_set1_epi64x(IV[1]);
+		__m256i R10 = _mm256_set1_epi64x(IV[2]);
+		__m256i R11 = _mm256_set1_epi64x(IV[3]);
+		__m256i R12 = _mm256_xor_si256(_mm256_set1_epi64x(IV[4]), _mm256_loadu_si256((const __m256i*)&State.T[0]));
+		__m256i R13 = _mm256_xor_si256(_mm256_set1_epi64x(IV[5]), _mm256_loadu_si256((const __m256i*)&State.T[4]));
+		__m256i R14 = _mm256_xor_si256(_mm256_set1_epi64x(IV[6]), _mm256_loadu_si256((const __m256i*)&State.F[0]));
+		__m256i R15 = _mm256_xor_si256(_mm256_set1_epi64x(IV[7]), _mm256_loadu_si256((const __m256i*)&State.F[4]));
+
+		for (size_t i = 0; i < 12; ++i)
+		{
+			const byte* S = SIGMA[i % 10];
+
+			// column step
+			G4W(R0, R4, R8, R12, M[S[0]], M[S[1]]);
+			G4W(R1, R5, R9, R13, M[S[2]], M[S[3]]);
+			G4W(R2, R6, R10, R14, M[S[4]], M[S[5]]);
+			G4W(R3, R7, R11, R15, M[S[6]], M[S[7]]);
+			// diagonal step
+			G4W(R0, R5, R10, R15, M[S[8]], M[S[9]]);
+			G4W(R1, R6, R11, R12, M[S[10]], M[S[11]]);
+			G4W(R2, R7, R8, R13, M[S[12]], M[S[13]]);
+			G4W(R3, R4, R9, R14, M[S[14]], M[S[15]]);
+		}
+
+		_mm256_storeu_si256((__m256i*)&State.H[0], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[0]), _mm256_xor_si256(R0, R8)));
+		_mm256_storeu_si256((__m256i*)&State.H[4], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[4]), _mm256_xor_si256(R1, R9)));
+		_mm256_storeu_si256((__m256i*)&State.H[8], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[8]), _mm256_xor_si256(R2, R10)));
+		_mm256_storeu_si256((__m256i*)&State.H[12], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[12]), _mm256_xor_si256(R3, R11)));
+		_mm256_storeu_si256((__m256i*)&State.H[16], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[16]), _mm256_xor_si256(R4, R12)));
+		_mm256_storeu_si256((__m256i*)&State.H[20], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[20]), _mm256_xor_si256(R5, R13)));
+		_mm256_storeu_si256((__m256i*)&State.H[24], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[24]), _mm256_xor_si256(R6, R14)));
+		_mm256_storeu_si256((__m256i*)&State.H[28], _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&State.H[28]), _mm256_xor_si256(R7, R15)));
+	}
+
+#endif
+
+#if defined(CEX_AVX512_AVAILABLE)
+
+	/// <summary>
+	/// Compress a message block using AVX512F/VL; the state rows are held in 256 bit registers and rotated with native 64 bit rotates.
+	/// <para>Compiled with a function level target; the caller must check for AVX512F and AVX512VL support at runtime.</para>
+	/// </summary>
+	template <typename T>
+	CEX_TARGET_AVX512 static void Compress128Avx512(const byte* Input, T &State, const ulong* IV)
+	{
+		// sigma permuted for the row layout; the x and y words of the column step, followed by those of the diagonal step
+		static const ulong SIGMA[10][16] =
+		{
+			{ 0, 2, 4, 6, 1, 3, 5, 7, 8, 10, 12, 14, 9, 11, 13, 15 },
+			{ 14, 4, 9, 13, 10, 8, 15, 6, 1, 0, 11, 5, 12, 2, 7, 3 },
+			{ 11, 12, 5, 15, 8, 0, 2, 13, 10, 3, 7, 9, 14, 6, 1, 4 },
+			{ 7, 3, 13, 11, 9, 1, 12, 14, 2, 5, 4, 15, 6, 10, 0, 8 },
+			{ 9, 5, 2, 10, 0, 7, 4, 15, 14, 11, 6, 3, 1, 12, 8, 13 },
+			{ 2, 6, 0, 8, 12, 10, 11, 3, 4, 7, 15, 1, 13, 5, 14, 9 },
+			{ 12, 1, 14, 4, 5, 15, 13, 10, 0, 6, 9, 8, 7, 3, 2, 11 },
+			{ 13, 7, 12, 3, 11, 14, 1, 9, 5, 15, 8, 2, 0, 4, 6, 10 },
+			{ 6, 14, 11, 0, 15, 9, 3, 8, 12, 13, 1, 10, 2, 7, 4, 5 },
+			{ 10, 8, 7, 1, 2, 4, 6, 5, 15, 9, 3, 13, 11, 14, 12, 0 }
+		};
+
+		const __m512i ML = _mm512_loadu_si512((const void*)Input);
+		const __m512i MH = _mm512_loadu_si512((const void*)(Input + 64));
+		__m256i R0 = _mm256_loadu_si256((const __m256i*)&State.H[0]);
+		__m256i R1 = _mm256_loadu_si256((const __m256i*)&State.H[4]);
+		__m256i R2 = _mm256_loadu_si256((const __m256i*)&IV[0]);
+		__m256i R3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&IV[4]), _mm256_set_epi64x(State.F[1], State.F[0], State.T[1], State.T[0]));
+		__m512i MW;
+
+		for (size_t i = 0; i < 12; ++i)
+		{
+			const ulong* S = SIGMA[i % 10];
+
+			// column step
+			MW = _mm512_permutex2var_epi64(ML, _mm512_loadu_si512((const void*)S), MH);
+			G4R(R0, R1, R2, R3, _mm512_castsi512_si256(MW), _mm512_extracti64x4_epi64(MW, 1));
+			// diagonalize
+			R1 = _mm256_permute4x64_epi64(R1, _MM_SHUFFLE(0, 3, 2, 1));
+			R2 = _mm256_permute4x64_epi64(R2, _MM_SHUFFLE(1, 0, 3, 2));
+			R3 = _mm256_permute4x64_epi64(R3, _MM_SHUFFLE(2, 1, 0, 3));
+			// diagonal step
+			MW = _mm512_permutex2var_epi64(ML, _mm512_loadu_si512((const void*)(S + 8)), MH);
+			G4R(R0, R1, R2, R3, _mm512_castsi512_si256(MW), _mm512_extracti64x4_epi64(MW, 1));
+			// undiagonalize
+			R1 = _mm256_permute4x64_epi64(R1, _MM_SHUFFLE(2, 1, 0, 3));
+			R2 = _mm256_permute4x64_epi64(R2, _MM_SHUFFLE(1, 0, 3, 2));
+			R3 = _mm256_permute4x64_epi64(R3, _MM_SHUFFLE(0, 3, 2, 1));
+		}
+
+		_mm256_storeu_si256((__m256i*)&State.H[0], _mm256_ternarylogic_epi64(_mm256_loadu_si256((const __m256i*)&State.H[0]), R0, R2, 0x96));
+		_mm256_storeu_si256((__m256i*)&State.H[4], _mm256_ternarylogic_epi64(_mm256_loadu_si256((const __m256i*)&State.H[4]), R1, R3, 0x96));
+	}
+
+	/// <summary>
+	/// Compress eight independent message blocks using AVX512F, one per 64 bit lane of a 512 bit register.
+	/// <para>The wide state is stored transposed; word j of lane i is at H[(j * 8) + i], T[i] and T[8 + i] hold the lane counter, F[i] and F[8 + i] the lane flags.
+	/// Compiled with a function level target; the caller must check for AVX512F support at runtime.</para>
+	/// </summary>
+	template <typename T>
+	CEX_TARGET_AVX512 static void Compress128WAvx512(const byte* const* Input, T &State, const ulong* IV)
+	{
+		static const byte SIGMA[10][16] =
+		{
+			{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+			{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+			{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+			{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+			{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+			{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+			{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+			{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+			{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 }
+		};
+
+		__m512i M[16];
+		__m512i P[8];
+		__m512i T0, T1, T2, T3, T4, T5, T6, T7;
+
+		// load and transpose the eight message blocks, eight words at a time
+		for (size_t i = 0; i < 2; ++i)
+		{
+			for (size_t j = 0; j < 8; ++j)
+				P[j] = _mm512_loadu_si512((const void*)(Input[j] + (i * 64)));
+
+			T0 = _mm512_unpacklo_epi64(P[0], P[1]);
+			T1 = _mm512_unpackhi_epi64(P[0], P[1]);
+			T2 = _mm512_unpacklo_epi64(P[2], P[3]);
+			T3 = _mm512_unpackhi_epi64(P[2], P[3]);
+			T4 = _mm512_unpacklo_epi64(P[4], P[5]);
+			T5 = _mm512_unpackhi_epi64(P[4], P[5]);
+			T6 = _mm512_unpacklo_epi64(P[6], P[7]);
+			T7 = _mm512_unpackhi_epi64(P[6], P[7]);
+
+			P[0] = _mm512_shuffle_i64x2(T0, T2, _MM_SHUFFLE(2, 0, 2, 0));
+			P[1] = _mm512_shuffle_i64x2(T0, T2, _MM_SHUFFLE(3, 1, 3, 1));
+			P[2] = _mm512_shuffle_i64x2(T1, T3, _MM_SHUFFLE(2, 0, 2, 0));
+			P[3] = _mm512_shuffle_i64x2(T1, T3, _MM_SHUFFLE(3, 1, 3, 1));
+			P[4] = _mm512_shuffle_i64x2(T4, T6, _MM_SHUFFLE(2, 0, 2, 0));
+			P[5] = _mm512_shuffle_i64x2(T4, T6, _MM_SHUFFLE(3, 1, 3, 1));
+			P[6] = _mm512_shuffle_i64x2(T5, T7, _MM_SHUFFLE(2, 0, 2, 0));
+			P[7] = _mm512_shuffle_i64x2(T5, T7, _MM_SHUFFLE(3, 1, 3, 1));
+
+			M[(i * 8)] = _mm512_shuffle_i64x2(P[0], P[4], _MM_SHUFFLE(2, 0, 2, 0));
+			M[(i * 8) + 1] = _mm512_shuffle_i64x2(P[2], P[6], _MM_SHUFFLE(2, 0, 2, 0));
+			M[(i * 8) + 2] = _mm512_shuffle_i64x2(P[1], P[5], _MM_SHUFFLE(2, 0, 2, 0));
+			M[(i * 8) + 3] = _mm512_shuffle_i64x2(P[3], P[7], _MM_SHUFFLE(2, 0, 2, 0));
+			M[(i * 8) + 4] = _mm512_shuffle_i64x2(P[0], P[4], _MM_SHUFFLE(3, 1, 3, 1));
+			M[(i * 8) + 5] = _mm512_shuffle_i64x2(P[2], P[6], _MM_SHUFFLE(3, 1, 3, 1));
+			M[(i * 8) + 6] = _mm512_shuffle_i64x2(P[1], P[5], _MM_SHUFFLE(3, 1, 3, 1));
+			M[(i * 8) + 7] = _mm512_shuffle_i64x2(P[3], P[7], _MM_SHUFFLE(3, 1, 3, 1));
+		}
+
+		__m512i R0 = _mm512_loadu_si512((const void*)&State.H[0]);
+		__m512i R1 = _mm512_loadu_si512((const void*)&State.H[8]);
+		__m512i R2 = _mm512_loadu_si512((const void*)&State.H[16]);
+		__m512i R3 = _mm512_loadu_si512((const void*)&State.H[24]);
+		__m512i R4 = _mm512_loadu_si512((const void*)&State.H[32]);
+		__m512i R5 = _mm512_loadu_si512((const void*)&State.H[40]);
+		__m512i R6 = _mm512_loadu_si512((const void*)&State.H[48]);
+		__m512i R7 = _mm512_loadu_si512((const void*)&State.H[56]);
+		__m512i R8 = _mm512_set1_epi64(IV[0]);
+		__m512i R9 = _mm512_set1_epi64(IV[1]);
+		__m512i R10 = _mm512_set1_epi64(IV[2]);
+		__m512i R11 = _mm512_set1_epi64(IV[3]);
+		__m512i R12 = _mm512_xor_si512(_mm512_set1_epi64(IV[4]), _mm512_loadu_si512((const void*)&State.T[0]));
+		__m512i R13 = _mm512_xor_si512(_mm512_set1_epi64(IV[5]), _mm512_loadu_si512((const void*)&State.T[8]));
+		__m512i R14 = _mm512_xor_si512(_mm512_set1_epi64(IV[6]), _mm512_loadu_si512((const void*)&State.F[0]));
+		__m512i R15 = _mm512_xor_si512(_mm512_set1_epi64(IV[7]), _mm512_loadu_si512((const void*)&State.F[8]));
+
+		for (size_t i = 0; i < 12; ++i)
+		{
+			const byte* S = SIGMA[i % 10];
+
+			// column step
+			G8Z(R0, R4, R8, R12, M[S[0]], M[S[1]]);
+			G8Z(R1, R5, R9, R13, M[S[2]], M[S[3]]);
+			G8Z(R2, R6, R10, R14, M[S[4]], M[S[5]]);
+			G8Z(R3, R7, R11, R15, M[S[6]], M[S[7]]);
+			// diagonal step
+			G8Z(R0, R5, R10, R15, M[S[8]], M[S[9]]);
+			G8Z(R1, R6, R11, R12, M[S[10]], M[S[11]]);
+			G8Z(R2, R7, R8, R13, M[S[12]], M[S[13]]);
+			G8Z(R3, R4, R9, R14, M[S[14]], M[S[15]]);
+		}
+
+		_mm512_storeu_si512((void*)&State.H[0], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[0]), R0, R8, 0x96));
+		_mm512_storeu_si512((void*)&State.H[8], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[8]), R1, R9, 0x96));
+		_mm512_storeu_si512((void*)&State.H[16], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[16]), R2, R10, 0x96));
+		_mm512_storeu_si512((void*)&State.H[24], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[24]), R3, R11, 0x96));
+		_mm512_storeu_si512((void*)&State.H[32], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[32]), R4, R12, 0x96));
+		_mm512_storeu_si512((void*)&State.H[40], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[40]), R5, R13, 0x96));
+		_mm512_storeu_si512((void*)&State.H[48], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[48]), R6, R14, 0x96));
+		_mm512_storeu_si512((void*)&State.H[56], _mm512_ternarylogic_epi64(_mm512_loadu_si512((const void*)&State.H[56]), R7, R15, 0x96));
+	}
+
 #endif
 };
 
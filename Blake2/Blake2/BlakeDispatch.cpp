@@ -0,0 +1,188 @@
+#include "BlakeDispatch.h"
+#include "Blake256Compress.h"
+#include "Blake512Compress.h"
+#include "CpuDetect.h"
+
+NAMESPACE_DIGEST
+
+//~~~Public Functions~~~//
+
+const BlakeDispatch::Kernels &BlakeDispatch::Get()
+{
+	// initialized once, thread safe
+	static const Kernels KERNELS = Select();
+
+	return KERNELS;
+}
+
+//~~~Private Functions~~~//
+
+BlakeDispatch::Kernels BlakeDispatch::Select()
+{
+	Kernels kernels = { &Compress128Portable, &Compress128WLanes, 4, &Compress128WLanes, &Compress64Portable, &Compress64WLanes, 8, &Compress64WBlocksLanes, "Portable" };
+
+#if defined(CEX_TARGET_DISPATCH)
+	Common::CpuDetect detect;
+
+	if (detect.SSSE3() && detect.SSE41())
+	{
+		kernels.Compress128 = &Compress128Sse41;
+		kernels.Compress64 = &Compress64Sse41;
+		kernels.Name = "SSE4.1";
+	}
+
+	// the ymm and zmm kernels also need the os to save the wider register state; a hypervisor may mask it
+	if (detect.AVX2() && detect.Avx2Enabled())
+	{
+		kernels.Compress128W = &Compress128WAvx2;
+		kernels.Compress128W4 = &Compress128WAvx2;
+		kernels.Compress64W = &Compress64WAvx2;
+		kernels.Compress64WBlocks = &Compress64WBlocksAvx2;
+		kernels.Name = "AVX2";
+	}
+
+#	if defined(CEX_AVX512_AVAILABLE)
+	if (detect.AVX2() && detect.Avx512Usable())
+	{
+		kernels.Compress128 = &Compress128Avx512;
+		kernels.Compress128W = &Compress128WAvx512;
+		kernels.Lanes128W = 8;
+		kernels.Name = "AVX512";
+	}
+#	endif
+#endif
+
+	return kernels;
+}
+
+void BlakeDispatch::Compress128Portable(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV)
+{
+	Blake512Compress::Compress128(Input, State, IV);
+}
+
+void BlakeDispatch::Compress128WLanes(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV)
+{
+	const size_t LNECNT = State.Lanes;
+	const Compress128Fn COMPRESS = Get().Compress128;
+	Blake2bState lane;
+
+	// compress each lane in turn with the single block kernel, reading the lane block in place
+	for (size_t i = 0; i < LNECNT; ++i)
+	{
+		for (size_t j = 0; j < 8; ++j)
+			lane.H[j] = State.H[(j * LNECNT) + i];
+
+		lane.T[0] = State.T[i];
+		lane.T[1] = State.T[LNECNT + i];
+		lane.F[0] = State.F[i];
+		lane.F[1] = State.F[LNECNT + i];
+
+		COMPRESS(Input[i], lane, IV);
+
+		for (size_t j = 0; j < 8; ++j)
+			State.H[(j * LNECNT) + i] = lane.H[j];
+	}
+}
+
+void BlakeDispatch::Compress64Portable(const byte* Input, Blake2sState &State, const std::vector<uint> &IV)
+{
+	Blake256Compress::Compress64(Input, State, IV);
+}
+
+void BlakeDispatch::Compress64WLanes(const std::vector<const byte*> &Input, Blake2sWideState &State, const std::vector<uint> &IV)
+{
+	const size_t LNECNT = State.Lanes;
+	const Compress64Fn COMPRESS = Get().Compress64;
+	Blake2sState lane;
+
+	// compress each lane in turn with the single block kernel, reading the lane block in place
+	for (size_t i = 0; i < LNECNT; ++i)
+	{
+		for (size_t j = 0; j < 8; ++j)
+			lane.H[j] = State.H[(j * LNECNT) + i];
+
+		lane.T[0] = State.T[i];
+		lane.T[1] = State.T[LNECNT + i];
+		lane.F[0] = State.F[i];
+		lane.F[1] = State.F[LNECNT + i];
+
+		COMPRESS(Input[i], lane, IV);
+
+		for (size_t j = 0; j < 8; ++j)
+			State.H[(j * LNECNT) + i] = lane.H[j];
+	}
+}
+
+void BlakeDispatch::Compress64WBlocksLanes(const std::vector<const byte*> &Input, size_t Stride, size_t BlockCount, Blake2sWideState &State, const std::vector<uint> &IV)
+{
+	const size_t LNECNT = State.Lanes;
+	const Compress64Fn COMPRESS = Get().Compress64;
+	Blake2sState lane;
+
+	// each lane runs all of its blocks with the single block kernel, advancing the lane counter
+	for (size_t i = 0; i < LNECNT; ++i)
+	{
+		for (size_t j = 0; j < 8; ++j)
+			lane.H[j] = State.H[(j * LNECNT) + i];
+
+		lane.T[0] = State.T[i];
+		lane.T[1] = State.T[LNECNT + i];
+		lane.F[0] = State.F[i];
+		lane.F[1] = State.F[LNECNT + i];
+
+		for (size_t j = 0; j < BlockCount; ++j)
+		{
+			lane.T[0] += 64;
+			if (lane.T[0] < 64)
+				++lane.T[1];
+
+			COMPRESS(Input[i] + (j * Stride), lane, IV);
+		}
+
+		for (size_t j = 0; j < 8; ++j)
+			State.H[(j * LNECNT) + i] = lane.H[j];
+
+		State.T[i] = lane.T[0];
+		State.T[LNECNT + i] = lane.T[1];
+	}
+}
+
+#if defined(CEX_TARGET_DISPATCH)
+
+void BlakeDispatch::Compress128WAvx2(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV)
+{
+	Blake2bWideView view = { State.F.data(), State.H.data(), State.T.data() };
+	Compress128WAvx2(Input.data(), view, IV.data());
+}
+
+void BlakeDispatch::Compress64WAvx2(const std::vector<const byte*> &Input, Blake2sWideState &State, const std::vector<uint> &IV)
+{
+	Blake2sWideView view = { State.F.data(), State.H.data(), State.T.data() };
+	Compress64WAvx2(Input.data(), view, IV.data());
+}
+
+void BlakeDispatch::Compress64WBlocksAvx2(const std::vector<const byte*> &Input, size_t Stride, size_t BlockCount, Blake2sWideState &State, const std::vector<uint> &IV)
+{
+	Blake2sWideView view = { State.F.data(), State.H.data(), State.T.data() };
+	Compress64WBlocksAvx2(Input.data(), Stride, BlockCount, view, IV.data());
+}
+
+#endif
+
+#if defined(CEX_AVX512_AVAILABLE)
+
+void BlakeDispatch::Compress128Avx512(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV)
+{
+	Compress128Avx512(Input, State, IV.data());
+}
+
+void BlakeDispatch::Compress128WAvx512(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV)
+{
+	Blake2bWideView view = { State.F.data(), State.H.data(), State.T.data() };
+	Compress128WAvx512(Input.data(), view, IV.data());
+}
+
+#endif
+
+
+NAMESPACE_DIGESTEND
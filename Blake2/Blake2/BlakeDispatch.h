@@ -0,0 +1,111 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _CEX_BLAKEDISPATCH_H
+#define _CEX_BLAKEDISPATCH_H
+
+#include "CexDomain.h"
+#include "BlakeState.h"
+
+NAMESPACE_DIGEST
+
+/**
+* \internal
+* Runtime selection of the Blake2 compression kernels.
+* <para>Each instruction set has its own translation unit; GCC and Clang compile the kernels with a matching function target,
+* MSVC compiles the AVX2 and AVX512 units with a per-file /arch option, and the SSE4.1 unit without one, as MSVC has no SSE4.1 arch option.
+* An inline or template function emitted in an /arch unit may be the copy the linker keeps for the whole program, so those units must not use any:
+* the kernels there take plain pointers (the WideView states), and the std::vector forms in the kernel table unpack their arguments in BlakeDispatch.cpp.
+* The kernel table is built once, on first use, from the CpuDetect feature flags; the best supported kernel of each type is selected,
+* with the portable kernels used where no SIMD kernel is available.</para>
+*/
+class BlakeDispatch
+{
+public:
+
+	typedef void(*Compress128Fn)(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV);
+	typedef void(*Compress128WFn)(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV);
+	typedef void(*Compress64Fn)(const byte* Input, Blake2sState &State, const std::vector<uint> &IV);
+	typedef void(*Compress64WFn)(const std::vector<const byte*> &Input, Blake2sWideState &State, const std::vector<uint> &IV);
+	typedef void(*Compress64WBlocksFn)(const std::vector<const byte*> &Input, size_t Stride, size_t BlockCount, Blake2sWideState &State, const std::vector<uint> &IV);
+
+	/// <summary>
+	/// The selected kernel table
+	/// </summary>
+	struct Kernels
+	{
+		// Blake2b single block
+		Compress128Fn Compress128;
+		// Blake2b multi-buffer, Lanes128W messages per call
+		Compress128WFn Compress128W;
+		size_t Lanes128W;
+		// Blake2b multi-buffer, four messages per call; for fewer than Lanes128W messages
+		Compress128WFn Compress128W4;
+		// Blake2s single block
+		Compress64Fn Compress64;
+		// Blake2s multi-buffer, Lanes64W messages per call
+		Compress64WFn Compress64W;
+		size_t Lanes64W;
+		// Blake2s multi-buffer, BlockCount blocks per lane read Stride bytes apart
+		Compress64WBlocksFn Compress64WBlocks;
+		// the instruction set of the widest selected kernel
+		const char* Name;
+	};
+
+	/// <summary>
+	/// Get the kernel table for this processor; selected on the first call
+	/// </summary>
+	static const Kernels &Get();
+
+private:
+
+	static Kernels Select();
+
+	// portable kernels; BlakeDispatch.cpp
+	static void Compress128Portable(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV);
+	static void Compress128WLanes(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV);
+	static void Compress64Portable(const byte* Input, Blake2sState &State, const std::vector<uint> &IV);
+	static void Compress64WLanes(const std::vector<const byte*> &Input, Blake2sWideState &State, const std::vector<uint> &IV);
+	static void Compress64WBlocksLanes(const std::vector<const byte*> &Input, size_t Stride, size_t BlockCount, Blake2sWideState &State, const std::vector<uint> &IV);
+
+#if defined(CEX_TARGET_DISPATCH)
+	// SSSE3/SSE4.1 kernels; BlakeDispatchSse41.cpp
+	static void Compress128Sse41(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV);
+	static void Compress64Sse41(const byte* Input, Blake2sState &State, const std::vector<uint> &IV);
+	// AVX2 table entries; BlakeDispatch.cpp
+	static void Compress128WAvx2(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV);
+	static void Compress64WAvx2(const std::vector<const byte*> &Input, Blake2sWideState &State, const std::vector<uint> &IV);
+	static void Compress64WBlocksAvx2(const std::vector<const byte*> &Input, size_t Stride, size_t BlockCount, Blake2sWideState &State, const std::vector<uint> &IV);
+	// AVX2 kernels; BlakeDispatchAvx2.cpp
+	static void Compress128WAvx2(const byte* const* Input, Blake2bWideView &State, const ulong* IV);
+	static void Compress64WAvx2(const byte* const* Input, Blake2sWideView &State, const uint* IV);
+	static void Compress64WBlocksAvx2(const byte* const* Input, size_t Stride, size_t BlockCount, Blake2sWideView &State, const uint* IV);
+#endif
+
+#if defined(CEX_AVX512_AVAILABLE)
+	// AVX512F/VL table entries; BlakeDispatch.cpp
+	static void Compress128Avx512(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV);
+	static void Compress128WAvx512(const std::vector<const byte*> &Input, Blake2bWideState &State, const std::vector<ulong> &IV);
+	// AVX512F/VL kernels; BlakeDispatchAvx512.cpp
+	static void Compress128Avx512(const byte* Input, Blake2bState &State, const ulong* IV);
+	static void Compress128WAvx512(const byte* const* Input, Blake2bWideView &State, const ulong* IV);
+#endif
+};
+
+NAMESPACE_DIGESTEND
+#endif
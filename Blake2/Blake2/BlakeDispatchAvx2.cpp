@@ -0,0 +1,28 @@
+#include "BlakeDispatch.h"
+#include "Blake256Compress.h"
+#include "Blake512Compress.h"
+
+NAMESPACE_DIGEST
+
+// built with /arch:AVX2 under MSVC; nothing here may call an inline or template function shared with other units
+
+#if defined(CEX_TARGET_DISPATCH)
+
+void BlakeDispatch::Compress128WAvx2(const byte* const* Input, Blake2bWideView &State, const ulong* IV)
+{
+	Blake512Compress::Compress128WAvx2(Input, State, IV);
+}
+
+void BlakeDispatch::Compress64WAvx2(const byte* const* Input, Blake2sWideView &State, const uint* IV)
+{
+	Blake256Compress::Compress64WAvx2(Input, State, IV);
+}
+
+void BlakeDispatch::Compress64WBlocksAvx2(const byte* const* Input, size_t Stride, size_t BlockCount, Blake2sWideView &State, const uint* IV)
+{
+	Blake256Compress::Compress64WBlocksAvx2(Input, Stride, BlockCount, State, IV);
+}
+
+#endif
+
+NAMESPACE_DIGESTEND
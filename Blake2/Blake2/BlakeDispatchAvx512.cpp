@@ -0,0 +1,22 @@
+#include "BlakeDispatch.h"
+#include "Blake512Compress.h"
+
+NAMESPACE_DIGEST
+
+// built with /arch:AVX512 under MSVC; nothing here may call an inline or template function shared with other units
+
+#if defined(CEX_AVX512_AVAILABLE)
+
+void BlakeDispatch::Compress128Avx512(const byte* Input, Blake2bState &State, const ulong* IV)
+{
+	Blake512Compress::Compress128Avx512(Input, State, IV);
+}
+
+void BlakeDispatch::Compress128WAvx512(const byte* const* Input, Blake2bWideView &State, const ulong* IV)
+{
+	Blake512Compress::Compress128WAvx512(Input, State, IV);
+}
+
+#endif
+
+NAMESPACE_DIGESTEND
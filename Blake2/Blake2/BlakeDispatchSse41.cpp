@@ -0,0 +1,21 @@
+#include "BlakeDispatch.h"
+#include "Blake256Compress.h"
+#include "Blake512Compress.h"
+
+NAMESPACE_DIGEST
+
+#if defined(CEX_TARGET_DISPATCH)
+
+void BlakeDispatch::Compress128Sse41(const byte* Input, Blake2bState &State, const std::vector<ulong> &IV)
+{
+	Blake512Compress::Compress128Sse41(Input, State, IV);
+}
+
+void BlakeDispatch::Compress64Sse41(const byte* Input, Blake2sState &State, const std::vector<uint> &IV)
+{
+	Blake256Compress::Compress64Sse41(Input, State, IV);
+}
+
+#endif
+
+NAMESPACE_DIGESTEND
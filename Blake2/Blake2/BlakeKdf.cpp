@@ -0,0 +1,213 @@
+#include "BlakeKdf.h"
+#include "ArrayUtils.h"
+#include "BlakeParams.h"
+#include "IntUtils.h"
+#include "SymmetricKey.h"
+
+NAMESPACE_KDF
+
+using Exception::CryptoDigestException;
+using Utility::ArrayUtils;
+using Utility::IntUtils;
+
+//~~~Constructor~~~//
+
+BlakeKdf::BlakeKdf()
+	:
+	m_blockInput(0),
+	m_blockOutput(0),
+	m_blakeEngine(false),
+	m_isDestroyed(false),
+	m_isInitialized(false),
+	m_keyedState()
+{
+}
+
+BlakeKdf::~BlakeKdf()
+{
+	Destroy();
+}
+
+//~~~Public Functions~~~//
+
+void BlakeKdf::Destroy()
+{
+	if (!m_isDestroyed)
+	{
+		m_isDestroyed = true;
+
+		try
+		{
+			Reset();
+			m_blakeEngine.Destroy();
+		}
+		catch (std::exception& ex)
+		{
+			throw CryptoDigestException("BlakeKdf:Destroy", "Could not clear all variables!", std::string(ex.what()));
+		}
+	}
+}
+
+size_t BlakeKdf::Generate(std::vector<byte> &Output)
+{
+	const std::vector<byte> context(0);
+
+	return Generate(context, Output, 0, Output.size());
+}
+
+size_t BlakeKdf::Generate(const std::vector<byte> &Context, std::vector<byte> &Output, size_t OutOffset, size_t Length)
+{
+	if (!m_isInitialized)
+		throw CryptoDigestException("BlakeKdf:Generate", "The generator must be initialized before use!");
+	if (Output.size() < OutOffset + Length)
+		throw CryptoDigestException("BlakeKdf:Generate", "The Output buffer is too short!");
+
+	if (Length == 0)
+		return 0;
+
+	Expand(&Context, 1, Length);
+
+	// the key stream is not kept once it is copied out
+	for (size_t i = 0; i < m_blockOutput.size(); ++i)
+	{
+		const size_t BLKLEN = (Length - (i * BLOCK_SIZE) < BLOCK_SIZE) ? Length - (i * BLOCK_SIZE) : BLOCK_SIZE;
+		memcpy(&Output[OutOffset + (i * BLOCK_SIZE)], &m_blockOutput[i][0], BLKLEN);
+		ArrayUtils::ClearVector(m_blockOutput[i]);
+	}
+
+	return Length;
+}
+
+void BlakeKdf::GenerateBatch(const std::vector<std::vector<byte>> &Contexts, std::vector<std::vector<byte>> &Output, size_t Length)
+{
+	if (!m_isInitialized)
+		throw CryptoDigestException("BlakeKdf:GenerateBatch", "The generator must be initialized before use!");
+
+	Output.resize(Contexts.size());
+
+	if (Contexts.size() == 0 || Length == 0)
+	{
+		for (size_t i = 0; i < Output.size(); ++i)
+			Output[i].clear();
+
+		return;
+	}
+
+	const size_t BLKCNT = (Length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	Expand(&Contexts[0], Contexts.size(), Length);
+
+	// the blocks of context i are blocks i * BLKCNT to (i + 1) * BLKCNT - 1 of the batch
+	for (size_t i = 0; i < Contexts.size(); ++i)
+	{
+		Output[i].resize(Length);
+
+		for (size_t j = 0; j < BLKCNT; ++j)
+		{
+			const size_t BLKLEN = (Length - (j * BLOCK_SIZE) < BLOCK_SIZE) ? Length - (j * BLOCK_SIZE) : BLOCK_SIZE;
+			memcpy(&Output[i][j * BLOCK_SIZE], &m_blockOutput[(i * BLKCNT) + j][0], BLKLEN);
+			ArrayUtils::ClearVector(m_blockOutput[(i * BLKCNT) + j]);
+		}
+	}
+}
+
+void BlakeKdf::Initialize(ISymmetricKey &GenParam)
+{
+	if (GenParam.Key().size() == 0)
+		throw CryptoDigestException("BlakeKdf:Initialize", "The input key material can not be empty!");
+	if (GenParam.Nonce().size() != 0 && GenParam.Nonce().size() != PRM_SIZE)
+		throw CryptoDigestException("BlakeKdf:Initialize", "Salt has invalid length! Must be 16 bytes.");
+	if (GenParam.Info().size() != 0 && GenParam.Info().size() != PRM_SIZE)
+		throw CryptoDigestException("BlakeKdf:Initialize", "Info has invalid length! Must be 16 bytes.");
+
+	// an absent salt or personalization is all zeroes in the parameter block
+	std::vector<byte> salt(PRM_SIZE, 0);
+	std::vector<byte> info(PRM_SIZE, 0);
+
+	if (GenParam.Nonce().size() != 0)
+		memcpy(&salt[0], &GenParam.Nonce()[0], PRM_SIZE);
+	if (GenParam.Info().size() != 0)
+		memcpy(&info[0], &GenParam.Info()[0], PRM_SIZE);
+
+	// extract; the salt and personalization are parameter block words 4 to 7, held in the distribution code
+	std::vector<byte> code(40, 0);
+	memcpy(&code[8], &salt[0], PRM_SIZE);
+	memcpy(&code[24], &info[0], PRM_SIZE);
+	Digest::BlakeParams params(static_cast<byte>(BLOCK_SIZE), 0, 1, 1, 0, 0, 0, 0, code);
+	Digest::Blake512 extractor(params);
+	std::vector<byte> prk(BLOCK_SIZE);
+	extractor.Compute(GenParam.Key(), prk);
+
+	// expand; the pseudo-random key keys the engine, and its key block is compressed once, into the template
+	Key::Symmetric::SymmetricKey mkey(prk, salt, info);
+	m_blakeEngine.Initialize(mkey);
+	m_blakeEngine.GetKeyedState(m_keyedState);
+	m_blakeEngine.Reset();
+	ArrayUtils::ClearVector(prk);
+
+	m_isInitialized = true;
+}
+
+void BlakeKdf::Reset()
+{
+	for (size_t i = 0; i < m_blockInput.size(); ++i)
+		ArrayUtils::ClearVector(m_blockInput[i]);
+	for (size_t i = 0; i < m_blockOutput.size(); ++i)
+		ArrayUtils::ClearVector(m_blockOutput[i]);
+
+	m_blockInput.clear();
+	m_blockOutput.clear();
+	m_keyedState.Chain.Reset();
+	memset(m_keyedState.EmptyCode, 0, sizeof(m_keyedState.EmptyCode));
+	m_keyedState.IsKeyed = false;
+	m_isInitialized = false;
+}
+
+//~~~Private Functions~~~//
+
+void BlakeKdf::Expand(const std::vector<byte>* Contexts, size_t Count, size_t Length)
+{
+	const size_t BLKCNT = (Length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	if (BLKCNT > 0xFFFFFFFFULL)
+		throw CryptoDigestException("BlakeKdf:Expand", "The output length exceeds the maximum of 2^32 - 1 blocks!");
+
+	// one message per output block; the block counter, then the context
+	m_blockInput.resize(Count * BLKCNT);
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		const std::vector<byte> &ctx = Contexts[i];
+
+		for (size_t j = 0; j < BLKCNT; ++j)
+		{
+			std::vector<byte> &msg = m_blockInput[(i * BLKCNT) + j];
+			msg.resize(CTR_SIZE + ctx.size());
+			IntUtils::Le32ToBytes(static_cast<uint>(j + 1), msg, 0);
+
+			if (ctx.size() != 0)
+				memcpy(&msg[CTR_SIZE], &ctx[0], ctx.size());
+		}
+	}
+
+	// every message starts from the keyed template
+	m_blakeEngine.LoadKeyedState(m_keyedState);
+
+	if (m_blockInput.size() == 1)
+	{
+		m_blockOutput.resize(1);
+		m_blockOutput[0].resize(BLOCK_SIZE);
+		m_blakeEngine.Update(m_blockInput[0], 0, m_blockInput[0].size());
+		m_blakeEngine.Finalize(m_blockOutput[0], 0);
+	}
+	else
+	{
+		m_blakeEngine.ComputeBatch(m_blockInput, m_blockOutput);
+	}
+
+	// the messages hold the caller contexts; the buffers keep their capacity for the next request
+	for (size_t i = 0; i < m_blockInput.size(); ++i)
+		ArrayUtils::ClearVector(m_blockInput[i]);
+}
+
+NAMESPACE_KDFEND
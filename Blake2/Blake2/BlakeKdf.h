@@ -0,0 +1,188 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//
+// Implementation Details:
+// An implementation of an extract and expand key derivation function built on keyed Blake2b.
+// Follows the structure of HKDF, RFC 5869, with a counter mode expansion as in NIST SP 800-108.
+
+#ifndef _CEX_BLAKEKDF_H
+#define _CEX_BLAKEKDF_H
+
+#include "Blake512.h"
+#include "BlakeState.h"
+#include "ISymmetricKey.h"
+
+NAMESPACE_KDF
+
+using Key::Symmetric::ISymmetricKey;
+
+/// <summary>
+/// An extract and expand key derivation function built on keyed Blake2b (Blake512)
+/// </summary>
+///
+/// <example>
+/// <description>Deriving a session key:</description>
+/// <code>
+/// SymmetricKey kp(Ikm, Salt, Personal);
+/// BlakeKdf kdf;
+/// kdf.Initialize(kp);
+/// kdf.Generate(Context, Output, 0, Output.size());
+/// </code>
+/// </example>
+///
+/// <remarks>
+/// <description><B>Description:</B></description>
+/// <para><EM>Legend:</EM> \n
+/// <B>H</B>=Blake2b with the salt and personalization parameters, <B>IKM</B>=input key material, <B>PRK</B>=pseudo-random key, <B>C</B>=context, <B>i</B>=32 bit little endian block counter, <B>||</B>=concatenate \n
+/// <EM>Extract</EM> \n
+/// PRK = H(IKM) \n
+/// <EM>Expand</EM> \n
+/// T(i) = H<sub>PRK</sub>(i || C), for i = 1 to n; the output is T(1) || T(2) || ... truncated to the requested length</para> \n
+///
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>The salt and personalization are the Nonce and Info members of the SymmetricKey; 16 bytes each, or empty. They are written to the Blake2b parameter block of both the extract and expand stages.</description></item>
+/// <item><description>Output blocks depend only on the PRK, the context, and the counter, rather than on the previous block as in HKDF, so the blocks of one request, or of many requests, are hashed together by the multi-buffer kernel.</description></item>
+/// <item><description>The PRK key block is compressed once by Initialize into a keyed Blake2b template; each output block costs the compression of its counter and context only.</description></item>
+/// <item><description>The output is prefix consistent; a shorter output under the same context is the start of a longer one.</description></item>
+/// <item><description>The maximum output of one request is 2^32 - 1 blocks of 64 bytes.</description></item>
+/// </list>
+///
+/// <description>Guiding Publications:</description>
+/// <list type="number">
+/// <item><description>RFC <a href="https://tools.ietf.org/html/rfc5869">5869</a>: HMAC-based Extract-and-Expand Key Derivation Function (HKDF).</description></item>
+/// <item><description>NIST <a href="http://nvlpubs.nist.gov/nistpubs/SpecialPublications/NIST.SP.800-108r1.pdf">SP 800-108</a>: Recommendation for Key Derivation Using Pseudorandom Functions.</description></item>
+/// <item><description>Blake2 whitepaper <a href="https://blake2.net/blake2.pdf">BLAKE2: simpler, smaller, fast as MD5</a>.</description></item>
+/// </list>
+/// </remarks>
+class BlakeKdf
+{
+private:
+
+	static const size_t BLOCK_SIZE = 64;
+	static const size_t CTR_SIZE = 4;
+	static const size_t PRM_SIZE = 16;
+
+	std::vector<std::vector<byte>> m_blockInput;
+	std::vector<std::vector<byte>> m_blockOutput;
+	Digest::Blake512 m_blakeEngine;
+	bool m_isDestroyed;
+	bool m_isInitialized;
+	Digest::Blake2bKeyedState m_keyedState;
+
+public:
+
+	BlakeKdf(const BlakeKdf&) = delete;
+	BlakeKdf& operator=(const BlakeKdf&) = delete;
+	BlakeKdf& operator=(BlakeKdf&&) = delete;
+
+	//~~~Properties~~~//
+
+	/// <summary>
+	/// Get: Size of an output block in bytes
+	/// </summary>
+	const size_t BlockSize() { return BLOCK_SIZE; }
+
+	/// <summary>
+	/// Get: Generator is ready to produce keying material
+	/// </summary>
+	const bool IsInitialized() { return m_isInitialized; }
+
+	/// <summary>
+	/// Get: The generators class name
+	/// </summary>
+	const std::string Name() { return "BlakeKdf"; }
+
+	//~~~Constructor~~~//
+
+	/// <summary>
+	/// Initialize the generator
+	/// </summary>
+	BlakeKdf();
+
+	/// <summary>
+	/// Finalize objects
+	/// </summary>
+	~BlakeKdf();
+
+	//~~~Public Functions~~~//
+
+	/// <summary>
+	/// Release all resources associated with the object
+	/// </summary>
+	void Destroy();
+
+	/// <summary>
+	/// Fill the output array with keying material, with an empty context
+	/// </summary>
+	///
+	/// <param name="Output">The destination array, filled with keying material</param>
+	///
+	/// <returns>The number of bytes generated</returns>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the generator is not initialized</exception>
+	size_t Generate(std::vector<byte> &Output);
+
+	/// <summary>
+	/// Generate keying material for a context
+	/// </summary>
+	///
+	/// <param name="Context">The context; binds the output to its purpose, e.g. a session or key identifier. May be empty</param>
+	/// <param name="Output">The destination array</param>
+	/// <param name="OutOffset">The starting position within the destination array</param>
+	/// <param name="Length">The number of bytes to generate</param>
+	///
+	/// <returns>The number of bytes generated</returns>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the generator is not initialized, or the output array is too small</exception>
+	size_t Generate(const std::vector<byte> &Context, std::vector<byte> &Output, size_t OutOffset, size_t Length);
+
+	/// <summary>
+	/// Generate keying material for many contexts at once; the output blocks of every context are hashed together by the multi-buffer kernel
+	/// </summary>
+	///
+	/// <param name="Contexts">The contexts, one per derived key</param>
+	/// <param name="Output">Receives one array of Length bytes per context, in the order of the contexts;
+	/// each is equal to the output of Generate with the same context</param>
+	/// <param name="Length">The number of bytes to generate for each context</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the generator is not initialized</exception>
+	void GenerateBatch(const std::vector<std::vector<byte>> &Contexts, std::vector<std::vector<byte>> &Output, size_t Length);
+
+	/// <summary>
+	/// Initialize the generator; extract the pseudo-random key from the input key material
+	/// </summary>
+	///
+	/// <param name="GenParam">The input key material in the Key member; at least one byte.
+	/// <para>The optional Nonce and Info members are the Blake2b salt and personalization; 16 bytes each.</para></param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if a key parameter has an invalid length</exception>
+	void Initialize(ISymmetricKey &GenParam);
+
+	/// <summary>
+	/// Clear the pseudo-random key; the generator must be initialized again
+	/// </summary>
+	void Reset();
+
+private:
+	void Expand(const std::vector<byte>* Contexts, size_t Count, size_t Length);
+};
+
+NAMESPACE_KDFEND
+#endif
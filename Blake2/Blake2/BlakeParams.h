@@ -34,9 +34,13 @@ struct BlakeParams
 {
 private:
 
+	static const size_t DST256_SIZE = 16;
+	static const size_t DST512_SIZE = 40;
 	static const size_t HDR_BASE = 12;
+	static const size_t HDR256_SIZE = 32;
+	static const size_t HDR512_SIZE = 64;
 
-	// 256=12, 512=40
+	// 256=16, 512=40
 	std::vector<byte> m_dstCode;
 	byte m_fanOut;
 	byte m_innerLen;
@@ -91,7 +95,7 @@ public:
 	byte &OutputSize() { return m_outputSize; }
 
 	/// <summary>
-	/// Get/Set: Flag reserved for future use
+	/// Get/Set: Flag reserved for future use; a Blake2b parameter block field only, Blake2s has no reserved field
 	/// </summary>
 	byte &Reserved() { return m_reserved; }
 
@@ -101,11 +105,12 @@ public:
 	std::vector<byte> &DistributionCode() { return m_dstCode; }
 
 	/// <summary>
-	/// Get: The maximum recommended size of the distribution code
+	/// Get: The maximum size of the distribution code; the parameters hold a Blake2b sized code, and a Blake2s digest keeps only the first 16 bytes.
+	/// <para>The layout is chosen by the digest type, not the output size; a Blake2b digest with a 32 byte output still uses the 40 byte code.</para>
 	/// </summary>
 	const size_t DistributionCodeMax()
 	{
-		return ((m_outputSize == 32) ? 12 : 40);
+		return DST512_SIZE;
 	}
 
 
@@ -155,7 +160,7 @@ public:
 		m_outputSize(0),
 		m_reserved(0)
 	{
-		if (TreeArray.size() != 32 && TreeArray.size() != 64)
+		if (TreeArray.size() != HDR256_SIZE && TreeArray.size() != HDR512_SIZE)
 			throw Exception::CryptoDigestException("BlakeParams:Ctor", "The TreeArray buffer is too short!");
 
 		memcpy(&m_outputSize, &TreeArray[0], 1);
@@ -167,8 +172,8 @@ public:
 		memcpy(&m_nodeDepth, &TreeArray[9], 1);
 		memcpy(&m_innerLen, &TreeArray[10], 1);
 		memcpy(&m_reserved, &TreeArray[11], 1);
-		m_dstCode.resize(DistributionCodeMax());
-		memcpy(&m_dstCode[0], &TreeArray[12], m_dstCode.size());
+		m_dstCode.resize((TreeArray.size() == HDR256_SIZE) ? DST256_SIZE : DST512_SIZE);
+		memcpy(&m_dstCode[0], &TreeArray[HDR_BASE], m_dstCode.size());
 	}
 
 	/// <summary>
@@ -235,8 +240,13 @@ public:
 		return true;
 	}
 
-	template <class T>
-	void GetConfig(std::vector<T> &Config)
+	/// <summary>
+	/// Write the parameter block as chain-sized words of type T to a vector or fixed size array of T
+	/// </summary>
+	/// 
+	/// <param name="Config">The destination words</param>
+	template <class T, class Array>
+	void GetConfig(Array &Config)
 	{
 		if (sizeof(T) == sizeof(ulong))
 		{
@@ -261,12 +271,12 @@ public:
 			Config[0] |= ((uint)m_maxDepth << 24);
 			Config[1] = m_leafSize;
 			Config[2] = m_nodeOffset;
-			Config[3] |= ((uint)m_nodeDepth << 16);
+			Config[3] = ((uint)m_nodeDepth << 16);
 			Config[3] |= ((uint)m_innerLen << 24);
-			Config[4] = m_reserved;
 
-			for (size_t i = 5; i < Config.size(); ++i)
-				Config[i] = IntUtils::BytesToLe32(m_dstCode, (i - 5) * sizeof(uint));
+			// Blake2s has no reserved field; the code fills the salt and personalization words 4 to 7
+			for (size_t i = 4; i < Config.size(); ++i)
+				Config[i] = IntUtils::BytesToLe32(m_dstCode, (i - 4) * sizeof(uint));
 		}
 	}
 
@@ -301,7 +311,8 @@ public:
 	/// <returns>Header size</returns>
 	size_t GetHeaderSize()
 	{
-		return m_outputSize;
+		// the layout follows the distribution code, not the output size; a shortened output keeps its digests layout
+		return (m_dstCode.size() > DST256_SIZE) ? HDR512_SIZE : HDR256_SIZE;
 	}
 
 	/// <summary>
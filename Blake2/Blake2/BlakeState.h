@@ -0,0 +1,190 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _CEX_BLAKESTATE_H
+#define _CEX_BLAKESTATE_H
+
+#include "CexDomain.h"
+#include "AlignedAllocator.h"
+
+NAMESPACE_DIGEST
+
+/**
+* \internal
+* The chain, counter and flag words are held in place and start on a cache line; H fills the first line, T and F the second
+*/
+struct CEX_ALIGN_DATA(64) Blake2bState
+{
+	ulong H[8];
+	ulong T[2];
+	ulong F[2];
+
+	Blake2bState()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		memset(H, 0, sizeof(H));
+		memset(T, 0, sizeof(T));
+		memset(F, 0, sizeof(F));
+	}
+};
+
+/**
+* \internal
+* The transposed state of the Blake2b multi-buffer kernels; word j of lane i is at H[(j * Lanes) + i]
+*/
+struct Blake2bWideState
+{
+	std::vector<ulong> F;
+	std::vector<ulong> H;
+	std::vector<ulong> T;
+	size_t Lanes;
+
+	explicit Blake2bWideState(size_t LaneCount)
+		:
+		F(2 * LaneCount),
+		H(8 * LaneCount),
+		T(2 * LaneCount),
+		Lanes(LaneCount)
+	{
+	}
+};
+
+/**
+* \internal
+* A Blake2b wide state seen through plain pointers; the form passed to the AVX2 and AVX512 kernel units
+*/
+struct Blake2bWideView
+{
+	ulong* F;
+	ulong* H;
+	ulong* T;
+};
+
+/**
+* \internal
+* The chain, counter and flag words are held in place and share one cache line
+*/
+struct CEX_ALIGN_DATA(64) Blake2sState
+{
+	uint H[8];
+	uint T[2];
+	uint F[2];
+
+	Blake2sState()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		memset(H, 0, sizeof(H));
+		memset(T, 0, sizeof(T));
+		memset(F, 0, sizeof(F));
+	}
+};
+
+/**
+* \internal
+* The transposed state of the Blake2s multi-buffer kernels; word j of lane i is at H[(j * Lanes) + i]
+*/
+struct Blake2sWideState
+{
+	std::vector<uint> F;
+	std::vector<uint> H;
+	std::vector<uint> T;
+	size_t Lanes;
+
+	explicit Blake2sWideState(size_t LaneCount)
+		:
+		F(2 * LaneCount),
+		H(8 * LaneCount),
+		T(2 * LaneCount),
+		Lanes(LaneCount)
+	{
+	}
+};
+
+/**
+* \internal
+* A Blake2s wide state seen through plain pointers; the form passed to the AVX2 and AVX512 kernel units
+*/
+struct Blake2sWideView
+{
+	uint* F;
+	uint* H;
+	uint* T;
+};
+
+/// <summary>
+/// A keyed Blake2b template; the chain state after the key block has been compressed, and the MAC code of an empty message.
+/// <para>Created once per key with Blake512::GetKeyedState, and loaded before each message with Blake512::LoadKeyedState,
+/// so that messages under the same key do not repeat the key block compression.</para>
+/// </summary>
+struct CEX_ALIGN_DATA(64) Blake2bKeyedState
+{
+	Blake2bState Chain;
+	byte EmptyCode[64];
+	bool IsKeyed;
+
+	Blake2bKeyedState()
+		:
+		Chain(),
+		IsKeyed(false)
+	{
+		memset(EmptyCode, 0, sizeof(EmptyCode));
+	}
+};
+
+/// <summary>
+/// A keyed Blake2s template; the chain state after the key block has been compressed, and the MAC code of an empty message.
+/// <para>Created once per key with Blake256::GetKeyedState, and loaded before each message with Blake256::LoadKeyedState,
+/// so that messages under the same key do not repeat the key block compression.</para>
+/// </summary>
+struct CEX_ALIGN_DATA(64) Blake2sKeyedState
+{
+	Blake2sState Chain;
+	byte EmptyCode[32];
+	bool IsKeyed;
+
+	Blake2sKeyedState()
+		:
+		Chain(),
+		IsKeyed(false)
+	{
+		memset(EmptyCode, 0, sizeof(EmptyCode));
+	}
+};
+
+/**
+* \internal
+* The leaf states of a parallel digest; one contiguous array, each state on its own cache lines
+*/
+typedef std::vector<Blake2bState, Utility::AlignedAllocator<Blake2bState, 64>> Blake2bStateArray;
+
+/**
+* \internal
+* The leaf states of a parallel digest; one contiguous array, each state on its own cache line
+*/
+typedef std::vector<Blake2sState, Utility::AlignedAllocator<Blake2sState, 64>> Blake2sStateArray;
+
+NAMESPACE_DIGESTEND
+#endif
@@ -0,0 +1,707 @@
+#include "BlakeTree.h"
+#include "ArrayUtils.h"
+#include "IntUtils.h"
+#include "ParallelUtils.h"
+
+NAMESPACE_DIGEST
+
+using Utility::ArrayUtils;
+using Utility::IntUtils;
+using Utility::ParallelUtils;
+
+static const std::vector<ulong> BCIV = { 0x6A09E667F3BCC908UL, 0xBB67AE8584CAA73BUL, 0x3C6EF372FE94F82BUL, 0xA54FF53A5F1D36F1UL,
+	0x510E527FADE682D1UL, 0x9B05688C2B3E6C1FUL, 0x1F83D9ABFB41BD6BUL, 0x5BE0CD19137E2179UL };
+
+static const std::vector<uint> SCIV = { 0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+	0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL };
+
+//~~~Constructor~~~//
+
+BlakeTree::BlakeTree(Digests DigestType)
+	:
+	m_blockSize(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK),
+	m_cachedLength(0),
+	m_digestType(DigestType),
+	m_isDestroyed(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyBlock(0),
+	m_leafBuffer(0),
+	m_leafLength(0),
+	m_nodeCount(0),
+	m_nodeHashes(0),
+	m_parallelProfile(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK, false, STATE_PRECACHED, false),
+	m_treeCache(0),
+	m_treeConfig256(),
+	m_treeConfig512()
+{
+	if (m_digestType != Digests::Blake256 && m_digestType != Digests::Blake512)
+		throw CryptoDigestException("BlakeTree:Ctor", "The digest type is not supported! Must be Blake256 or Blake512.");
+
+	// the leaves are hashed on every processor by default; the second argument of the profile is the SIMD multiplier, not the parallel flag
+	m_parallelProfile.IsParallel() = (m_parallelProfile.ProcessorCount() > 1);
+
+	const byte DGTLEN = static_cast<byte>(m_digestType == Digests::Blake256 ? B2S_DIGEST : B2B_DIGEST);
+	m_treeParams = BlakeParams(DGTLEN, DEF_MAXDEPTH, DEF_FANOUT, 0, DGTLEN);
+	m_treeParams.LeafLength() = DEF_LEAFSIZE;
+
+	LoadTree();
+}
+
+BlakeTree::BlakeTree(Digests DigestType, BlakeParams &Params)
+	:
+	m_blockSize(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK),
+	m_cachedLength(0),
+	m_digestType(DigestType),
+	m_isDestroyed(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyBlock(0),
+	m_leafBuffer(0),
+	m_leafLength(0),
+	m_nodeCount(0),
+	m_nodeHashes(0),
+	m_parallelProfile(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK, false, STATE_PRECACHED, false),
+	m_treeCache(0),
+	m_treeConfig256(),
+	m_treeConfig512(),
+	m_treeParams(Params)
+{
+	if (m_digestType != Digests::Blake256 && m_digestType != Digests::Blake512)
+		throw CryptoDigestException("BlakeTree:Ctor", "The digest type is not supported! Must be Blake256 or Blake512.");
+
+	// the leaves are hashed on every processor by default; the second argument of the profile is the SIMD multiplier, not the parallel flag
+	m_parallelProfile.IsParallel() = (m_parallelProfile.ProcessorCount() > 1);
+
+	const size_t DGTLEN = (m_digestType == Digests::Blake256) ? B2S_DIGEST : B2B_DIGEST;
+
+	if (Params.OutputSize() == 0 || Params.OutputSize() > DGTLEN)
+		throw CryptoDigestException("BlakeTree:Ctor", "The OutputSize parameter is invalid! Must be between 1 and the node digest size.");
+	if (Params.InnerLength() == 0 || Params.InnerLength() > DGTLEN)
+		throw CryptoDigestException("BlakeTree:Ctor", "The InnerLength parameter is invalid! Must be between 1 and the node digest size.");
+	if (Params.LeafLength() < m_blockSize || Params.LeafLength() % m_blockSize != 0)
+		throw CryptoDigestException("BlakeTree:Ctor", "The LeafLength parameter is invalid! Must be evenly divisible by digest block size.");
+	if (Params.FanOut() == 1)
+		throw CryptoDigestException("BlakeTree:Ctor", "The FanOut parameter is invalid! Must be zero (unlimited), or greater than 1.");
+	if (Params.MaxDepth() < 2)
+		throw CryptoDigestException("BlakeTree:Ctor", "The MaxDepth parameter is invalid! Must be greater than 1.");
+
+	LoadTree();
+}
+
+BlakeTree::~BlakeTree()
+{
+	Destroy();
+}
+
+//~~~Public Functions~~~//
+
+void BlakeTree::Compute(const std::vector<byte> &Input, std::vector<byte> &Output)
+{
+	if (Output.size() < m_treeParams.OutputSize())
+		Output.resize(m_treeParams.OutputSize());
+
+	Update(Input, 0, Input.size());
+	Finalize(Output, 0);
+}
+
+void BlakeTree::ComputeCached(const std::vector<byte> &Input, std::vector<byte> &Output)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	const size_t INRLEN = m_treeParams.InnerLength();
+	const size_t LEAFLEN = m_treeParams.LeafLength();
+	const size_t LEAFCNT = (Input.size() == 0) ? 1 : (Input.size() + LEAFLEN - 1) / LEAFLEN;
+	size_t nodeCnt = LEAFCNT;
+
+	if (Output.size() < m_treeParams.OutputSize())
+		Output.resize(m_treeParams.OutputSize());
+
+	// one cache level for the leaves, and one for each level below the root
+	m_treeCache.clear();
+	m_treeCache.push_back(std::vector<byte>(nodeCnt * INRLEN));
+
+	while (FNOUT != 0 && m_treeCache.size() + 1 < m_treeParams.MaxDepth() && nodeCnt > FNOUT)
+	{
+		nodeCnt = (nodeCnt + FNOUT - 1) / FNOUT;
+		m_treeCache.push_back(std::vector<byte>(nodeCnt * INRLEN));
+	}
+
+	m_cachedLength = Input.size();
+	HashCached(Input.data(), 0, LEAFCNT - 1, &Output[0]);
+}
+
+void BlakeTree::Destroy()
+{
+	if (!m_isDestroyed)
+	{
+		m_isDestroyed = true;
+		m_blockSize = 0;
+		m_cachedLength = 0;
+		m_leafLength = 0;
+
+		try
+		{
+			ArrayUtils::ClearVector(m_keyBlock);
+			ArrayUtils::ClearVector(m_leafBuffer);
+			ArrayUtils::ClearVector(m_nodeCount);
+			m_treeConfig256.fill(0);
+			m_treeConfig512.fill(0);
+
+			for (size_t i = 0; i < m_nodeHashes.size(); ++i)
+				ArrayUtils::ClearVector(m_nodeHashes[i]);
+
+			for (size_t i = 0; i < m_treeCache.size(); ++i)
+				ArrayUtils::ClearVector(m_treeCache[i]);
+
+			m_treeParams.Reset();
+		}
+		catch (std::exception& ex)
+		{
+			throw CryptoDigestException("BlakeTree:Destroy", "Could not clear all variables!", std::string(ex.what()));
+		}
+	}
+}
+
+size_t BlakeTree::Finalize(byte* Output)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	const size_t INRLEN = m_treeParams.InnerLength();
+	std::vector<byte> hashes;
+
+	// the buffered leaves end the message; an empty message is hashed as one empty leaf
+	HashNodes(&m_leafBuffer[0], m_leafLength, m_treeParams.LeafLength(), 0, true, hashes);
+	m_nodeHashes[0].insert(m_nodeHashes[0].end(), hashes.begin(), hashes.end());
+
+	size_t lvl = 0;
+
+	while (true)
+	{
+		const size_t NODECNT = m_nodeHashes[lvl].size() / INRLEN;
+
+		// the parent level holds a single node; it is the root
+		if (FNOUT == 0 || lvl + 2 >= m_treeParams.MaxDepth() || (NODECNT <= FNOUT && m_nodeCount[lvl + 1] == 0))
+		{
+			std::vector<byte> root(m_blockSize / 2);
+			HashNode(&m_nodeHashes[lvl][0], m_nodeHashes[lvl].size(), 0, lvl + 1, true, &root[0], root.size());
+			memcpy(Output, &root[0], m_treeParams.OutputSize());
+			break;
+		}
+
+		HashNodes(&m_nodeHashes[lvl][0], m_nodeHashes[lvl].size(), FNOUT * INRLEN, lvl + 1, true, hashes);
+		m_nodeHashes[lvl + 1].insert(m_nodeHashes[lvl + 1].end(), hashes.begin(), hashes.end());
+		++lvl;
+	}
+
+	// the cached tree does not depend on the streaming state
+	ResetTree();
+
+	return m_treeParams.OutputSize();
+}
+
+size_t BlakeTree::Finalize(std::vector<byte> &Output, const size_t OutOffset)
+{
+	if (Output.size() < OutOffset + m_treeParams.OutputSize())
+		throw CryptoDigestException("BlakeTree:Finalize", "The Output buffer is too short!");
+
+	return Finalize(&Output[OutOffset]);
+}
+
+void BlakeTree::Initialize(ISymmetricKey &MacKey)
+{
+	const size_t DGTLEN = (m_digestType == Digests::Blake256) ? B2S_DIGEST : B2B_DIGEST;
+	const size_t SLTLEN = DGTLEN / 4;
+
+	if (MacKey.Key().size() < DGTLEN / 2 || MacKey.Key().size() > DGTLEN)
+		throw CryptoDigestException("BlakeTree:Initialize", "Mac Key has invalid length!");
+	if (MacKey.Nonce().size() != 0 && MacKey.Nonce().size() != SLTLEN)
+		throw CryptoDigestException("BlakeTree:Initialize", "Salt has invalid length!");
+	if (MacKey.Info().size() != 0 && MacKey.Info().size() != SLTLEN)
+		throw CryptoDigestException("BlakeTree:Initialize", "Info has invalid length!");
+
+	m_treeParams.KeyLength() = static_cast<byte>(MacKey.Key().size());
+	LoadTree();
+
+	// the salt and personalization words follow the base configuration
+	if (m_digestType == Digests::Blake256)
+	{
+		if (MacKey.Nonce().size() != 0)
+		{
+			m_treeConfig256[4] = IntUtils::BytesToLe32(MacKey.Nonce(), 0);
+			m_treeConfig256[5] = IntUtils::BytesToLe32(MacKey.Nonce(), 4);
+		}
+
+		if (MacKey.Info().size() != 0)
+		{
+			m_treeConfig256[6] = IntUtils::BytesToLe32(MacKey.Info(), 0);
+			m_treeConfig256[7] = IntUtils::BytesToLe32(MacKey.Info(), 4);
+		}
+	}
+	else
+	{
+		if (MacKey.Nonce().size() != 0)
+		{
+			m_treeConfig512[4] = IntUtils::BytesToLe64(MacKey.Nonce(), 0);
+			m_treeConfig512[5] = IntUtils::BytesToLe64(MacKey.Nonce(), 8);
+		}
+
+		if (MacKey.Info().size() != 0)
+		{
+			m_treeConfig512[6] = IntUtils::BytesToLe64(MacKey.Info(), 0);
+			m_treeConfig512[7] = IntUtils::BytesToLe64(MacKey.Info(), 8);
+		}
+	}
+
+	// the key is prepended as a full block to every leaf
+	m_keyBlock.resize(m_blockSize);
+	memset(&m_keyBlock[0], 0, m_keyBlock.size());
+	memcpy(&m_keyBlock[0], &MacKey.Key()[0], MacKey.Key().size());
+}
+
+void BlakeTree::JoinRange(BlakeTreeRange &Range)
+{
+	// in message order; the nodes before the first group of each level rise to the top, and the incomplete groups at the end descend
+	for (size_t i = 0; i < Range.HeadNodes.size(); ++i)
+	{
+		if (Range.HeadNodes[i].size() != 0)
+			JoinNodes(i, Range.HeadOffset[i], Range.HeadNodes[i]);
+	}
+
+	for (size_t i = Range.TailNodes.size(); i != 0; --i)
+	{
+		if (Range.TailNodes[i - 1].size() != 0)
+			JoinNodes(i - 1, Range.TailOffset[i - 1], Range.TailNodes[i - 1]);
+	}
+
+	Range = BlakeTreeRange(Range.LeafOffset + Range.LeafCount);
+}
+
+void BlakeTree::ParallelMaxDegree(size_t Degree)
+{
+	if (Degree == 0)
+		throw CryptoDigestException("BlakeTree:ParallelMaxDegree", "Parallel degree can not be zero!");
+
+	m_parallelProfile.SetMaxDegree(Degree);
+	m_parallelProfile.IsParallel() = (Degree > 1 && m_parallelProfile.ProcessorCount() > 1);
+	m_leafBuffer.resize((m_parallelProfile.IsParallel() ? Degree : 1) * m_treeParams.LeafLength());
+
+	ResetTree();
+}
+
+void BlakeTree::Reset()
+{
+	// a cached tree was hashed with the previous key and parameters
+	for (size_t i = 0; i < m_treeCache.size(); ++i)
+		ArrayUtils::ClearVector(m_treeCache[i]);
+
+	m_treeCache.clear();
+	m_cachedLength = 0;
+
+	ResetTree();
+}
+
+void BlakeTree::ResetTree()
+{
+	m_leafLength = 0;
+	memset(&m_leafBuffer[0], 0, m_leafBuffer.size());
+
+	for (size_t i = 0; i < m_nodeHashes.size(); ++i)
+	{
+		m_nodeCount[i] = 0;
+		m_nodeHashes[i].clear();
+	}
+}
+
+void BlakeTree::UpdateCached(const std::vector<byte> &Input, size_t InOffset, size_t Length, std::vector<byte> &Output)
+{
+	if (m_treeCache.size() == 0)
+		throw CryptoDigestException("BlakeTree:UpdateCached", "There is no cached tree! Call ComputeCached first.");
+	if (Input.size() != m_cachedLength)
+		throw CryptoDigestException("BlakeTree:UpdateCached", "The message length does not match the cached tree!");
+	if (InOffset + Length > Input.size())
+		throw CryptoDigestException("BlakeTree:UpdateCached", "The modified range exceeds the message length!");
+
+	const size_t LEAFLEN = m_treeParams.LeafLength();
+	const size_t LEAFLST = (m_treeCache[0].size() / m_treeParams.InnerLength()) - 1;
+	const size_t LSTPOS = (Length == 0) ? InOffset : InOffset + Length - 1;
+	const size_t FRSTLEAF = (InOffset / LEAFLEN < LEAFLST) ? InOffset / LEAFLEN : LEAFLST;
+	const size_t LSTLEAF = (LSTPOS / LEAFLEN < LEAFLST) ? LSTPOS / LEAFLEN : LEAFLST;
+
+	if (Output.size() < m_treeParams.OutputSize())
+		Output.resize(m_treeParams.OutputSize());
+
+	HashCached(Input.data(), FRSTLEAF, LSTLEAF, &Output[0]);
+}
+
+void BlakeTree::UpdateRange(BlakeTreeRange &Range, const byte* Input, size_t Length)
+{
+	const size_t INRLEN = m_treeParams.InnerLength();
+	const size_t LEAFLEN = m_treeParams.LeafLength();
+
+	if (Length % LEAFLEN != 0)
+		throw CryptoDigestException("BlakeTree:UpdateRange", "The input length must be a multiple of the leaf length!");
+
+	if (Range.TailNodes.size() != m_treeParams.MaxDepth())
+	{
+		Range.HeadNodes.resize(m_treeParams.MaxDepth());
+		Range.HeadOffset.resize(m_treeParams.MaxDepth(), 0);
+		Range.TailNodes.resize(m_treeParams.MaxDepth());
+		Range.TailOffset.resize(m_treeParams.MaxDepth(), 0);
+	}
+
+	byte leafHash[B2B_DIGEST];
+
+	// the leaves are hashed on the calling thread; the caller runs one range per thread
+	for (size_t i = 0; i < Length; i += LEAFLEN)
+	{
+		const ulong LEAFPOS = Range.LeafOffset + Range.LeafCount;
+
+		HashNode(Input + i, LEAFLEN, LEAFPOS, 0, false, leafHash, INRLEN);
+		AddRangeNode(Range, 0, LEAFPOS, leafHash);
+		++Range.LeafCount;
+	}
+}
+
+void BlakeTree::Update(byte Input)
+{
+	std::vector<byte> inp(1, Input);
+	Update(inp, 0, 1);
+}
+
+void BlakeTree::Update(const byte* Input, size_t Length)
+{
+	const size_t LEAFLEN = m_treeParams.LeafLength();
+	std::vector<byte> hashes;
+
+	while (Length != 0)
+	{
+		// more input follows a full buffer, so none of its leaves is the last
+		if (m_leafLength == m_leafBuffer.size())
+		{
+			HashNodes(&m_leafBuffer[0], m_leafLength, LEAFLEN, 0, false, hashes);
+			AddNodes(0, hashes);
+			m_leafLength = 0;
+		}
+
+		// hash whole leaves in place, holding back at least one byte for the final leaf
+		if (m_leafLength == 0 && Length > m_leafBuffer.size())
+		{
+			const size_t PRCLEN = ((Length - 1) / LEAFLEN) * LEAFLEN;
+
+			HashNodes(Input, PRCLEN, LEAFLEN, 0, false, hashes);
+			AddNodes(0, hashes);
+			Input += PRCLEN;
+			Length -= PRCLEN;
+		}
+
+		const size_t CPYLEN = (Length < m_leafBuffer.size() - m_leafLength) ? Length : m_leafBuffer.size() - m_leafLength;
+		memcpy(&m_leafBuffer[m_leafLength], Input, CPYLEN);
+		m_leafLength += CPYLEN;
+		Input += CPYLEN;
+		Length -= CPYLEN;
+	}
+}
+
+void BlakeTree::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length)
+{
+	if (Length == 0)
+		return;
+
+	Update(&Input[InOffset], Length);
+}
+
+//~~~Private Functions~~~//
+
+void BlakeTree::AddNodes(size_t Level, const std::vector<byte> &Hashes)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	const size_t INRLEN = m_treeParams.InnerLength();
+
+	m_nodeHashes[Level].insert(m_nodeHashes[Level].end(), Hashes.begin(), Hashes.end());
+
+	// the root level collects every node of the level below, and is hashed by Finalize
+	if (FNOUT == 0 || Level + 2 >= m_treeParams.MaxDepth())
+		return;
+
+	const size_t NODECNT = m_nodeHashes[Level].size() / INRLEN;
+
+	// a parent is complete, and not the last of its level, once a node follows its children
+	if (NODECNT > FNOUT)
+	{
+		const size_t PRCLEN = ((NODECNT - 1) / FNOUT) * FNOUT * INRLEN;
+		std::vector<byte> parents;
+
+		HashNodes(&m_nodeHashes[Level][0], PRCLEN, FNOUT * INRLEN, Level + 1, false, parents);
+		m_nodeHashes[Level].erase(m_nodeHashes[Level].begin(), m_nodeHashes[Level].begin() + PRCLEN);
+		AddNodes(Level + 1, parents);
+	}
+}
+
+void BlakeTree::AddRangeNode(BlakeTreeRange &Range, size_t Level, ulong NodeOffset, const byte* Hash)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	const size_t INRLEN = m_treeParams.InnerLength();
+	const bool GROUPED = (FNOUT != 0 && Level + 2 < m_treeParams.MaxDepth());
+
+	// the group of this node started before the range; the parent is hashed when the range is joined
+	if (GROUPED && Range.TailNodes[Level].size() == 0 && NodeOffset % FNOUT != 0)
+	{
+		if (Range.HeadNodes[Level].size() == 0)
+			Range.HeadOffset[Level] = NodeOffset;
+
+		Range.HeadNodes[Level].insert(Range.HeadNodes[Level].end(), Hash, Hash + INRLEN);
+
+		return;
+	}
+
+	if (Range.TailNodes[Level].size() == 0)
+		Range.TailOffset[Level] = NodeOffset;
+
+	Range.TailNodes[Level].insert(Range.TailNodes[Level].end(), Hash, Hash + INRLEN);
+
+	// the last leaf of the message follows every range, so a complete group is never the last node of its level
+	if (GROUPED && Range.TailNodes[Level].size() == FNOUT * INRLEN)
+	{
+		byte parent[B2B_DIGEST];
+
+		HashNode(&Range.TailNodes[Level][0], Range.TailNodes[Level].size(), NodeOffset / FNOUT, Level + 1, false, parent, INRLEN);
+		Range.TailNodes[Level].clear();
+		AddRangeNode(Range, Level + 1, NodeOffset / FNOUT, parent);
+	}
+}
+
+void BlakeTree::HashCached(const byte* Input, size_t First, size_t Last, byte* Output)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	const size_t INRLEN = m_treeParams.InnerLength();
+	const size_t LEAFLEN = m_treeParams.LeafLength();
+	size_t lstPos = ((Last + 1) * LEAFLEN < m_cachedLength) ? (Last + 1) * LEAFLEN : m_cachedLength;
+
+	// the leaves First to Last, then the parents of that range on every level
+	HashLevel(Input + (First * LEAFLEN), lstPos - (First * LEAFLEN), LEAFLEN, 0, First, Last == (m_treeCache[0].size() / INRLEN) - 1, &m_treeCache[0][First * INRLEN]);
+
+	for (size_t i = 1; i < m_treeCache.size(); ++i)
+	{
+		const size_t GRPLEN = FNOUT * INRLEN;
+
+		First /= FNOUT;
+		Last /= FNOUT;
+		lstPos = ((Last + 1) * GRPLEN < m_treeCache[i - 1].size()) ? (Last + 1) * GRPLEN : m_treeCache[i - 1].size();
+		HashLevel(&m_treeCache[i - 1][First * GRPLEN], lstPos - (First * GRPLEN), GRPLEN, i, First, Last == (m_treeCache[i].size() / INRLEN) - 1, &m_treeCache[i][First * INRLEN]);
+	}
+
+	const size_t TOPLVL = m_treeCache.size() - 1;
+	std::vector<byte> root(m_blockSize / 2);
+
+	HashNode(&m_treeCache[TOPLVL][0], m_treeCache[TOPLVL].size(), 0, TOPLVL + 1, true, &root[0], root.size());
+	memcpy(Output, &root[0], m_treeParams.OutputSize());
+}
+
+void BlakeTree::HashNode(const byte* Input, size_t Length, ulong NodeOffset, size_t NodeDepth, bool LastNode, byte* Output, size_t OutLength)
+{
+	if (m_digestType == Digests::Blake256)
+		HashNode256(Input, Length, NodeOffset, NodeDepth, LastNode, Output, OutLength);
+	else
+		HashNode512(Input, Length, NodeOffset, NodeDepth, LastNode, Output, OutLength);
+}
+
+void BlakeTree::HashNode256(const byte* Input, size_t Length, ulong NodeOffset, size_t NodeDepth, bool LastNode, byte* Output, size_t OutLength)
+{
+	const bool KEYED = (NodeDepth == 0 && m_keyBlock.size() != 0);
+	std::array<uint, CHAIN_SIZE> config(m_treeConfig256);
+	byte blkBuf[B2S_BLOCK] = { 0 };
+	Blake2sState state;
+
+	// the node offset is 48 bits; the high 16 bits share a word with the node depth and inner length
+	config[2] = static_cast<uint>(NodeOffset);
+	config[3] = (config[3] & 0xFF000000UL) | (static_cast<uint>(NodeDepth) << 16) | static_cast<uint>((NodeOffset >> 32) & 0xFFFF);
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+		state.H[i] = SCIV[i] ^ config[i];
+
+	if (KEYED && Length == 0)
+	{
+		// the key block is the only block of an empty leaf
+		state.F[0] = 0xFFFFFFFFUL;
+		state.F[1] = LastNode ? 0xFFFFFFFFUL : 0;
+		ArrayUtils::IncreaseLE32(state.T, B2S_BLOCK);
+		m_kernels->Compress64(&m_keyBlock[0], state, SCIV);
+	}
+	else
+	{
+		if (KEYED)
+		{
+			ArrayUtils::IncreaseLE32(state.T, B2S_BLOCK);
+			m_kernels->Compress64(&m_keyBlock[0], state, SCIV);
+		}
+
+		// compress all but the last block in place
+		while (Length > B2S_BLOCK)
+		{
+			ArrayUtils::IncreaseLE32(state.T, B2S_BLOCK);
+			m_kernels->Compress64(Input, state, SCIV);
+			Input += B2S_BLOCK;
+			Length -= B2S_BLOCK;
+		}
+
+		if (Length != 0)
+			memcpy(&blkBuf[0], Input, Length);
+
+		state.F[0] = 0xFFFFFFFFUL;
+		state.F[1] = LastNode ? 0xFFFFFFFFUL : 0;
+		ArrayUtils::IncreaseLE32(state.T, Length);
+		m_kernels->Compress64(&blkBuf[0], state, SCIV);
+	}
+
+	IntUtils::LeUL256ToBlock(state.H, &blkBuf[0]);
+	memcpy(Output, &blkBuf[0], OutLength);
+}
+
+void BlakeTree::HashNode512(const byte* Input, size_t Length, ulong NodeOffset, size_t NodeDepth, bool LastNode, byte* Output, size_t OutLength)
+{
+	const bool KEYED = (NodeDepth == 0 && m_keyBlock.size() != 0);
+	std::array<ulong, CHAIN_SIZE> config(m_treeConfig512);
+	byte blkBuf[B2B_BLOCK] = { 0 };
+	Blake2bState state;
+
+	config[1] = NodeOffset;
+	config[2] = (config[2] & ~0xFFULL) | static_cast<ulong>(NodeDepth);
+
+	for (size_t i = 0; i < CHAIN_SIZE; ++i)
+		state.H[i] = BCIV[i] ^ config[i];
+
+	if (KEYED && Length == 0)
+	{
+		// the key block is the only block of an empty leaf
+		state.F[0] = 0xFFFFFFFFFFFFFFFFULL;
+		state.F[1] = LastNode ? 0xFFFFFFFFFFFFFFFFULL : 0;
+		ArrayUtils::IncreaseLE64(state.T, B2B_BLOCK);
+		m_kernels->Compress128(&m_keyBlock[0], state, BCIV);
+	}
+	else
+	{
+		if (KEYED)
+		{
+			ArrayUtils::IncreaseLE64(state.T, B2B_BLOCK);
+			m_kernels->Compress128(&m_keyBlock[0], state, BCIV);
+		}
+
+		// compress all but the last block in place
+		while (Length > B2B_BLOCK)
+		{
+			ArrayUtils::IncreaseLE64(state.T, B2B_BLOCK);
+			m_kernels->Compress128(Input, state, BCIV);
+			Input += B2B_BLOCK;
+			Length -= B2B_BLOCK;
+		}
+
+		if (Length != 0)
+			memcpy(&blkBuf[0], Input, Length);
+
+		state.F[0] = 0xFFFFFFFFFFFFFFFFULL;
+		state.F[1] = LastNode ? 0xFFFFFFFFFFFFFFFFULL : 0;
+		ArrayUtils::IncreaseLE64(state.T, Length);
+		m_kernels->Compress128(&blkBuf[0], state, BCIV);
+	}
+
+	IntUtils::LeULL512ToBlock(state.H, &blkBuf[0]);
+	memcpy(Output, &blkBuf[0], OutLength);
+}
+
+void BlakeTree::HashLevel(const byte* Input, size_t Length, size_t NodeLength, size_t Level, ulong NodeOffset, bool LastNode, byte* Output)
+{
+	const size_t INRLEN = m_treeParams.InnerLength();
+	const size_t NODECNT = (Length == 0) ? 1 : (Length + NodeLength - 1) / NodeLength;
+	const size_t THDCNT = m_parallelProfile.IsParallel() ? ((NODECNT < m_parallelProfile.ParallelMaxDegree()) ? NODECNT : m_parallelProfile.ParallelMaxDegree()) : 1;
+
+	// each thread hashes a contiguous range of the nodes; the last node of the range sets the last node flag if it ends the level
+	const std::function<void(size_t)> HASHRNG = [this, Input, Length, NodeLength, Level, NodeOffset, LastNode, Output, INRLEN, NODECNT, THDCNT](size_t i)
+	{
+		const size_t NODEEND = ((i + 1) * NODECNT) / THDCNT;
+
+		for (size_t j = (i * NODECNT) / THDCNT; j < NODEEND; ++j)
+		{
+			const size_t NODEPOS = j * NodeLength;
+			const size_t NODELEN = (Length - NODEPOS < NodeLength) ? Length - NODEPOS : NodeLength;
+
+			HashNode(Input + NODEPOS, NODELEN, NodeOffset + j, Level, LastNode && j == NODECNT - 1, Output + (j * INRLEN), INRLEN);
+		}
+	};
+
+	if (THDCNT > 1)
+		ParallelUtils::ParallelFor(0, THDCNT, HASHRNG);
+	else
+		HASHRNG(0);
+}
+
+void BlakeTree::HashNodes(const byte* Input, size_t Length, size_t NodeLength, size_t Level, bool LastNode, std::vector<byte> &Output)
+{
+	const size_t NODECNT = (Length == 0) ? 1 : (Length + NodeLength - 1) / NodeLength;
+
+	// the nodes continue the level from the last hashed node
+	Output.resize(NODECNT * m_treeParams.InnerLength());
+	HashLevel(Input, Length, NodeLength, Level, m_nodeCount[Level], LastNode, &Output[0]);
+	m_nodeCount[Level] += NODECNT;
+}
+
+void BlakeTree::JoinNodes(size_t Level, ulong NodeOffset, const std::vector<byte> &Hashes)
+{
+	const size_t FNOUT = m_treeParams.FanOut();
+	const size_t INRLEN = m_treeParams.InnerLength();
+
+	if (m_leafLength != 0)
+		throw CryptoDigestException("BlakeTree:JoinRange", "A range can not follow a partial leaf!");
+
+	// the nodes start a group on every level below; the complete groups pending below are hashed into their parents first
+	for (size_t i = 0; i < Level; ++i)
+	{
+		if (m_nodeHashes[i].size() == FNOUT * INRLEN)
+		{
+			std::vector<byte> parents;
+
+			HashNodes(&m_nodeHashes[i][0], m_nodeHashes[i].size(), FNOUT * INRLEN, i + 1, false, parents);
+			m_nodeHashes[i].clear();
+			AddNodes(i + 1, parents);
+		}
+
+		if (m_nodeHashes[i].size() != 0)
+			throw CryptoDigestException("BlakeTree:JoinRange", "The range does not continue the message!");
+	}
+
+	if (m_nodeCount[Level] != NodeOffset)
+		throw CryptoDigestException("BlakeTree:JoinRange", "The range does not continue the message!");
+
+	// the levels below count the nodes the range hashed into these
+	ulong nodeCnt = Hashes.size() / INRLEN;
+
+	for (size_t i = Level + 1; i != 0; --i)
+	{
+		m_nodeCount[i - 1] += nodeCnt;
+		nodeCnt *= FNOUT;
+	}
+
+	AddNodes(Level, Hashes);
+}
+
+void BlakeTree::LoadTree()
+{
+	const size_t DEPTH = m_treeParams.MaxDepth();
+
+	// GetConfig reads the salt and personalization from the distribution code; 40 bytes with Blake2b, 16 with Blake2s
+	if (m_treeParams.DistributionCode().size() < 40)
+		m_treeParams.DistributionCode().resize(40, 0);
+
+	// per-node fields are written by HashNode; the base configuration has a node offset and depth of zero
+	m_treeParams.NodeDepth() = 0;
+	m_treeParams.NodeOffset() = 0;
+
+	if (m_digestType == Digests::Blake256)
+		m_treeParams.GetConfig<uint>(m_treeConfig256);
+	else
+		m_treeParams.GetConfig<ulong>(m_treeConfig512);
+
+	m_nodeCount.resize(DEPTH);
+	m_nodeHashes.resize(DEPTH);
+	m_leafBuffer.resize((m_parallelProfile.IsParallel() ? m_parallelProfile.ParallelMaxDegree() : 1) * m_treeParams.LeafLength());
+
+	Reset();
+}
+
+NAMESPACE_DIGESTEND
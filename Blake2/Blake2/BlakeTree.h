@@ -0,0 +1,365 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//
+// Principal Algorithms:
+// An implementation of Blake2, designed by Jean-Philippe Aumasson, Samuel Neves, Zooko Wilcox-O'Hearn, and Christian Winnerlein.
+// Blake2 whitepaper <a href="https://blake2.net/blake2.pdf">BLAKE2: simpler, smaller, fast as MD5</a>.
+//
+// Implementation Details:
+// An implementation of the Blake2 tree hashing mode, with Blake2b or Blake2s nodes.
+// Based on the tree hashing section (2.10) of the Blake2 whitepaper.
+
+#ifndef _CEX_BLAKETREE_H
+#define _CEX_BLAKETREE_H
+
+#include "BlakeDispatch.h"
+#include "BlakeParams.h"
+#include "BlakeState.h"
+#include "IDigest.h"
+#include "ISymmetricKey.h"
+#include <array>
+
+NAMESPACE_DIGEST
+
+using Key::Symmetric::ISymmetricKey;
+
+/// <summary>
+/// The partial subtrees of a contiguous range of tree leaves, hashed independently of the streaming state of a BlakeTree.
+/// <para>Filled with BlakeTree::UpdateRange, on any thread, and added to the tree in message order with BlakeTree::JoinRange.
+/// Complete groups of nodes are hashed into their parents within the range; only the nodes whose groups cross the range boundaries are held.</para>
+/// </summary>
+struct BlakeTreeRange
+{
+	// per level; the nodes that precede the first group starting within the range
+	std::vector<std::vector<byte>> HeadNodes;
+	std::vector<ulong> HeadOffset;
+	ulong LeafCount;
+	ulong LeafOffset;
+	// per level; the nodes of the incomplete group at the end of the range
+	std::vector<std::vector<byte>> TailNodes;
+	std::vector<ulong> TailOffset;
+
+	explicit BlakeTreeRange(ulong FirstLeaf = 0)
+		:
+		HeadNodes(0),
+		HeadOffset(0),
+		LeafCount(0),
+		LeafOffset(FirstLeaf),
+		TailNodes(0),
+		TailOffset(0)
+	{
+	}
+};
+
+/// <summary>
+/// An implementation of the Blake2 tree hashing mode, with an arbitrary fanout, depth, leaf length and inner hash length
+/// </summary>
+///
+/// <example>
+/// <description>Hashing with a fanout of 8, 1MiB leaves, and unlimited depth:</description>
+/// <code>
+/// BlakeParams params(64, 255, 8, 0, 64);
+/// params.LeafLength() = 1024 * 1024;
+/// BlakeTree dgt(Digests::Blake512, params);
+/// std:vector&lt;byte&gt; hash(dgt.DigestSize(), 0);
+/// dgt.Compute(input, hash);
+/// </code>
+/// </example>
+///
+/// <remarks>
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>The message is split into contiguous leaves of LeafLength bytes at depth 0; each level above hashes up to FanOut digests of InnerLength bytes from the level below, and the last node of every level sets the last node flag.</description></item>
+/// <item><description>A FanOut of zero is unlimited; the root hashes every leaf. A MaxDepth of 255 is unlimited; otherwise the node at depth MaxDepth - 1 is the root, and hashes every node of the level below.</description></item>
+/// <item><description>The tree always has a root above the leaves; an empty message is hashed as a single empty leaf.</description></item>
+/// <item><description>The leaves, and the nodes of each level, are hashed in parallel by ParallelUtils::ParallelFor, split into ParallelMaxDegree() ranges; the output depends only on the tree parameters, not on the thread count.</description></item>
+/// <item><description>Parent nodes are hashed as soon as a later sibling shows they are not the last node of their level, so the pending digests held between Update calls are bounded by the FanOut and depth.</description></item>
+/// <item><description>The NodeOffset and NodeDepth parameters are set per node; node offsets are 64 bits wide with Blake2b, and 48 bits with Blake2s.</description></item>
+/// <item><description>A MAC key is prepended as a full block to every leaf.</description></item>
+/// <item><description>UpdateRange hashes a contiguous range of whole leaves independently of the streaming state, and may be called on many threads at once with separate ranges; complete subtrees are reduced within the range, and JoinRange adds the remaining nodes of each range to the tree in message order. A large file can be hashed by several readers, each reading its own part of the file.</description></item>
+/// <item><description>ComputeCached retains the inner hash of every node; after bytes of the message change, UpdateCached rehashes only the modified leaves and their paths to the root.</description></item>
+/// <item><description>The <see cref="Finalize(byte[], size_t)"/> method resets the internal state.</description></item>
+/// </list>
+///
+/// <description>Guiding Publications:</description>
+/// <list type="number">
+/// <item><description>Blake2 whitepaper <a href="https://blake2.net/blake2.pdf">BLAKE2: simpler, smaller, fast as MD5</a>, section 2.10 Tree hashing.</description></item>
+/// <item><description>Blake2 on <a href="https://github.com/BLAKE2/BLAKE2">Github</a>.</description></item>
+/// </list>
+/// </remarks>
+class BlakeTree : public IDigest
+{
+private:
+
+	static const size_t B2B_BLOCK = 128;
+	static const size_t B2B_DIGEST = 64;
+	static const size_t B2S_BLOCK = 64;
+	static const size_t B2S_DIGEST = 32;
+	static const uint CHAIN_SIZE = 8;
+	static const byte DEF_FANOUT = 8;
+	static const uint DEF_LEAFSIZE = 65536;
+	static const byte DEF_MAXDEPTH = 255;
+	// size of reserved state buffer subtracted from parallel size calculations
+	static const size_t STATE_PRECACHED = 2048;
+
+	size_t m_blockSize;
+	size_t m_cachedLength;
+	Digests m_digestType;
+	bool m_isDestroyed;
+	const BlakeDispatch::Kernels* m_kernels;
+	std::vector<byte> m_keyBlock;
+	std::vector<byte> m_leafBuffer;
+	size_t m_leafLength;
+	std::vector<ulong> m_nodeCount;
+	std::vector<std::vector<byte>> m_nodeHashes;
+	ParallelOptions m_parallelProfile;
+	std::vector<std::vector<byte>> m_treeCache;
+	std::array<uint, CHAIN_SIZE> m_treeConfig256;
+	std::array<ulong, CHAIN_SIZE> m_treeConfig512;
+	BlakeParams m_treeParams;
+
+public:
+
+	BlakeTree(const BlakeTree&) = delete;
+	BlakeTree& operator=(const BlakeTree&) = delete;
+	BlakeTree& operator=(BlakeTree&&) = delete;
+
+	//~~~Properties~~~//
+
+	/// <summary>
+	/// Get: The node digests internal blocksize in bytes
+	/// </summary>
+	virtual size_t BlockSize() { return m_blockSize; }
+
+	/// <summary>
+	/// Get: Size of returned digest in bytes
+	/// </summary>
+	virtual size_t DigestSize() { return m_treeParams.OutputSize(); }
+
+	/// <summary>
+	/// Get: The node digests type name
+	/// </summary>
+	virtual const Digests Enumeral() { return m_digestType; }
+
+	/// <summary>
+	/// Get: The length of a leaf in bytes
+	/// </summary>
+	const size_t LeafLength() { return m_treeParams.LeafLength(); }
+
+	/// <summary>
+	/// Get: Processor parallelization availability.
+	/// <para>Indicates whether the leaves and nodes are hashed on multiple threads.</para>
+	/// </summary>
+	virtual const bool IsParallel() { return m_parallelProfile.IsParallel(); }
+
+	/// <summary>
+	/// Get: The digests class name
+	/// </summary>
+	virtual const std::string Name()
+	{
+		return m_digestType == Digests::Blake256 ? "BlakeTree256" : "BlakeTree512";
+	}
+
+	/// <summary>
+	/// Get: Parallel block size; the number of bytes buffered before a batch of leaves is hashed
+	/// </summary>
+	virtual const size_t ParallelBlockSize() { return m_leafBuffer.size(); }
+
+	/// <summary>
+	/// Get/Set: Contains parallel settings and SIMD capability flags in a ParallelOptions structure.
+	/// <para>The number of threads can be set with the ParallelMaxDegree(size_t) function.</para>
+	/// </summary>
+	virtual ParallelOptions &ParallelProfile() { return m_parallelProfile; }
+
+	//~~~Constructor~~~//
+
+	/// <summary>
+	/// Initialize the tree with the default parameters; a fanout of 8, unlimited depth, 64KiB leaves, and full length inner hashes
+	/// <para>Leaves are hashed on ProcessorCount() threads when more than one processor is available; see ParallelMaxDegree(size_t).</para>
+	/// </summary>
+	///
+	/// <param name="DigestType">The node digest; Blake512 (Blake2b), or Blake256 (Blake2s)</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest type is not supported</exception>
+	explicit BlakeTree(Digests DigestType = Digests::Blake512);
+
+	/// <summary>
+	/// Initialize the tree with a BlakeParams structure
+	/// <para>Leaves are hashed on ProcessorCount() threads when more than one processor is available; see ParallelMaxDegree(size_t).</para>
+	/// </summary>
+	///
+	/// <param name="DigestType">The node digest; Blake512 (Blake2b), or Blake256 (Blake2s)</param>
+	/// <param name="Params">The tree configuration; OutputSize, FanOut, MaxDepth, LeafLength and InnerLength are used</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest type or a tree parameter is invalid</exception>
+	BlakeTree(Digests DigestType, BlakeParams &Params);
+
+	/// <summary>
+	/// Finalize objects
+	/// </summary>
+	virtual ~BlakeTree();
+
+	//~~~Public Functions~~~//
+
+	/// <summary>
+	/// Process the message data and return the Hash value
+	/// </summary>
+	///
+	/// <param name="Input">The message input data</param>
+	/// <param name="Output">The hash value output array</param>
+	virtual void Compute(const std::vector<byte> &Input, std::vector<byte> &Output);
+
+	/// <summary>
+	/// Hash a message and retain the inner hash of every node, so that later changes to the message can be rehashed by UpdateCached.
+	/// <para>Replaces any previously cached tree; the streaming state of Update and Finalize is not affected.</para>
+	/// </summary>
+	///
+	/// <param name="Input">The message input data</param>
+	/// <param name="Output">The hash value output array</param>
+	void ComputeCached(const std::vector<byte> &Input, std::vector<byte> &Output);
+
+	/// <summary>
+	/// Release all resources associated with the object
+	/// </summary>
+	virtual void Destroy();
+
+	/// <summary>
+	/// Hash the remaining leaves and tree levels, and return the root hash value
+	/// </summary>
+	///
+	/// <param name="Output">The Hash output value array</param>
+	/// <param name="OutOffset">The starting offset within the Output array</param>
+	///
+	/// <returns>Size of Hash value</returns>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the output buffer is too short</exception>
+	virtual size_t Finalize(std::vector<byte> &Output, const size_t OutOffset);
+
+	/// <summary>
+	/// Hash the remaining leaves and tree levels, and write the root hash value to caller memory
+	/// </summary>
+	///
+	/// <param name="Output">Pointer to the destination; must have room for DigestSize() bytes</param>
+	///
+	/// <returns>Size of Hash value</returns>
+	virtual size_t Finalize(byte* Output);
+
+	/// <summary>
+	/// Initialize the digest as a MAC code generator
+	/// </summary>
+	///
+	/// <param name="MacKey">The input key parameters.
+	/// <para>The input Key must be a maximum size of the node digest size, and minimum half the digest size.
+	/// The Nonce and Info keys are optional, and fill the salt and personalization parameters.</para></param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if a key parameter has an invalid length</exception>
+	virtual void Initialize(ISymmetricKey &MacKey);
+
+	/// <summary>
+	/// Add the nodes of a range hashed by UpdateRange to the tree; the ranges of a message are joined in order, and clear the range.
+	/// <para>The range must continue the message; the leaves hashed or joined so far must end where the range starts, and Update can not have left a partial leaf.
+	/// The message is completed with Update and Finalize, which hash the last leaf.</para>
+	/// </summary>
+	///
+	/// <param name="Range">The hashed range of leaves</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the range does not continue the message</exception>
+	void JoinRange(BlakeTreeRange &Range);
+
+	/// <summary>
+	/// Set the number of threads used to hash the leaves and nodes; does not change the hash output
+	/// </summary>
+	///
+	/// <param name="Degree">The maximum number of threads; a degree of one hashes on the calling thread</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the degree is zero</exception>
+	virtual void ParallelMaxDegree(size_t Degree);
+
+	/// <summary>
+	/// Reset the internal state, and discard the tree cached by ComputeCached
+	/// </summary>
+	virtual void Reset();
+
+	/// <summary>
+	/// Rehash a modified range of the message cached by ComputeCached, and return the new root hash value.
+	/// <para>Only the leaves that overlap the range, and the nodes on their paths to the root are hashed;
+	/// with a bounded FanOut, a change within one leaf costs the leaf and one node per level.</para>
+	/// </summary>
+	///
+	/// <param name="Input">The complete message, containing the modified bytes; the length can not change</param>
+	/// <param name="InOffset">The starting offset of the modified bytes</param>
+	/// <param name="Length">The number of modified bytes</param>
+	/// <param name="Output">The hash value output array</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if there is no cached tree since the last Initialize or Reset, the message length has changed, or the range is out of bounds</exception>
+	void UpdateCached(const std::vector<byte> &Input, size_t InOffset, size_t Length, std::vector<byte> &Output);
+
+	/// <summary>
+	/// Hash whole leaves of a range, continuing from the last leaf of the range; does not change the streaming state, and is thread safe for separate ranges.
+	/// <para>None of the leaves can be the last leaf of the message; the message is ended with Update and Finalize after the ranges are joined.</para>
+	/// </summary>
+	///
+	/// <param name="Range">The range state; the first leaf of the range is set by its constructor</param>
+	/// <param name="Input">Pointer to the leaf data</param>
+	/// <param name="Length">Amount of data to process in bytes; a multiple of LeafLength()</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the length is not a multiple of the leaf length</exception>
+	void UpdateRange(BlakeTreeRange &Range, const byte* Input, size_t Length);
+
+	/// <summary>
+	/// Update the digest with a single byte
+	/// </summary>
+	///
+	/// <param name="Input">Input byte</param>
+	virtual void Update(byte Input);
+
+	/// <summary>
+	/// Update the buffer
+	/// </summary>
+	///
+	/// <param name="Input">Input data</param>
+	/// <param name="InOffset">The starting offset within the Input array</param>
+	/// <param name="Length">Amount of data to process in bytes</param>
+	virtual void Update(const std::vector<byte> &Input, size_t InOffset, size_t Length);
+
+	/// <summary>
+	/// Update the buffer from caller memory; whole leaves are hashed in place
+	/// </summary>
+	///
+	/// <param name="Input">Pointer to the input data</param>
+	/// <param name="Length">Amount of data to process in bytes</param>
+	virtual void Update(const byte* Input, size_t Length);
+
+private:
+
+	void AddNodes(size_t Level, const std::vector<byte> &Hashes);
+	void AddRangeNode(BlakeTreeRange &Range, size_t Level, ulong NodeOffset, const byte* Hash);
+	void HashCached(const byte* Input, size_t First, size_t Last, byte* Output);
+	void HashLevel(const byte* Input, size_t Length, size_t NodeLength, size_t Level, ulong NodeOffset, bool LastNode, byte* Output);
+	void HashNode(const byte* Input, size_t Length, ulong NodeOffset, size_t NodeDepth, bool LastNode, byte* Output, size_t OutLength);
+	void HashNode256(const byte* Input, size_t Length, ulong NodeOffset, size_t NodeDepth, bool LastNode, byte* Output, size_t OutLength);
+	void HashNode512(const byte* Input, size_t Length, ulong NodeOffset, size_t NodeDepth, bool LastNode, byte* Output, size_t OutLength);
+	void HashNodes(const byte* Input, size_t Length, size_t NodeLength, size_t Level, bool LastNode, std::vector<byte> &Output);
+	void JoinNodes(size_t Level, ulong NodeOffset, const std::vector<byte> &Hashes);
+	void LoadTree();
+	void ResetTree();
+};
+
+NAMESPACE_DIGESTEND
+#endif
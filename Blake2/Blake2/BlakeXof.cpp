@@ -0,0 +1,472 @@
+#include "BlakeXof.h"
+#include "ArrayUtils.h"
+#include "IntUtils.h"
+#include "ParallelUtils.h"
+
+NAMESPACE_DIGEST
+
+using Utility::ArrayUtils;
+using Utility::IntUtils;
+using Utility::ParallelUtils;
+
+static const std::vector<ulong> BCIV = { 0x6A09E667F3BCC908UL, 0xBB67AE8584CAA73BUL, 0x3C6EF372FE94F82BUL, 0xA54FF53A5F1D36F1UL,
+	0x510E527FADE682D1UL, 0x9B05688C2B3E6C1FUL, 0x1F83D9ABFB41BD6BUL, 0x5BE0CD19137E2179UL };
+
+static const std::vector<uint> SCIV = { 0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+	0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL };
+
+//~~~Constructor~~~//
+
+BlakeXof::BlakeXof(Digests DigestType, uint OutputLength, bool Parallel)
+	:
+	m_blockSize(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK),
+	m_digestType(DigestType),
+	m_isDestroyed(false),
+	m_kernels(&BlakeDispatch::Get()),
+	m_keyBlock(0),
+	m_msgBuffer(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK),
+	m_msgLength(0),
+	m_outputLength(OutputLength),
+	m_parallelProfile(DigestType == Digests::Blake256 ? B2S_BLOCK : B2B_BLOCK, false, STATE_PRECACHED, false),
+	m_rootConfig256(),
+	m_rootConfig512(),
+	m_rootState256(),
+	m_rootState512()
+{
+	if (m_digestType != Digests::Blake256 && m_digestType != Digests::Blake512)
+		throw CryptoDigestException("BlakeXof:Ctor", "The digest type is not supported! Must be Blake256 or Blake512.");
+	if (OutputLength == 0 || OutputLength > (m_digestType == Digests::Blake256 ? B2S_MAXOUT : B2B_MAXOUT))
+		throw CryptoDigestException("BlakeXof:Ctor", "The OutputLength is invalid! Must be between 1 and 4294967294 with Blake512, or 65534 with Blake256.");
+
+	if (m_parallelProfile.IsParallel())
+		m_parallelProfile.IsParallel() = Parallel;
+
+	LoadConfig(0);
+	Reset();
+}
+
+BlakeXof::~BlakeXof()
+{
+	Destroy();
+}
+
+//~~~Public Functions~~~//
+
+void BlakeXof::Compute(const std::vector<byte> &Input, std::vector<byte> &Output)
+{
+	if (Output.size() < m_outputLength)
+		Output.resize(m_outputLength);
+
+	Update(Input, 0, Input.size());
+	Finalize(Output, 0);
+}
+
+void BlakeXof::Destroy()
+{
+	if (!m_isDestroyed)
+	{
+		m_isDestroyed = true;
+		m_blockSize = 0;
+		m_msgLength = 0;
+		m_outputLength = 0;
+
+		try
+		{
+			ArrayUtils::ClearVector(m_keyBlock);
+			ArrayUtils::ClearVector(m_msgBuffer);
+			m_rootConfig256.fill(0);
+			m_rootConfig512.fill(0);
+			m_rootState256.Reset();
+			m_rootState512.Reset();
+		}
+		catch (std::exception& ex)
+		{
+			throw CryptoDigestException("BlakeXof:Destroy", "Could not clear all variables!", std::string(ex.what()));
+		}
+	}
+}
+
+size_t BlakeXof::Finalize(byte* Output)
+{
+	byte root[B2B_DIGEST];
+
+	if (m_msgLength < m_blockSize)
+		memset(&m_msgBuffer[m_msgLength], 0, m_blockSize - m_msgLength);
+
+	// the root node hashes the message; its digest is the input of every output block
+	if (m_digestType == Digests::Blake256)
+	{
+		ArrayUtils::IncreaseLE32(m_rootState256.T, m_msgLength);
+		m_rootState256.F[0] = 0xFFFFFFFFUL;
+		m_kernels->Compress64(&m_msgBuffer[0], m_rootState256, SCIV);
+		IntUtils::LeUL256ToBlock(m_rootState256.H, &root[0]);
+	}
+	else
+	{
+		ArrayUtils::IncreaseLE64(m_rootState512.T, m_msgLength);
+		m_rootState512.F[0] = 0xFFFFFFFFFFFFFFFFULL;
+		m_kernels->Compress128(&m_msgBuffer[0], m_rootState512, BCIV);
+		IntUtils::LeULL512ToBlock(m_rootState512.H, &root[0]);
+	}
+
+	Expand(&root[0], Output);
+	memset(&root[0], 0, sizeof(root));
+	Reset();
+
+	return m_outputLength;
+}
+
+size_t BlakeXof::Finalize(std::vector<byte> &Output, const size_t OutOffset)
+{
+	if (Output.size() < OutOffset + m_outputLength)
+		throw CryptoDigestException("BlakeXof:Finalize", "The Output buffer is too short!");
+
+	return Finalize(&Output[OutOffset]);
+}
+
+void BlakeXof::Initialize(ISymmetricKey &MacKey)
+{
+	const size_t DGTLEN = (m_digestType == Digests::Blake256) ? B2S_DIGEST : B2B_DIGEST;
+	const size_t SLTLEN = DGTLEN / 4;
+
+	if (MacKey.Key().size() == 0 || MacKey.Key().size() > DGTLEN)
+		throw CryptoDigestException("BlakeXof:Initialize", "Mac Key has invalid length!");
+	if (MacKey.Nonce().size() != 0 && MacKey.Nonce().size() != SLTLEN)
+		throw CryptoDigestException("BlakeXof:Initialize", "Salt has invalid length!");
+	if (MacKey.Info().size() != 0 && MacKey.Info().size() != SLTLEN)
+		throw CryptoDigestException("BlakeXof:Initialize", "Info has invalid length!");
+
+	LoadConfig(MacKey.Key().size());
+
+	// the salt and personalization words are shared by the root and the output blocks
+	if (m_digestType == Digests::Blake256)
+	{
+		if (MacKey.Nonce().size() != 0)
+		{
+			m_rootConfig256[4] = IntUtils::BytesToLe32(MacKey.Nonce(), 0);
+			m_rootConfig256[5] = IntUtils::BytesToLe32(MacKey.Nonce(), 4);
+		}
+
+		if (MacKey.Info().size() != 0)
+		{
+			m_rootConfig256[6] = IntUtils::BytesToLe32(MacKey.Info(), 0);
+			m_rootConfig256[7] = IntUtils::BytesToLe32(MacKey.Info(), 4);
+		}
+	}
+	else
+	{
+		if (MacKey.Nonce().size() != 0)
+		{
+			m_rootConfig512[4] = IntUtils::BytesToLe64(MacKey.Nonce(), 0);
+			m_rootConfig512[5] = IntUtils::BytesToLe64(MacKey.Nonce(), 8);
+		}
+
+		if (MacKey.Info().size() != 0)
+		{
+			m_rootConfig512[6] = IntUtils::BytesToLe64(MacKey.Info(), 0);
+			m_rootConfig512[7] = IntUtils::BytesToLe64(MacKey.Info(), 8);
+		}
+	}
+
+	// the key is the first block of the root
+	m_keyBlock.resize(m_blockSize);
+	memset(&m_keyBlock[0], 0, m_keyBlock.size());
+	memcpy(&m_keyBlock[0], &MacKey.Key()[0], MacKey.Key().size());
+
+	Reset();
+}
+
+void BlakeXof::ParallelMaxDegree(size_t Degree)
+{
+	if (Degree == 0)
+		throw CryptoDigestException("BlakeXof:ParallelMaxDegree", "Parallel degree can not be zero!");
+
+	m_parallelProfile.SetMaxDegree(Degree);
+	m_parallelProfile.IsParallel() = (Degree > 1 && m_parallelProfile.ProcessorCount() > 1);
+}
+
+void BlakeXof::Reset()
+{
+	m_msgLength = 0;
+	memset(&m_msgBuffer[0], 0, m_msgBuffer.size());
+
+	if (m_digestType == Digests::Blake256)
+	{
+		m_rootState256.Reset();
+
+		for (size_t i = 0; i < CHAIN_SIZE; ++i)
+			m_rootState256.H[i] = SCIV[i] ^ m_rootConfig256[i];
+	}
+	else
+	{
+		m_rootState512.Reset();
+
+		for (size_t i = 0; i < CHAIN_SIZE; ++i)
+			m_rootState512.H[i] = BCIV[i] ^ m_rootConfig512[i];
+	}
+
+	if (m_keyBlock.size() != 0)
+	{
+		memcpy(&m_msgBuffer[0], &m_keyBlock[0], m_blockSize);
+		m_msgLength = m_blockSize;
+	}
+}
+
+void BlakeXof::Update(byte Input)
+{
+	Update(&Input, 1);
+}
+
+void BlakeXof::Update(const byte* Input, size_t Length)
+{
+	if (Length == 0)
+		return;
+
+	// the last block is held back; it is compressed by Finalize with the final flag
+	if (m_msgLength + Length > m_blockSize)
+	{
+		const size_t RMDLEN = m_blockSize - m_msgLength;
+
+		if (RMDLEN != 0)
+			memcpy(&m_msgBuffer[m_msgLength], Input, RMDLEN);
+
+		CompressRoot(&m_msgBuffer[0], m_blockSize);
+		m_msgLength = 0;
+		Input += RMDLEN;
+		Length -= RMDLEN;
+
+		while (Length > m_blockSize)
+		{
+			CompressRoot(Input, m_blockSize);
+			Input += m_blockSize;
+			Length -= m_blockSize;
+		}
+	}
+
+	memcpy(&m_msgBuffer[m_msgLength], Input, Length);
+	m_msgLength += Length;
+}
+
+void BlakeXof::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length)
+{
+	if (InOffset + Length > Input.size())
+		throw CryptoDigestException("BlakeXof:Update", "The Input buffer is too short!");
+
+	if (Length != 0)
+		Update(&Input[InOffset], Length);
+}
+
+//~~~Private Functions~~~//
+
+void BlakeXof::CompressRoot(const byte* Input, size_t Length)
+{
+	if (m_digestType == Digests::Blake256)
+	{
+		ArrayUtils::IncreaseLE32(m_rootState256.T, Length);
+		m_kernels->Compress64(Input, m_rootState256, SCIV);
+	}
+	else
+	{
+		ArrayUtils::IncreaseLE64(m_rootState512.T, Length);
+		m_kernels->Compress128(Input, m_rootState512, BCIV);
+	}
+}
+
+void BlakeXof::Expand(const byte* Root, byte* Output)
+{
+	const size_t DGTLEN = m_blockSize / 2;
+	const size_t BLKCNT = (static_cast<size_t>(m_outputLength) + DGTLEN - 1) / DGTLEN;
+
+	if (m_parallelProfile.IsParallel() && m_outputLength >= MIN_PRLOUTPUT)
+	{
+		// each thread generates a contiguous range of output blocks
+		const size_t THDCNT = (m_parallelProfile.ParallelMaxDegree() < BLKCNT) ? m_parallelProfile.ParallelMaxDegree() : BLKCNT;
+		const size_t RNGLEN = BLKCNT / THDCNT;
+
+		ParallelUtils::ParallelFor(0, THDCNT, [this, Root, Output, BLKCNT, RNGLEN, THDCNT](size_t i)
+		{
+			const size_t FIRST = i * RNGLEN;
+			const size_t COUNT = (i == THDCNT - 1) ? BLKCNT - FIRST : RNGLEN;
+
+			if (m_digestType == Digests::Blake256)
+				Expand256(Root, FIRST, COUNT, Output);
+			else
+				Expand512(Root, FIRST, COUNT, Output);
+		});
+	}
+	else
+	{
+		if (m_digestType == Digests::Blake256)
+			Expand256(Root, 0, BLKCNT, Output);
+		else
+			Expand512(Root, 0, BLKCNT, Output);
+	}
+}
+
+void BlakeXof::Expand256(const byte* Root, size_t First, size_t Count, byte* Output)
+{
+	const size_t LNECNT = m_kernels->Lanes64W;
+	const size_t LAST = First + Count;
+	std::array<uint, CHAIN_SIZE> config(m_rootConfig256);
+	byte rootBlk[B2S_BLOCK] = { 0 };
+	byte blkCode[B2S_DIGEST];
+	uint chain[CHAIN_SIZE];
+	Blake2sWideState wState(LNECNT);
+	std::vector<const byte*> lnePtr(LNECNT, &rootBlk[0]);
+	size_t blkIdx = First;
+
+	memcpy(&rootBlk[0], Root, B2S_DIGEST);
+
+	// output block parameters; no key, a fanout and depth of zero, a leaf and inner length of the digest size, and the output length retained
+	config[1] = static_cast<uint>(B2S_DIGEST);
+	config[3] = (config[3] & 0xFFFFUL) | (static_cast<uint>(B2S_DIGEST) << 24);
+
+	// one output block per lane; every lane compresses the root digest as its only block
+	while (LNECNT > 1 && LAST - blkIdx >= LNECNT)
+	{
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			const size_t BLKLEN = (m_outputLength - ((blkIdx + i) * B2S_DIGEST) < B2S_DIGEST) ? m_outputLength - ((blkIdx + i) * B2S_DIGEST) : B2S_DIGEST;
+			config[0] = static_cast<uint>(BLKLEN);
+			config[2] = static_cast<uint>(blkIdx + i);
+
+			for (size_t j = 0; j < CHAIN_SIZE; ++j)
+				wState.H[(j * LNECNT) + i] = SCIV[j] ^ config[j];
+
+			wState.T[i] = static_cast<uint>(B2S_DIGEST);
+			wState.T[LNECNT + i] = 0;
+			wState.F[i] = 0xFFFFFFFFUL;
+			wState.F[LNECNT + i] = 0;
+		}
+
+		m_kernels->Compress64W(lnePtr, wState, SCIV);
+
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			const size_t OUTOFF = (blkIdx + i) * B2S_DIGEST;
+			const size_t BLKLEN = (m_outputLength - OUTOFF < B2S_DIGEST) ? m_outputLength - OUTOFF : B2S_DIGEST;
+
+			for (size_t j = 0; j < CHAIN_SIZE; ++j)
+				chain[j] = wState.H[(j * LNECNT) + i];
+
+			IntUtils::LeUL256ToBlock(chain, &blkCode[0]);
+			memcpy(Output + OUTOFF, &blkCode[0], BLKLEN);
+		}
+
+		blkIdx += LNECNT;
+	}
+
+	while (blkIdx < LAST)
+	{
+		const size_t OUTOFF = blkIdx * B2S_DIGEST;
+		const size_t BLKLEN = (m_outputLength - OUTOFF < B2S_DIGEST) ? m_outputLength - OUTOFF : B2S_DIGEST;
+		Blake2sState state;
+
+		config[0] = static_cast<uint>(BLKLEN);
+		config[2] = static_cast<uint>(blkIdx);
+
+		for (size_t i = 0; i < CHAIN_SIZE; ++i)
+			state.H[i] = SCIV[i] ^ config[i];
+
+		state.T[0] = static_cast<uint>(B2S_DIGEST);
+		state.F[0] = 0xFFFFFFFFUL;
+		m_kernels->Compress64(&rootBlk[0], state, SCIV);
+		IntUtils::LeUL256ToBlock(state.H, &blkCode[0]);
+		memcpy(Output + OUTOFF, &blkCode[0], BLKLEN);
+		++blkIdx;
+	}
+}
+
+void BlakeXof::Expand512(const byte* Root, size_t First, size_t Count, byte* Output)
+{
+	const size_t LNECNT = m_kernels->Lanes128W;
+	const size_t LAST = First + Count;
+	std::array<ulong, CHAIN_SIZE> config(m_rootConfig512);
+	byte rootBlk[B2B_BLOCK] = { 0 };
+	byte blkCode[B2B_DIGEST];
+	ulong chain[CHAIN_SIZE];
+	Blake2bWideState wState(LNECNT);
+	std::vector<const byte*> lnePtr(LNECNT, &rootBlk[0]);
+	size_t blkIdx = First;
+
+	memcpy(&rootBlk[0], Root, B2B_DIGEST);
+
+	// output block parameters; no key, a fanout and depth of zero, a leaf and inner length of the digest size, and the output length retained
+	config[0] = static_cast<ulong>(B2B_DIGEST) << 32;
+	config[2] = static_cast<ulong>(B2B_DIGEST) << 8;
+
+	// one output block per lane; every lane compresses the root digest as its only block
+	while (LNECNT > 1 && LAST - blkIdx >= LNECNT)
+	{
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			const size_t OUTOFF = (blkIdx + i) * B2B_DIGEST;
+			const size_t BLKLEN = (m_outputLength - OUTOFF < B2B_DIGEST) ? m_outputLength - OUTOFF : B2B_DIGEST;
+			config[0] = (config[0] & ~0xFFULL) | static_cast<ulong>(BLKLEN);
+			config[1] = (config[1] & 0xFFFFFFFF00000000ULL) | static_cast<ulong>(blkIdx + i);
+
+			for (size_t j = 0; j < CHAIN_SIZE; ++j)
+				wState.H[(j * LNECNT) + i] = BCIV[j] ^ config[j];
+
+			wState.T[i] = static_cast<ulong>(B2B_DIGEST);
+			wState.T[LNECNT + i] = 0;
+			wState.F[i] = 0xFFFFFFFFFFFFFFFFULL;
+			wState.F[LNECNT + i] = 0;
+		}
+
+		m_kernels->Compress128W(lnePtr, wState, BCIV);
+
+		for (size_t i = 0; i < LNECNT; ++i)
+		{
+			const size_t OUTOFF = (blkIdx + i) * B2B_DIGEST;
+			const size_t BLKLEN = (m_outputLength - OUTOFF < B2B_DIGEST) ? m_outputLength - OUTOFF : B2B_DIGEST;
+
+			for (size_t j = 0; j < CHAIN_SIZE; ++j)
+				chain[j] = wState.H[(j * LNECNT) + i];
+
+			IntUtils::LeULL512ToBlock(chain, &blkCode[0]);
+			memcpy(Output + OUTOFF, &blkCode[0], BLKLEN);
+		}
+
+		blkIdx += LNECNT;
+	}
+
+	while (blkIdx < LAST)
+	{
+		const size_t OUTOFF = blkIdx * B2B_DIGEST;
+		const size_t BLKLEN = (m_outputLength - OUTOFF < B2B_DIGEST) ? m_outputLength - OUTOFF : B2B_DIGEST;
+		Blake2bState state;
+
+		config[0] = (config[0] & ~0xFFULL) | static_cast<ulong>(BLKLEN);
+		config[1] = (config[1] & 0xFFFFFFFF00000000ULL) | static_cast<ulong>(blkIdx);
+
+		for (size_t i = 0; i < CHAIN_SIZE; ++i)
+			state.H[i] = BCIV[i] ^ config[i];
+
+		state.T[0] = static_cast<ulong>(B2B_DIGEST);
+		state.F[0] = 0xFFFFFFFFFFFFFFFFULL;
+		m_kernels->Compress128(&rootBlk[0], state, BCIV);
+		IntUtils::LeULL512ToBlock(state.H, &blkCode[0]);
+		memcpy(Output + OUTOFF, &blkCode[0], BLKLEN);
+		++blkIdx;
+	}
+}
+
+void BlakeXof::LoadConfig(size_t KeyLength)
+{
+	// the root parameter block; a sequential node of the full digest size, with the output length in the node offset field
+	if (m_digestType == Digests::Blake256)
+	{
+		m_rootConfig256.fill(0);
+		m_rootConfig256[0] = static_cast<uint>(B2S_DIGEST) | (static_cast<uint>(KeyLength) << 8) | (1UL << 16) | (1UL << 24);
+		m_rootConfig256[3] = m_outputLength & 0xFFFFUL;
+	}
+	else
+	{
+		m_rootConfig512.fill(0);
+		m_rootConfig512[0] = static_cast<ulong>(B2B_DIGEST) | (static_cast<ulong>(KeyLength) << 8) | (1ULL << 16) | (1ULL << 24);
+		m_rootConfig512[1] = static_cast<ulong>(m_outputLength) << 32;
+	}
+}
+
+NAMESPACE_DIGESTEND
@@ -0,0 +1,263 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+//
+// Principal Algorithms:
+// An implementation of Blake2, designed by Jean-Philippe Aumasson, Samuel Neves, Zooko Wilcox-O'Hearn, and Christian Winnerlein.
+// Blake2 whitepaper <a href="https://blake2.net/blake2.pdf">BLAKE2: simpler, smaller, fast as MD5</a>.
+//
+// Implementation Details:
+// An implementation of the Blake2X extendable output functions, Blake2Xb and Blake2Xs.
+// Based on the Blake2X specification <a href="https://blake2.net/blake2x.pdf">BLAKE2X</a>.
+
+#ifndef _CEX_BLAKEXOF_H
+#define _CEX_BLAKEXOF_H
+
+#include "BlakeDispatch.h"
+#include "BlakeState.h"
+#include "IDigest.h"
+#include "ISymmetricKey.h"
+#include <array>
+
+NAMESPACE_DIGEST
+
+using Key::Symmetric::ISymmetricKey;
+
+/// <summary>
+/// An implementation of the Blake2X extendable output functions; Blake2Xb with Blake512 (Blake2b) nodes, and Blake2Xs with Blake256 (Blake2s) nodes
+/// </summary>
+///
+/// <example>
+/// <description>Expanding a message to 1000 bytes:</description>
+/// <code>
+/// BlakeXof xof(Digests::Blake512, 1000);
+/// std:vector&lt;byte&gt; output(xof.DigestSize(), 0);
+/// xof.Compute(input, output);
+/// </code>
+/// </example>
+///
+/// <remarks>
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>The message is hashed by a root node, whose parameter block carries the output length; the output length is part of the hash, so outputs of different lengths are unrelated.</description></item>
+/// <item><description>Output block i is the root hash, hashed with a node offset of i, a leaf and inner length of the digest size, and a digest length of the bytes remaining in the last block.</description></item>
+/// <item><description>The output blocks are independent; they are generated by the multi-buffer kernels, several blocks per compression call, and large outputs are split across threads.</description></item>
+/// <item><description>The output length is between 1 and 4294967294 bytes with Blake2Xb, and between 1 and 65534 bytes with Blake2Xs.</description></item>
+/// <item><description>A key, salt and personalization are set by Initialize; the key is retained by Reset and Finalize, as with BlakeTree.</description></item>
+/// <item><description>The <see cref="Finalize(byte[], size_t)"/> method resets the internal state.</description></item>
+/// </list>
+///
+/// <description>Guiding Publications:</description>
+/// <list type="number">
+/// <item><description>Blake2X specification <a href="https://blake2.net/blake2x.pdf">BLAKE2X</a>.</description></item>
+/// <item><description>Blake2 on <a href="https://github.com/BLAKE2/BLAKE2">Github</a>.</description></item>
+/// </list>
+/// </remarks>
+class BlakeXof : public IDigest
+{
+private:
+
+	static const size_t B2B_BLOCK = 128;
+	static const size_t B2B_DIGEST = 64;
+	static const uint B2B_MAXOUT = 0xFFFFFFFEUL;
+	static const size_t B2S_BLOCK = 64;
+	static const size_t B2S_DIGEST = 32;
+	static const uint B2S_MAXOUT = 0xFFFEUL;
+	static const uint CHAIN_SIZE = 8;
+	// outputs of this size or larger are generated on multiple threads
+	static const size_t MIN_PRLOUTPUT = 65536;
+	// size of reserved state buffer subtracted from parallel size calculations
+	static const size_t STATE_PRECACHED = 2048;
+
+	size_t m_blockSize;
+	Digests m_digestType;
+	bool m_isDestroyed;
+	const BlakeDispatch::Kernels* m_kernels;
+	std::vector<byte> m_keyBlock;
+	std::vector<byte> m_msgBuffer;
+	size_t m_msgLength;
+	uint m_outputLength;
+	ParallelOptions m_parallelProfile;
+	std::array<uint, CHAIN_SIZE> m_rootConfig256;
+	std::array<ulong, CHAIN_SIZE> m_rootConfig512;
+	Blake2sState m_rootState256;
+	Blake2bState m_rootState512;
+
+public:
+
+	BlakeXof(const BlakeXof&) = delete;
+	BlakeXof& operator=(const BlakeXof&) = delete;
+	BlakeXof& operator=(BlakeXof&&) = delete;
+
+	//~~~Properties~~~//
+
+	/// <summary>
+	/// Get: The node digests internal blocksize in bytes
+	/// </summary>
+	virtual size_t BlockSize() { return m_blockSize; }
+
+	/// <summary>
+	/// Get: Size of the returned output in bytes
+	/// </summary>
+	virtual size_t DigestSize() { return m_outputLength; }
+
+	/// <summary>
+	/// Get: The node digests type name
+	/// </summary>
+	virtual const Digests Enumeral() { return m_digestType; }
+
+	/// <summary>
+	/// Get: Processor parallelization availability.
+	/// <para>Indicates whether large outputs are generated on multiple threads.</para>
+	/// </summary>
+	virtual const bool IsParallel() { return m_parallelProfile.IsParallel(); }
+
+	/// <summary>
+	/// Get: The digests class name
+	/// </summary>
+	virtual const std::string Name()
+	{
+		return m_digestType == Digests::Blake256 ? "Blake2Xs" : "Blake2Xb";
+	}
+
+	/// <summary>
+	/// Get: Parallel block size; the message is hashed sequentially by the root node, so this is the node block size
+	/// </summary>
+	virtual const size_t ParallelBlockSize() { return m_blockSize; }
+
+	/// <summary>
+	/// Get/Set: Contains parallel settings and SIMD capability flags in a ParallelOptions structure.
+	/// <para>The number of threads can be set with the ParallelMaxDegree(size_t) function.</para>
+	/// </summary>
+	virtual ParallelOptions &ParallelProfile() { return m_parallelProfile; }
+
+	//~~~Constructor~~~//
+
+	/// <summary>
+	/// Initialize the extendable output function
+	/// </summary>
+	///
+	/// <param name="DigestType">The node digest; Blake512 (Blake2Xb), or Blake256 (Blake2Xs)</param>
+	/// <param name="OutputLength">The output length in bytes; between 1 and 4294967294 with Blake2Xb, and between 1 and 65534 with Blake2Xs</param>
+	/// <param name="Parallel">Generate large outputs on multiple threads; does not change the output</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the digest type or the output length is invalid</exception>
+	BlakeXof(Digests DigestType, uint OutputLength, bool Parallel = false);
+
+	/// <summary>
+	/// Finalize objects
+	/// </summary>
+	virtual ~BlakeXof();
+
+	//~~~Public Functions~~~//
+
+	/// <summary>
+	/// Process the message data and return the output
+	/// </summary>
+	///
+	/// <param name="Input">The message input data</param>
+	/// <param name="Output">The output array; resized to DigestSize() if shorter</param>
+	virtual void Compute(const std::vector<byte> &Input, std::vector<byte> &Output);
+
+	/// <summary>
+	/// Release all resources associated with the object
+	/// </summary>
+	virtual void Destroy();
+
+	/// <summary>
+	/// Hash the remaining message with the root node, and generate the output
+	/// </summary>
+	///
+	/// <param name="Output">The output array</param>
+	/// <param name="OutOffset">The starting offset within the Output array</param>
+	///
+	/// <returns>Size of the output</returns>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the output buffer is too short</exception>
+	virtual size_t Finalize(std::vector<byte> &Output, const size_t OutOffset);
+
+	/// <summary>
+	/// Hash the remaining message with the root node, and write the output to caller memory
+	/// </summary>
+	///
+	/// <param name="Output">Pointer to the destination; must have room for DigestSize() bytes</param>
+	///
+	/// <returns>Size of the output</returns>
+	virtual size_t Finalize(byte* Output);
+
+	/// <summary>
+	/// Initialize the function with a key
+	/// </summary>
+	///
+	/// <param name="MacKey">The input key parameters.
+	/// <para>The input Key must be between 1 byte and the node digest size.
+	/// The Nonce and Info keys are optional, and fill the salt and personalization parameters; 16 bytes each with Blake2Xb, and 8 with Blake2Xs.</para></param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if a key parameter has an invalid length</exception>
+	virtual void Initialize(ISymmetricKey &MacKey);
+
+	/// <summary>
+	/// Set the number of threads used to generate large outputs; does not change the output
+	/// </summary>
+	///
+	/// <param name="Degree">The maximum number of threads; a degree of one generates on the calling thread</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the degree is zero</exception>
+	virtual void ParallelMaxDegree(size_t Degree);
+
+	/// <summary>
+	/// Reset the internal state; a key set by Initialize is retained
+	/// </summary>
+	virtual void Reset();
+
+	/// <summary>
+	/// Update the message with a single byte
+	/// </summary>
+	///
+	/// <param name="Input">Input message byte</param>
+	virtual void Update(byte Input);
+
+	/// <summary>
+	/// Update the message with a block of bytes
+	/// </summary>
+	///
+	/// <param name="Input">The Input message data</param>
+	/// <param name="InOffset">The starting offset within the Input array</param>
+	/// <param name="Length">The amount of data to process in bytes</param>
+	///
+	/// <exception cref="CryptoDigestException">Thrown if the input buffer is too short</exception>
+	virtual void Update(const std::vector<byte> &Input, size_t InOffset, size_t Length);
+
+	/// <summary>
+	/// Update the message with a block of bytes read directly from caller memory
+	/// </summary>
+	///
+	/// <param name="Input">Pointer to the input data</param>
+	/// <param name="Length">The amount of data to process in bytes</param>
+	virtual void Update(const byte* Input, size_t Length);
+
+private:
+	void CompressRoot(const byte* Input, size_t Length);
+	void Expand(const byte* Root, byte* Output);
+	void Expand256(const byte* Root, size_t First, size_t Count, byte* Output);
+	void Expand512(const byte* Root, size_t First, size_t Count, byte* Output);
+	void LoadConfig(size_t KeyLength);
+};
+
+NAMESPACE_DIGESTEND
+#endif
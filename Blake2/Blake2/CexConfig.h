@@ -72,9 +72,9 @@ static const int CEX_VERSION_RELEASE = 1;
 #	else
 #		define CEX_ISOSX
 #	endif
-#elif defined(__linux)
+#elif defined(__linux) || defined(__linux__)
 #	define CEX_OS_LINUX
-#elif defined(__unix)
+#elif defined(__unix) || defined(__unix__)
 #	define CEX_OS_UNIX
 #	if defined(__hpux) || defined(hpux)
 #		define CEX_OS_HPUX
@@ -86,6 +86,10 @@ static const int CEX_VERSION_RELEASE = 1;
 #if defined(__posix) || defined(_POSIX_VERSION)
 #	define CEX_OS_POSIX
 #endif
+// posix file descriptors and memory mapping; _POSIX_VERSION is only visible after unistd.h
+#if defined(CEX_OS_POSIX) || defined(CEX_OS_LINUX) || defined(CEX_OS_UNIX) || defined(CEX_OS_APPLE) || defined(CEX_OS_ANDROID)
+#	define CEX_HAS_POSIXIO
+#endif
 
 // cpu type (only intel/amd/arm are targeted for support)
 #if defined(CEX_COMPILER_MSC)
@@ -430,6 +434,26 @@ const unsigned int WORD_BITS = WORD_SIZE * 8;
 #	endif
 #endif
 
+// SIMD kernels are selected at runtime through CpuDetect; GCC and Clang compile them with a function level target,
+// MSVC compiles each kernel unit with its own arch option (the project sets /arch:AVX2 and /arch:AVX512 on those files only);
+// those units must not emit inline or template code shared with other units, as the linker may keep their copy, see BlakeDispatch.h.
+// MSVC has the AVX512 intrinsics from VS2017 15.3, and the 64 bit kernels are built for x64 only
+#if (defined(CEX_COMPILER_GCC) || defined(CEX_COMPILER_CLANG)) && defined(__x86_64__) && (!defined(CEX_GCC_VERSION) || CEX_GCC_VERSION >= 40900)
+#	define CEX_TARGET_DISPATCH
+#	define CEX_AVX512_AVAILABLE
+#	define CEX_TARGET_SSE41 __attribute__((target("sse4.1")))
+#	define CEX_TARGET_AVX2 __attribute__((target("avx2")))
+#	define CEX_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512vl")))
+#elif defined(CEX_COMPILER_MSC) && defined(CEX_ARCH_X86_X64) && (_MSC_VER >= 1900)
+#	define CEX_TARGET_DISPATCH
+#	if defined(CEX_ARCH_X64) && (_MSC_VER >= 1911)
+#		define CEX_AVX512_AVAILABLE
+#	endif
+#	define CEX_TARGET_SSE41
+#	define CEX_TARGET_AVX2
+#	define CEX_TARGET_AVX512
+#endif
+
 // enables fast rotation intrinsics
 #define CEX_FASTROTATE_ENABLED
 
@@ -57,33 +57,33 @@ CpuDetect::CpuDetect()
 	Initialize();
 }
 
-//~~~Private Functions~~~//
+//~~~Public Functions~~~//
 
 bool CpuDetect::AvxEnabled()
 {
-	uint cpuInfo[4];
-
-	X86_CPUID(1, cpuInfo);
-
-	// check if os saves the ymm registers
-	if ((cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)))
-		return (_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0x6) != 0;
-
-	return false;
+	// check if os saves the xmm and ymm registers
+	return (GetXcr0() & 0x6) == 0x6;
 }
 
 bool CpuDetect::Avx2Enabled()
 {
-	uint cpuInfo[4];
-
-	X86_CPUID(1, cpuInfo);
+	// avx2 uses the same register state as avx
+	return (GetXcr0() & 0x6) == 0x6;
+}
 
-	if ((cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)))
-		return (_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0xe6) != 0;
+bool CpuDetect::Avx512Enabled()
+{
+	// the opmask registers, and the upper halves of zmm0-15 and all of zmm16-31, are saved with the ymm state
+	return (GetXcr0() & 0xE6) == 0xE6;
+}
 
-	return false;
+bool CpuDetect::Avx512Usable()
+{
+	return AVX512F() && AVX512VL() && Avx512Enabled();
 }
 
+//~~~Private Functions~~~//
+
 void CpuDetect::Initialize()
 {
 	uint cpuInfo[4] = { 0 };
@@ -212,6 +212,29 @@ void CpuDetect::GetTopology()
 	m_l2CacheSize = static_cast<size_t>(READBITSFROM(cpuInfo[2], 16, 16));
 }
 
+ulong CpuDetect::GetXcr0()
+{
+	uint cpuInfo[4] = { 0 };
+	X86_CPUID(1, cpuInfo);
+
+	// xgetbv can only be executed once the os has enabled xsave
+	if ((cpuInfo[2] & (1 << 27)) == 0)
+		return 0;
+
+#if defined(CEX_COMPILER_MSC) || defined(CEX_COMPILER_INTEL)
+	return static_cast<ulong>(_xgetbv(0));
+#elif defined(CEX_COMPILER_GCC) || defined(CEX_COMPILER_CLANG)
+	uint xcrLow;
+	uint xcrHigh;
+	// xgetbv with ecx 0; encoded as bytes for assemblers that predate it
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a" (xcrLow), "=d" (xcrHigh) : "c" (0));
+
+	return (static_cast<ulong>(xcrHigh) << 32) | xcrLow;
+#else
+	return 0;
+#endif
+}
+
 const CpuDetect::CpuVendors CpuDetect::GetVendor(std::string &Name)
 {
 	if (Name.size() > 0)
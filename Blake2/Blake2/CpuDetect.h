@@ -64,6 +64,7 @@ private:
 		CPUID_ADX = 64 + 19, // ebx 18
 		CPUID_SMAP = 64 + 20, // ebx 20
 		CPUID_SHA = 64 + 29, // ebx 29
+		CPUID_AVX512VL = 64 + 31, // ebx 31
 		CPUID_PREFETCH = 64 + 32, // ebx 32
 		// EAX=80000001h
 		CPUID_ABM = 128 + 5, // ecx 5
@@ -130,6 +131,11 @@ public:
 	/// </summary>
 	const bool AVX512F() { return GetFlag(CpuidFlags::CPUID_AVX512F); }
 
+	/// <summary>
+	/// AVX512 Vector Length extensions detected
+	/// </summary>
+	const bool AVX512VL() { return GetFlag(CpuidFlags::CPUID_AVX512VL); }
+
 	/// <summary>
 	/// Bit Manipulation Instruction Set 2
 	/// </summary>
@@ -372,6 +378,28 @@ public:
 	/// </summary>
 	CpuDetect();
 
+	//~~~Public Functions~~~//
+
+	/// <summary>
+	/// Returns true if the operating system saves the XMM and YMM register state (XCR0 bits 1 and 2), so that AVX instructions can be executed
+	/// </summary>
+	bool AvxEnabled();
+
+	/// <summary>
+	/// Returns true if the operating system saves the register state used by AVX2; the XMM and YMM state, as for AVX
+	/// </summary>
+	bool Avx2Enabled();
+
+	/// <summary>
+	/// Returns true if the operating system also saves the opmask and ZMM register state (XCR0 bits 1, 2 and 5 to 7), so that AVX512 instructions can be executed
+	/// </summary>
+	bool Avx512Enabled();
+
+	/// <summary>
+	/// Returns true if AVX512F and AVX512VL are detected, and the operating system saves the AVX512 register state; the AVX512 code paths can be executed
+	/// </summary>
+	bool Avx512Usable();
+
 private:
 
 	byte GetByte(size_t Index, uint Input);
@@ -394,14 +422,13 @@ private:
 	}
 
 
-	bool AvxEnabled();
-	bool Avx2Enabled();
 	bool GetFlag(CpuidFlags Flag);
 	void GetFrequency();
 	size_t GetMaxCoresPerPackage();
 	size_t GetMaxLogicalPerCore();
 	void GetSerialNumber();
 	void GetTopology();
+	ulong GetXcr0();
 	void Initialize();
 	const CpuVendors GetVendor(std::string &Name);
 	std::string GetVendorString(uint CpuInfo[4]);
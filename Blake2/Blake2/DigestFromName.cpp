@@ -45,6 +45,26 @@ IDigest* DigestFromName::GetInstance(Digests DigestType, bool Parallel)
 	}
 }
 
+IDigest* DigestFromName::GetSizedInstance(Digests DigestType, size_t DigestSize, bool Parallel)
+{
+	try
+	{
+		switch (DigestType)
+		{
+		case Digests::Blake512:
+			return new Digest::Blake512(DigestSize, Parallel);
+		case Digests::Blake256:
+			return new Digest::Blake256(DigestSize, Parallel);
+		default:
+			throw Exception::CryptoException("DigestFromName:GetSizedInstance", "The digest does not support a variable output size!");
+		}
+	}
+	catch (const std::exception &ex)
+	{
+		throw Exception::CryptoException("DigestFromName:GetSizedInstance", "The digest is unavailable!", std::string(ex.what()));
+	}
+}
+
 size_t DigestFromName::GetBlockSize(Digests DigestType)
 {
 	try
@@ -28,6 +28,20 @@ public:
 	/// <exception cref="Exception::CryptoException">Thrown if the enumeration name is not supported</exception>
 	static IDigest* GetInstance(Digests DigestType, bool Parallel = false);
 
+	/// <summary>
+	/// Get a Digest instance by name, with a digest output size
+	/// </summary>
+	/// 
+	/// <param name="DigestType">The message digests enumeration type name; Blake256 or Blake512</param>
+	/// <param name="DigestSize">The digest output size in bytes; 1 to 32 with Blake256, and 1 to 64 with Blake512.
+	/// <para>The output size is part of the Blake2 parameter block; a shorter output is a different hash, not a truncation.</para></param>
+	/// <param name="Parallel">Return the digest instance initialized in parallel mode; default is false</param>
+	/// 
+	/// <returns>An initialized digest</returns>
+	/// 
+	/// <exception cref="Exception::CryptoException">Thrown if the enumeration name is not supported, or the digest size is invalid</exception>
+	static IDigest* GetSizedInstance(Digests DigestType, size_t DigestSize, bool Parallel = false);
+
 	/// <summary>
 	/// Get the input block size of a message digest
 	/// </summary>
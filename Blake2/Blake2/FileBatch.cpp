@@ -0,0 +1,425 @@
+#include "FileBatch.h"
+#include "Blake256.h"
+#include "Blake512.h"
+#include "FileDigest.h"
+#include "ParallelUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#if defined(CEX_OS_WINDOWS)
+#	include <Windows.h>
+#elif defined(CEX_HAS_POSIXIO)
+#	include <dirent.h>
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <sys/types.h>
+#	include <unistd.h>
+#	ifndef O_CLOEXEC
+#		define O_CLOEXEC 0
+#	endif
+#else
+#	include <fstream>
+#endif
+
+NAMESPACE_IO
+
+//~~~Constructor~~~//
+
+FileBatch::FileBatch(Digests DigestType)
+	:
+	m_batchSize(DEF_BATCHSIZE),
+	m_digestType(DigestType),
+	m_isDestroyed(false),
+	m_readerCount(Utility::ParallelUtils::ProcessorCount() != 0 ? Utility::ParallelUtils::ProcessorCount() : 1),
+	m_smallFileSize(DEF_SMALLSIZE)
+{
+	if (m_digestType != Digests::Blake256 && m_digestType != Digests::Blake512)
+		throw CryptoProcessingException("FileBatch:CTor", "The digest type is not supported! Must be Blake256 or Blake512.");
+}
+
+FileBatch::~FileBatch()
+{
+	Destroy();
+}
+
+//~~~Public Functions~~~//
+
+size_t FileBatch::Compute(const std::vector<std::string> &FileNames, std::vector<std::vector<byte>> &Output)
+{
+	if (m_readerCount == 0)
+		throw CryptoProcessingException("FileBatch:Compute", "The reader count can not be zero!");
+
+	const size_t FLECNT = FileNames.size();
+	const size_t THDCNT = (FLECNT < m_readerCount) ? FLECNT : m_readerCount;
+	std::atomic<size_t> hashCount(0);
+	std::atomic<size_t> nextFile(0);
+	std::vector<std::exception_ptr> errors(THDCNT);
+	std::vector<std::thread> readers;
+
+	Output.resize(FLECNT);
+
+	// each thread takes the next file; a small file joins the thread's batch, a large file is hashed on its own
+	const std::function<void(size_t)> HASHFLES = [&](size_t Index)
+	{
+		Digest::Blake256 dgt256(false);
+		Digest::Blake512 dgt512(false);
+		FileDigest fdg(m_digestType);
+		std::vector<std::vector<byte>> hashes;
+		std::vector<std::vector<byte>> msgs;
+		std::vector<size_t> msgIndex;
+		size_t msgLength = 0;
+		size_t idx;
+
+		// the files are hashed in lockstep, four or eight to a lane group, and the digests return to their places in the list
+		const std::function<void()> HASHBATCH = [&]()
+		{
+			if (msgs.size() == 0)
+				return;
+
+			if (m_digestType == Digests::Blake256)
+				dgt256.ComputeBatch(msgs, hashes);
+			else
+				dgt512.ComputeBatch(msgs, hashes);
+
+			for (size_t i = 0; i < msgIndex.size(); ++i)
+				Output[msgIndex[i]].swap(hashes[i]);
+
+			hashCount += msgIndex.size();
+			msgs.clear();
+			msgIndex.clear();
+			msgLength = 0;
+		};
+
+		try
+		{
+			while ((idx = nextFile.fetch_add(1)) < FLECNT)
+			{
+				std::vector<byte> data;
+				bool readable = false;
+
+				if (ReadSmall(FileNames[idx], m_smallFileSize, data, readable))
+				{
+					msgLength += data.size();
+					msgs.push_back(std::vector<byte>(0));
+					msgs.back().swap(data);
+					msgIndex.push_back(idx);
+
+					if (msgLength >= m_batchSize)
+						HASHBATCH();
+				}
+				else if (readable)
+				{
+					try
+					{
+						fdg.Compute(FileNames[idx], Output[idx]);
+						++hashCount;
+					}
+					catch (CryptoProcessingException&)
+					{
+						Output[idx].clear();
+					}
+				}
+				else
+				{
+					Output[idx].clear();
+				}
+			}
+
+			HASHBATCH();
+		}
+		catch (...)
+		{
+			errors[Index] = std::current_exception();
+		}
+	};
+
+	try
+	{
+		for (size_t i = 0; i < THDCNT; ++i)
+			readers.push_back(std::thread(HASHFLES, i));
+	}
+	catch (...)
+	{
+		// the started threads take every remaining file
+		if (readers.size() == 0)
+			throw CryptoProcessingException("FileBatch:Compute", "The reader threads could not be started!");
+	}
+
+	for (size_t i = 0; i < readers.size(); ++i)
+	{
+		if (readers[i].joinable())
+			readers[i].join();
+	}
+
+	try
+	{
+		for (size_t i = 0; i < errors.size(); ++i)
+		{
+			if (errors[i])
+				std::rethrow_exception(errors[i]);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		throw CryptoProcessingException("FileBatch:Compute", "The files could not be hashed!", std::string(ex.what()));
+	}
+
+	return hashCount.load();
+}
+
+size_t FileBatch::ComputeDirectory(const std::string &Directory, std::vector<std::string> &FileNames, std::vector<std::vector<byte>> &Output, bool Recursive)
+{
+	FileNames.clear();
+	ListFiles(Directory, FileNames, Recursive);
+
+	return Compute(FileNames, Output);
+}
+
+void FileBatch::Destroy()
+{
+	if (!m_isDestroyed)
+	{
+		m_isDestroyed = true;
+		m_batchSize = 0;
+		m_digestType = Digests::None;
+		m_readerCount = 0;
+		m_smallFileSize = 0;
+	}
+}
+
+void FileBatch::ListFiles(const std::string &Directory, std::vector<std::string> &FileNames, bool Recursive)
+{
+	if (!ListDirectory(Directory, FileNames, Recursive))
+		throw CryptoProcessingException("FileBatch:ListFiles", "The directory could not be opened!");
+}
+
+//~~~Private Functions~~~//
+
+bool FileBatch::ListDirectory(const std::string &Directory, std::vector<std::string> &FileNames, bool Recursive)
+{
+#if defined(CEX_OS_WINDOWS)
+
+	const std::string DIRPATH = (Directory.size() != 0 && (Directory.back() == '\\' || Directory.back() == '/')) ? Directory : Directory + "\\";
+	std::vector<std::pair<std::string, bool>> entries;
+	WIN32_FIND_DATAA findData;
+	HANDLE hFind = FindFirstFileA((DIRPATH + "*").c_str(), &findData);
+
+	if (hFind == INVALID_HANDLE_VALUE)
+		return false;
+
+	do
+	{
+		const std::string NAME(findData.cFileName);
+
+		// junctions and symbolic links are not followed
+		if (NAME == "." || NAME == ".." || (findData.dwFileAttributes & (FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_DEVICE)) != 0)
+			continue;
+
+		entries.push_back(std::make_pair(NAME, (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0));
+	}
+	while (FindNextFileA(hFind, &findData));
+
+	FindClose(hFind);
+	std::sort(entries.begin(), entries.end());
+
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		if (!entries[i].second)
+			FileNames.push_back(DIRPATH + entries[i].first);
+		else if (Recursive)
+			ListDirectory(DIRPATH + entries[i].first, FileNames, true);
+	}
+
+	return true;
+
+#elif defined(CEX_HAS_POSIXIO)
+
+	const std::string DIRPATH = (Directory.size() != 0 && Directory.back() == '/') ? Directory : Directory + "/";
+	std::vector<std::string> names;
+	DIR* dir = opendir(Directory.c_str());
+
+	if (dir == NULL)
+		return false;
+
+	struct dirent* entry;
+
+	while ((entry = readdir(dir)) != NULL)
+	{
+		const std::string NAME(entry->d_name);
+
+		if (NAME != "." && NAME != "..")
+			names.push_back(NAME);
+	}
+
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		const std::string PATH = DIRPATH + names[i];
+		struct stat fileStat;
+
+		// lstat does not follow symbolic links
+		if (lstat(PATH.c_str(), &fileStat) != 0)
+			continue;
+
+		if (S_ISREG(fileStat.st_mode))
+			FileNames.push_back(PATH);
+		else if (Recursive && S_ISDIR(fileStat.st_mode))
+			ListDirectory(PATH, FileNames, true);
+	}
+
+	return true;
+
+#else
+
+	throw CryptoProcessingException("FileBatch:ListFiles", "Directories are not supported on this platform!");
+
+#endif
+}
+
+bool FileBatch::ReadSmall(const std::string &FileName, size_t MaxLength, std::vector<byte> &Output, bool &Readable)
+{
+	ulong fileSize = 0;
+	bool isRegular = false;
+	Readable = false;
+
+#if defined(CEX_OS_WINDOWS)
+
+	HANDLE hFile = CreateFileA(FileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER sizeEx;
+	sizeEx.QuadPart = 0;
+	isRegular = (GetFileType(hFile) == FILE_TYPE_DISK && GetFileSizeEx(hFile, &sizeEx));
+	fileSize = static_cast<ulong>(sizeEx.QuadPart);
+
+	std::function<bool(byte*, size_t, size_t&)> reader = [hFile](byte* Buffer, size_t Length, size_t &Read)
+	{
+		DWORD rlen = 0;
+		Read = 0;
+
+		if (!ReadFile(hFile, Buffer, static_cast<DWORD>(Length), &rlen, NULL))
+			return false;
+
+		Read = rlen;
+
+		return true;
+	};
+
+	std::function<void()> closer = [hFile]() { CloseHandle(hFile); };
+
+#elif defined(CEX_HAS_POSIXIO)
+
+	int fd;
+
+	do
+	{
+		fd = open(FileName.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+	while (fd == -1 && errno == EINTR);
+
+	if (fd == -1)
+		return false;
+
+	struct stat fileStat;
+	isRegular = (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode));
+	fileSize = isRegular ? static_cast<ulong>(fileStat.st_size) : 0;
+
+	std::function<bool(byte*, size_t, size_t&)> reader = [fd](byte* Buffer, size_t Length, size_t &Read)
+	{
+		ssize_t rlen;
+		Read = 0;
+
+		do
+		{
+			rlen = read(fd, Buffer, Length);
+		}
+		while (rlen < 0 && errno == EINTR);
+
+		if (rlen < 0)
+			return false;
+
+		Read = static_cast<size_t>(rlen);
+
+		return true;
+	};
+
+	std::function<void()> closer = [fd]() { close(fd); };
+
+#else
+
+	std::ifstream inFile(FileName.c_str(), std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+
+	if (!inFile.is_open())
+		return false;
+
+	isRegular = (inFile.tellg() >= 0);
+	fileSize = isRegular ? static_cast<ulong>(inFile.tellg()) : 0;
+	inFile.seekg(0, std::ios::beg);
+
+	std::function<bool(byte*, size_t, size_t&)> reader = [&inFile](byte* Buffer, size_t Length, size_t &Read)
+	{
+		inFile.read(reinterpret_cast<char*>(Buffer), Length);
+		Read = static_cast<size_t>(inFile.gcount());
+
+		return !inFile.bad();
+	};
+
+	std::function<void()> closer = [&inFile]() { inFile.close(); };
+
+#endif
+
+	Readable = true;
+
+	// pipes and devices, and files too large for the batch, are left to the file digest
+	if (!isRegular || fileSize > MaxLength)
+	{
+		closer();
+		return false;
+	}
+
+	// one byte past the reported size shows a file that grew after it was measured
+	size_t pos = 0;
+	Output.resize(static_cast<size_t>(fileSize) + 1);
+
+	while (true)
+	{
+		size_t rlen = 0;
+
+		if (!reader(&Output[pos], Output.size() - pos, rlen))
+		{
+			closer();
+			Readable = false;
+			return false;
+		}
+
+		if (rlen == 0)
+			break;
+
+		pos += rlen;
+
+		if (pos == Output.size())
+		{
+			if (pos > MaxLength)
+			{
+				closer();
+				return false;
+			}
+
+			Output.resize((Output.size() * 2 < MaxLength + 1) ? Output.size() * 2 : MaxLength + 1);
+		}
+	}
+
+	closer();
+	Output.resize(pos);
+
+	return true;
+}
+
+NAMESPACE_IOEND
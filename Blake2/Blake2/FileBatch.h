@@ -0,0 +1,150 @@
+#ifndef _CEX_FILEBATCH_H
+#define _CEX_FILEBATCH_H
+
+#include "CexDomain.h"
+#include "CryptoProcessingException.h"
+#include "Digests.h"
+
+NAMESPACE_IO
+
+using Exception::CryptoProcessingException;
+using Enumeration::Digests;
+
+/// <summary>
+/// Hashes many files at once with Blake2b or Blake2s; the files are read concurrently, and small files are hashed together in the multi-buffer kernel.
+/// <para>The digests are returned in the order of the file names, and each is equal to the sequential digest of that file.</para>
+/// </summary>
+///
+/// <example>
+/// <description>Hashing the files of a directory:</description>
+/// <code>
+/// FileBatch batch(Digests::Blake512);
+/// std::vector&lt;std::string&gt; names;
+/// std::vector&lt;std::vector&lt;byte&gt;&gt; hashes;
+/// batch.ComputeDirectory("cache", names, hashes);
+/// </code>
+/// </example>
+///
+/// <remarks>
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>ReaderCount() threads take the next file from the list in turn; each reads its files with its own handle, so the open, stat and read calls of many files are in flight at once.</description></item>
+/// <item><description>A regular file of up to SmallFileSize() bytes is read whole, and held until the thread has read BatchSize() bytes of small files; the batch is then hashed by ComputeBatch, which compresses four or eight messages in lockstep in the SIMD lanes, refilling a lane as each message ends.</description></item>
+/// <item><description>Larger files, pipes and devices are hashed by a FileDigest on the reading thread, mapped where possible; several large files are hashed in parallel, one per thread.</description></item>
+/// <item><description>A file that can not be opened or read is given an empty digest, and does not stop the batch; the number of files hashed is returned.</description></item>
+/// <item><description>ListFiles walks a directory tree in name order; symbolic links are not followed, so a link can not form a cycle, and only regular files are listed.</description></item>
+/// </list>
+/// </remarks>
+class FileBatch
+{
+private:
+
+	static const size_t DEF_BATCHSIZE = 8 * 1024 * 1024;
+	static const size_t DEF_SMALLSIZE = 64 * 1024;
+
+	size_t m_batchSize;
+	Digests m_digestType;
+	bool m_isDestroyed;
+	size_t m_readerCount;
+	size_t m_smallFileSize;
+
+public:
+
+	FileBatch(const FileBatch&) = delete;
+	FileBatch& operator=(const FileBatch&) = delete;
+	FileBatch& operator=(FileBatch&&) = delete;
+
+	//~~~Properties~~~//
+
+	/// <summary>
+	/// Get/Set: The number of bytes of small files each reader thread holds before the files are hashed together; the default is 8MB
+	/// </summary>
+	size_t &BatchSize() { return m_batchSize; }
+
+	/// <summary>
+	/// Get: Size of the returned digests in bytes
+	/// </summary>
+	const size_t DigestSize() { return m_digestType == Digests::Blake256 ? 32 : 64; }
+
+	/// <summary>
+	/// Get: The digest type name
+	/// </summary>
+	const Digests DigestType() { return m_digestType; }
+
+	/// <summary>
+	/// Get/Set: The number of reader threads; the default is the processor count
+	/// </summary>
+	size_t &ReaderCount() { return m_readerCount; }
+
+	/// <summary>
+	/// Get/Set: The largest file, in bytes, that is read whole and hashed in the multi-buffer kernel; the default is 64KB
+	/// </summary>
+	size_t &SmallFileSize() { return m_smallFileSize; }
+
+	//~~~Constructor~~~//
+
+	/// <summary>
+	/// Instantiate the class with a digest type
+	/// </summary>
+	///
+	/// <param name="DigestType">The message digest; Blake512 (Blake2b) or Blake256 (Blake2s)</param>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the digest type is not supported</exception>
+	explicit FileBatch(Digests DigestType = Digests::Blake512);
+
+	/// <summary>
+	/// Finalize objects
+	/// </summary>
+	~FileBatch();
+
+	//~~~Public Functions~~~//
+
+	/// <summary>
+	/// Hash a list of files
+	/// </summary>
+	///
+	/// <param name="FileNames">The full paths and names of the files</param>
+	/// <param name="Output">Receives one digest per file, in the order of the file names; a file that can not be read receives an empty digest</param>
+	///
+	/// <returns>The number of files hashed</returns>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the reader count is zero, or the reader threads can not be started</exception>
+	size_t Compute(const std::vector<std::string> &FileNames, std::vector<std::vector<byte>> &Output);
+
+	/// <summary>
+	/// Hash the files of a directory
+	/// </summary>
+	///
+	/// <param name="Directory">The path of the directory</param>
+	/// <param name="FileNames">Receives the paths of the files, in the order of ListFiles</param>
+	/// <param name="Output">Receives one digest per file, in the order of the file names; a file that can not be read receives an empty digest</param>
+	/// <param name="Recursive">Include the files of the subdirectories</param>
+	///
+	/// <returns>The number of files hashed</returns>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the directory can not be opened, or the reader count is zero</exception>
+	size_t ComputeDirectory(const std::string &Directory, std::vector<std::string> &FileNames, std::vector<std::vector<byte>> &Output, bool Recursive = true);
+
+	/// <summary>
+	/// Release all resources associated with the object
+	/// </summary>
+	void Destroy();
+
+	/// <summary>
+	/// List the regular files of a directory, in name order; the files of a subdirectory follow its name
+	/// </summary>
+	///
+	/// <param name="Directory">The path of the directory</param>
+	/// <param name="FileNames">The file paths are appended to this list; each is the directory path joined with the file name</param>
+	/// <param name="Recursive">Include the files of the subdirectories; a subdirectory that can not be opened is skipped</param>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the directory can not be opened, or directories are not supported on this platform</exception>
+	static void ListFiles(const std::string &Directory, std::vector<std::string> &FileNames, bool Recursive = true);
+
+private:
+	static bool ListDirectory(const std::string &Directory, std::vector<std::string> &FileNames, bool Recursive);
+	static bool ReadSmall(const std::string &FileName, size_t MaxLength, std::vector<byte> &Output, bool &Readable);
+};
+
+NAMESPACE_IOEND
+#endif
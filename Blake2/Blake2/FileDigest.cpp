@@ -0,0 +1,826 @@
+#include "FileDigest.h"
+#include "DigestFromName.h"
+#include "ParallelUtils.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#if defined(CEX_OS_WINDOWS)
+#	include <Windows.h>
+#elif defined(CEX_HAS_POSIXIO)
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/types.h>
+#	include <unistd.h>
+#	ifndef O_CLOEXEC
+#		define O_CLOEXEC 0
+#	endif
+#else
+#	include <fstream>
+#endif
+
+NAMESPACE_IO
+
+//~~~Constructor~~~//
+
+FileDigest::FileDigest(Digests DigestType, bool Parallel)
+	:
+	m_bufferSize(BUFFER_SIZE),
+	m_bypassCache(false),
+	m_destroyEngine(true),
+	m_isDestroyed(false),
+	m_msgDigest(0),
+	m_queueDepth(DEF_QUEUEDEPTH),
+	m_readBuffers(0),
+	m_readerCount(Utility::ParallelUtils::ProcessorCount() != 0 ? Utility::ParallelUtils::ProcessorCount() : 1),
+	m_readMode(ReadModes::Mapped),
+	m_treeDigest(0)
+{
+	try
+	{
+		m_msgDigest = Helper::DigestFromName::GetInstance(DigestType, Parallel);
+	}
+	catch (std::exception& ex)
+	{
+		throw CryptoProcessingException("FileDigest:CTor", "The digest type is not supported!", std::string(ex.what()));
+	}
+}
+
+FileDigest::FileDigest(IDigest* Digest)
+	:
+	m_bufferSize(BUFFER_SIZE),
+	m_bypassCache(false),
+	m_destroyEngine(false),
+	m_isDestroyed(false),
+	m_msgDigest(Digest != 0 ? Digest : throw CryptoProcessingException("FileDigest:CTor", "The digest can not be null!")),
+	m_queueDepth(DEF_QUEUEDEPTH),
+	m_readBuffers(0),
+	m_readerCount(Utility::ParallelUtils::ProcessorCount() != 0 ? Utility::ParallelUtils::ProcessorCount() : 1),
+	m_readMode(ReadModes::Mapped),
+	m_treeDigest(dynamic_cast<Digest::BlakeTree*>(Digest))
+{
+}
+
+FileDigest::~FileDigest()
+{
+	Destroy();
+}
+
+//~~~Public Functions~~~//
+
+ulong FileDigest::Compute(const std::string &FileName, std::vector<byte> &Output)
+{
+	if (m_bufferSize == 0)
+		throw CryptoProcessingException("FileDigest:Compute", "The buffer size can not be zero!");
+	if (m_readMode == ReadModes::Pipelined && m_queueDepth < 2)
+		throw CryptoProcessingException("FileDigest:Compute", "The queue depth must be at least 2!");
+	if (m_readMode == ReadModes::Ranged && m_readerCount == 0)
+		throw CryptoProcessingException("FileDigest:Compute", "The reader count can not be zero!");
+	if (m_readMode == ReadModes::Ranged && m_treeDigest == 0)
+		throw CryptoProcessingException("FileDigest:Compute", "The ranged read mode requires a BlakeTree digest!");
+
+	if (Output.size() != m_msgDigest->DigestSize())
+		Output.resize(m_msgDigest->DigestSize());
+
+	ulong len = 0;
+
+	try
+	{
+		len = UpdateFile(FileName);
+	}
+	catch (CryptoProcessingException&)
+	{
+		// discard the partial message
+		m_msgDigest->Reset();
+		throw;
+	}
+
+	m_msgDigest->Finalize(Output, 0);
+
+	return len;
+}
+
+void FileDigest::Destroy()
+{
+	if (!m_isDestroyed)
+	{
+		m_isDestroyed = true;
+		m_bufferSize = 0;
+		m_bypassCache = false;
+		m_queueDepth = 0;
+		m_readerCount = 0;
+		m_readMode = ReadModes::Mapped;
+
+		try
+		{
+			if (m_destroyEngine && m_msgDigest != 0)
+			{
+				delete m_msgDigest;
+				m_destroyEngine = false;
+			}
+
+			m_msgDigest = 0;
+			m_treeDigest = 0;
+
+			for (size_t i = 0; i < m_readBuffers.size(); ++i)
+				memset(m_readBuffers[i].data(), 0, m_readBuffers[i].size());
+
+			m_readBuffers.clear();
+		}
+		catch (std::exception& ex)
+		{
+			throw CryptoProcessingException("FileDigest:Destroy", "Could not clear all variables!", std::string(ex.what()));
+		}
+	}
+}
+
+//~~~Private Functions~~~//
+
+bool FileDigest::FillBuffer(const std::function<bool(byte*, size_t, size_t&)> &Reader, byte* Output, size_t Length, size_t &Read)
+{
+	// pipes and sockets return short reads; a short buffer is only returned at the end of the file
+	Read = 0;
+
+	while (Read != Length)
+	{
+		size_t rlen = 0;
+
+		if (!Reader(Output + Read, Length - Read, rlen))
+			return false;
+
+		if (rlen == 0)
+			break;
+
+		Read += rlen;
+	}
+
+	return true;
+}
+
+bool FileDigest::ReadBuffered(const std::function<bool(byte*, size_t, size_t&)> &Reader, ulong &Length)
+{
+	const size_t BUFLEN = ReadSize();
+
+	if (m_readBuffers.size() == 0)
+		m_readBuffers.resize(1);
+	if (m_readBuffers[0].size() != BUFLEN)
+		m_readBuffers[0].resize(BUFLEN);
+
+	while (true)
+	{
+		size_t rlen = 0;
+
+		if (!FillBuffer(Reader, m_readBuffers[0].data(), BUFLEN, rlen))
+			return false;
+
+		if (rlen != 0)
+		{
+			m_msgDigest->Update(m_readBuffers[0].data(), rlen);
+			Length += rlen;
+		}
+
+		if (rlen != BUFLEN)
+			break;
+	}
+
+	return true;
+}
+
+bool FileDigest::ReadPipelined(const std::function<bool(byte*, size_t, size_t&)> &Reader, ulong &Length)
+{
+	const size_t BUFLEN = ReadSize();
+	const size_t QUEUELEN = m_queueDepth;
+
+	m_readBuffers.resize(QUEUELEN);
+
+	for (size_t i = 0; i < QUEUELEN; ++i)
+	{
+		if (m_readBuffers[i].size() != BUFLEN)
+			m_readBuffers[i].resize(BUFLEN);
+	}
+
+	// the ring state; guarded by the mutex
+	std::vector<size_t> fillLength(QUEUELEN, 0);
+	size_t filled = 0;
+	bool endOfFile = false;
+	bool failed = false;
+	bool stopped = false;
+	std::mutex ringLock;
+	std::condition_variable bufferEmptied;
+	std::condition_variable bufferFilled;
+
+	// the reader fills the ring ahead of the digest, and blocks when every buffer is waiting to be hashed
+	std::thread reader([&]()
+	{
+		size_t head = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(ringLock);
+				bufferEmptied.wait(lock, [&]() { return filled < QUEUELEN || stopped; });
+
+				if (stopped)
+					return;
+			}
+
+			size_t rlen = 0;
+			const bool RDOK = FillBuffer(Reader, m_readBuffers[head].data(), BUFLEN, rlen);
+
+			{
+				std::lock_guard<std::mutex> lock(ringLock);
+				fillLength[head] = rlen;
+
+				if (rlen != 0)
+					++filled;
+				if (!RDOK)
+					failed = true;
+				if (!RDOK || rlen != BUFLEN)
+					endOfFile = true;
+			}
+
+			bufferFilled.notify_one();
+
+			if (!RDOK || rlen != BUFLEN)
+				return;
+
+			head = (head + 1) % QUEUELEN;
+		}
+	});
+
+	size_t tail = 0;
+
+	try
+	{
+		while (true)
+		{
+			size_t rlen = 0;
+
+			{
+				std::unique_lock<std::mutex> lock(ringLock);
+				bufferFilled.wait(lock, [&]() { return filled != 0 || endOfFile; });
+
+				if (filled == 0)
+					break;
+
+				rlen = fillLength[tail];
+			}
+
+			// the reader fills the following buffers while this one is hashed
+			m_msgDigest->Update(m_readBuffers[tail].data(), rlen);
+			Length += rlen;
+
+			{
+				std::lock_guard<std::mutex> lock(ringLock);
+				--filled;
+			}
+
+			bufferEmptied.notify_one();
+			tail = (tail + 1) % QUEUELEN;
+		}
+	}
+	catch (...)
+	{
+		{
+			std::lock_guard<std::mutex> lock(ringLock);
+			stopped = true;
+		}
+
+		bufferEmptied.notify_one();
+		reader.join();
+		throw;
+	}
+
+	reader.join();
+
+	return !failed;
+}
+
+bool FileDigest::ReadRanged(const std::function<bool(byte*, size_t, ulong, size_t&)> &Reader, ulong FileSize, ulong &Length)
+{
+	const size_t LEAFLEN = m_treeDigest->LeafLength();
+	// the last leaf ends the message; it is held back, and read through the buffer by the caller
+	const ulong LEAFCNT = (FileSize - 1) / LEAFLEN;
+	const size_t THDCNT = (LEAFCNT < m_readerCount) ? static_cast<size_t>(LEAFCNT) : m_readerCount;
+	size_t bufLen = (m_bufferSize > LEAFLEN) ? m_bufferSize - (m_bufferSize % LEAFLEN) : LEAFLEN;
+
+	if (m_bypassCache)
+	{
+		while (bufLen % BUFFER_ALIGN != 0)
+			bufLen += LEAFLEN;
+	}
+
+	if (m_readBuffers.size() < THDCNT)
+		m_readBuffers.resize(THDCNT);
+
+	for (size_t i = 0; i < THDCNT; ++i)
+	{
+		if (m_readBuffers[i].size() != bufLen)
+			m_readBuffers[i].resize(bufLen);
+	}
+
+	std::vector<Digest::BlakeTreeRange> ranges(THDCNT);
+	std::vector<std::exception_ptr> errors(THDCNT);
+	std::vector<byte> failed(THDCNT, 0);
+	std::vector<std::thread> readers;
+
+	// each reader reads and hashes its own contiguous range of leaves
+	const std::function<void(size_t)> READRNG = [&](size_t Index)
+	{
+		const ulong FRSTLEAF = (Index * LEAFCNT) / THDCNT;
+		const ulong RNGEND = (((Index + 1) * LEAFCNT) / THDCNT) * LEAFLEN;
+		byte* buf = m_readBuffers[Index].data();
+		ulong pos = FRSTLEAF * LEAFLEN;
+
+		ranges[Index] = Digest::BlakeTreeRange(FRSTLEAF);
+
+		try
+		{
+			while (pos < RNGEND)
+			{
+				const size_t RDLEN = (RNGEND - pos < bufLen) ? static_cast<size_t>(RNGEND - pos) : bufLen;
+				size_t rlen = 0;
+
+				while (rlen != RDLEN)
+				{
+					size_t plen = 0;
+
+					// a read that ends before the range; the file was truncated
+					if (!Reader(buf + rlen, RDLEN - rlen, pos + rlen, plen) || plen == 0)
+					{
+						failed[Index] = 1;
+						return;
+					}
+
+					rlen += plen;
+				}
+
+				m_treeDigest->UpdateRange(ranges[Index], buf, RDLEN);
+				pos += RDLEN;
+			}
+		}
+		catch (...)
+		{
+			errors[Index] = std::current_exception();
+		}
+	};
+
+	try
+	{
+		for (size_t i = 0; i < THDCNT; ++i)
+			readers.push_back(std::thread(READRNG, i));
+	}
+	catch (...)
+	{
+		for (size_t i = 0; i < readers.size(); ++i)
+			readers[i].join();
+
+		throw CryptoProcessingException("FileDigest:ReadRanged", "The reader threads could not be started!");
+	}
+
+	for (size_t i = 0; i < readers.size(); ++i)
+		readers[i].join();
+
+	for (size_t i = 0; i < THDCNT; ++i)
+	{
+		if (failed[i] != 0)
+			return false;
+	}
+
+	try
+	{
+		for (size_t i = 0; i < THDCNT; ++i)
+		{
+			if (errors[i])
+				std::rethrow_exception(errors[i]);
+		}
+
+		// the subtrees are joined in file order
+		for (size_t i = 0; i < THDCNT; ++i)
+			m_treeDigest->JoinRange(ranges[i]);
+	}
+	catch (std::exception& ex)
+	{
+		throw CryptoProcessingException("FileDigest:ReadRanged", "The file ranges could not be hashed!", std::string(ex.what()));
+	}
+
+	Length += LEAFCNT * LEAFLEN;
+
+	return true;
+}
+
+size_t FileDigest::ReadSize()
+{
+	size_t len = m_bufferSize;
+	size_t unit = 1;
+
+	// a parallel digest only runs its threads on updates of a multiple of the parallel block size
+	if (m_msgDigest->IsParallel() && m_msgDigest->ParallelBlockSize() != 0)
+	{
+		unit = m_msgDigest->ParallelBlockSize();
+		len = (unit >= len) ? unit : len - (len % unit);
+	}
+
+	// direct reads are a multiple of the storage block size; the alignment covers 512 byte and 4KB sectors
+	if (m_bypassCache)
+	{
+		if (unit == 1)
+			len = ((len + BUFFER_ALIGN - 1) / BUFFER_ALIGN) * BUFFER_ALIGN;
+
+		while (len % BUFFER_ALIGN != 0)
+			len += unit;
+	}
+
+	return len;
+}
+
+ulong FileDigest::UpdateFile(const std::string &FileName)
+{
+	ulong pos = 0;
+	bool success = true;
+
+#if defined(CEX_OS_WINDOWS)
+
+	HANDLE hFile = CreateFileA(FileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw CryptoProcessingException("FileDigest:UpdateFile", "The file could not be opened!");
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = 0;
+	const bool ISDISK = (GetFileType(hFile) == FILE_TYPE_DISK && GetFileSizeEx(hFile, &fileSize));
+	bool direct = false;
+
+	// ranged reads start on a leaf boundary; unbuffered reads must start on a sector boundary
+	if (m_bypassCache && ISDISK && (m_readMode != ReadModes::Ranged || m_treeDigest->LeafLength() % BUFFER_ALIGN == 0))
+	{
+		HANDLE hDirect = ReOpenFile(hFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN);
+
+		if (hDirect != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(hFile);
+			hFile = hDirect;
+			direct = true;
+		}
+	}
+
+	// pipes and character devices are read through the buffer
+	if (m_readMode == ReadModes::Mapped && !m_bypassCache && ISDISK && fileSize.QuadPart > 0)
+	{
+		const ulong FLELEN = static_cast<ulong>(fileSize.QuadPart);
+		HANDLE hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (hMap != NULL)
+		{
+			LARGE_INTEGER wndSize;
+
+			while (pos < FLELEN)
+			{
+				// the file changed size; the rest is read through the buffer
+				if (!GetFileSizeEx(hFile, &wndSize) || static_cast<ulong>(wndSize.QuadPart) != FLELEN)
+					break;
+
+				const size_t WNDLEN = (FLELEN - pos < MAP_WINDOW) ? static_cast<size_t>(FLELEN - pos) : MAP_WINDOW;
+				const void* view = MapViewOfFile(hMap, FILE_MAP_READ, static_cast<DWORD>(pos >> 32), static_cast<DWORD>(pos & 0xFFFFFFFFUL), WNDLEN);
+
+				if (view == NULL)
+					break;
+
+				m_msgDigest->Update(static_cast<const byte*>(view), WNDLEN);
+				UnmapViewOfFile(view);
+				pos += WNDLEN;
+			}
+
+			CloseHandle(hMap);
+		}
+
+		// a failed mapping, or a file that changed size, continues from the last hashed window
+		LARGE_INTEGER filePos;
+		filePos.QuadPart = static_cast<LONGLONG>(pos);
+		SetFilePointerEx(hFile, filePos, NULL, FILE_BEGIN);
+	}
+
+	const ulong FLELEN = static_cast<ulong>(fileSize.QuadPart);
+	ulong readPos = pos;
+
+	std::function<bool(byte*, size_t, size_t&)> reader = [hFile, direct, FLELEN, &readPos](byte* Output, size_t Length, size_t &Read)
+	{
+		DWORD rlen = 0;
+		Read = 0;
+
+		// an unbuffered read must start on a sector boundary; the short read at the end of the file is the last
+		if (direct && readPos >= FLELEN)
+			return true;
+
+		if (!ReadFile(hFile, Output, static_cast<DWORD>(Length), &rlen, NULL))
+		{
+			// the write end of a pipe was closed; the end of the stream
+			return (GetLastError() == ERROR_BROKEN_PIPE);
+		}
+
+		Read = rlen;
+		readPos += rlen;
+
+		return true;
+	};
+
+	// the ranged readers use their own overlapped handle; reads on a synchronous handle are serialized by the system,
+	// an overlapped handle has no file position, and each read waits on its own event
+	HANDLE hRange = INVALID_HANDLE_VALUE;
+
+	if (m_readMode == ReadModes::Ranged && ISDISK && FLELEN > m_treeDigest->LeafLength())
+		hRange = ReOpenFile(hFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_FLAG_OVERLAPPED | (direct ? FILE_FLAG_NO_BUFFERING : 0));
+
+	std::function<bool(byte*, size_t, ulong, size_t&)> posReader = [hRange](byte* Output, size_t Length, ulong Offset, size_t &Read)
+	{
+		OVERLAPPED ovl;
+		DWORD rlen = 0;
+		BOOL status;
+		Read = 0;
+
+		memset(&ovl, 0, sizeof(ovl));
+		ovl.Offset = static_cast<DWORD>(Offset & 0xFFFFFFFFUL);
+		ovl.OffsetHigh = static_cast<DWORD>(Offset >> 32);
+		ovl.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+		if (ovl.hEvent == NULL)
+			return false;
+
+		status = ReadFile(hRange, Output, static_cast<DWORD>(Length), NULL, &ovl);
+
+		if (status || GetLastError() == ERROR_IO_PENDING)
+			status = GetOverlappedResult(hRange, &ovl, &rlen, TRUE);
+
+		// a read at or past the end of the file fails with an end of file error, rather than returning zero bytes
+		const bool RDOK = (status || GetLastError() == ERROR_HANDLE_EOF);
+		CloseHandle(ovl.hEvent);
+
+		if (!RDOK)
+			return false;
+
+		Read = (status ? rlen : 0);
+
+		return true;
+	};
+
+	try
+	{
+		// when the handle could not be reopened, the whole file is read through the buffer
+		if (hRange != INVALID_HANDLE_VALUE)
+		{
+			success = ReadRanged(posReader, FLELEN, pos);
+			CloseHandle(hRange);
+			hRange = INVALID_HANDLE_VALUE;
+
+			// the last leaf is read through the buffer
+			LARGE_INTEGER filePos;
+			filePos.QuadPart = static_cast<LONGLONG>(pos);
+			SetFilePointerEx(hFile, filePos, NULL, FILE_BEGIN);
+			readPos = pos;
+		}
+
+		if (success)
+			success = (m_readMode == ReadModes::Pipelined) ? ReadPipelined(reader, pos) : ReadBuffered(reader, pos);
+	}
+	catch (...)
+	{
+		if (hRange != INVALID_HANDLE_VALUE)
+			CloseHandle(hRange);
+
+		CloseHandle(hFile);
+		throw;
+	}
+
+	CloseHandle(hFile);
+
+#elif defined(CEX_HAS_POSIXIO)
+
+	int fd;
+
+	do
+	{
+		fd = open(FileName.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+	while (fd == -1 && errno == EINTR);
+
+	if (fd == -1)
+		throw CryptoProcessingException("FileDigest:UpdateFile", "The file could not be opened!");
+
+	struct stat fileStat;
+	const bool ISREG = (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode));
+	bool direct = false;
+	bool dropCache = false;
+
+	if (m_bypassCache && ISREG)
+	{
+#	if defined(O_DIRECT)
+		const int FLAGS = fcntl(fd, F_GETFL);
+		direct = (FLAGS != -1 && fcntl(fd, F_SETFL, FLAGS | O_DIRECT) == 0);
+#	elif defined(F_NOCACHE)
+		direct = (fcntl(fd, F_NOCACHE, 1) != -1);
+#	endif
+#	if defined(O_DIRECT)
+		// ranged reads start on a leaf boundary, and are direct only if the leaves are block aligned
+		if (direct && m_readMode == ReadModes::Ranged && m_treeDigest->LeafLength() % BUFFER_ALIGN != 0)
+		{
+			const int FLAGS = fcntl(fd, F_GETFL);
+			direct = !(FLAGS != -1 && fcntl(fd, F_SETFL, FLAGS & ~O_DIRECT) == 0);
+		}
+#	endif
+		// the file system does not support direct reads; the pages are dropped from the cache as they are read
+		dropCache = !direct;
+	}
+
+	// pipes, sockets and devices are read through the buffer
+	if (m_readMode == ReadModes::Mapped && !m_bypassCache && ISREG && fileStat.st_size > 0)
+	{
+		const ulong FLELEN = static_cast<ulong>(fileStat.st_size);
+		struct stat wndStat;
+
+		while (pos < FLELEN)
+		{
+			// the file changed size; the rest is read through the buffer. This narrows, but does not close,
+			// the window in which a truncation by another process raises SIGBUS on the mapped pages
+			if (fstat(fd, &wndStat) != 0 || wndStat.st_size != fileStat.st_size)
+				break;
+
+			const size_t WNDLEN = (FLELEN - pos < MAP_WINDOW) ? static_cast<size_t>(FLELEN - pos) : MAP_WINDOW;
+			void* view = mmap(NULL, WNDLEN, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(pos));
+
+			if (view == MAP_FAILED)
+				break;
+
+			// doubles the read-ahead, and frees pages behind the reader sooner; both are hints, and may fail
+			madvise(view, WNDLEN, MADV_SEQUENTIAL);
+#	if defined(MADV_HUGEPAGE)
+			madvise(view, WNDLEN, MADV_HUGEPAGE);
+#	endif
+			m_msgDigest->Update(static_cast<const byte*>(view), WNDLEN);
+			munmap(view, WNDLEN);
+			pos += WNDLEN;
+		}
+
+		// a failed mapping, or a file that changed size, continues from the last hashed window
+		if (pos != 0)
+			lseek(fd, static_cast<off_t>(pos), SEEK_SET);
+	}
+	else
+	{
+#	if defined(POSIX_FADV_SEQUENTIAL)
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#	endif
+	}
+
+	ulong readPos = pos;
+
+	std::function<bool(byte*, size_t, size_t&)> reader = [fd, &direct, &dropCache, &readPos](byte* Output, size_t Length, size_t &Read)
+	{
+		ssize_t rlen;
+		Read = 0;
+
+		while (true)
+		{
+			rlen = read(fd, Output, Length);
+
+			if (rlen >= 0 || errno != EINTR)
+			{
+#	if defined(O_DIRECT)
+				// a direct read that is not block aligned, i.e. at the end of a file after the short read, or a device with larger blocks;
+				// the remainder of the file is read through the cache, and dropped from it
+				if (rlen < 0 && errno == EINVAL && direct)
+				{
+					const int FLAGS = fcntl(fd, F_GETFL);
+
+					if (FLAGS != -1 && fcntl(fd, F_SETFL, FLAGS & ~O_DIRECT) == 0)
+					{
+						direct = false;
+						dropCache = true;
+						continue;
+					}
+				}
+#	endif
+				break;
+			}
+		}
+
+		if (rlen < 0)
+			return false;
+
+#	if defined(POSIX_FADV_DONTNEED)
+		if (dropCache && rlen != 0)
+			posix_fadvise(fd, static_cast<off_t>(readPos), static_cast<off_t>(rlen), POSIX_FADV_DONTNEED);
+#	endif
+
+		Read = static_cast<size_t>(rlen);
+		readPos += Read;
+
+		return true;
+	};
+
+	// shared by the ranged reader threads; set when a reader falls back to cached reads
+	std::atomic<bool> rangeCached(dropCache);
+
+	std::function<bool(byte*, size_t, ulong, size_t&)> posReader = [fd, direct, &rangeCached](byte* Output, size_t Length, ulong Offset, size_t &Read)
+	{
+		ssize_t rlen;
+		bool retried = false;
+		Read = 0;
+
+		// positional reads do not share the file offset, and run concurrently
+		while (true)
+		{
+			rlen = pread(fd, Output, Length, static_cast<off_t>(Offset));
+
+			if (rlen >= 0 || errno != EINTR)
+			{
+#	if defined(O_DIRECT)
+				// a direct read the device rejects is read through the cache, as with the sequential reader;
+				// the flag is on the shared file description, so the first reader to fail clears it for all of them
+				if (rlen < 0 && errno == EINVAL && direct && !retried)
+				{
+					const int FLAGS = fcntl(fd, F_GETFL);
+
+					if (FLAGS != -1 && ((FLAGS & O_DIRECT) == 0 || fcntl(fd, F_SETFL, FLAGS & ~O_DIRECT) == 0))
+					{
+						rangeCached = true;
+						retried = true;
+						continue;
+					}
+				}
+#	endif
+				break;
+			}
+		}
+
+		if (rlen < 0)
+			return false;
+
+#	if defined(POSIX_FADV_DONTNEED)
+		if (rangeCached && rlen != 0)
+			posix_fadvise(fd, static_cast<off_t>(Offset), static_cast<off_t>(rlen), POSIX_FADV_DONTNEED);
+#	endif
+
+		Read = static_cast<size_t>(rlen);
+
+		return true;
+	};
+
+	try
+	{
+		if (m_readMode == ReadModes::Ranged && ISREG && static_cast<ulong>(fileStat.st_size) > m_treeDigest->LeafLength())
+		{
+			success = ReadRanged(posReader, static_cast<ulong>(fileStat.st_size), pos);
+
+			// a ranged reader cleared the direct flag; the last leaf is read through the cache
+			if (rangeCached && direct)
+			{
+				direct = false;
+				dropCache = true;
+			}
+
+			// the last leaf is read through the buffer
+			lseek(fd, static_cast<off_t>(pos), SEEK_SET);
+			readPos = pos;
+		}
+
+		if (success)
+			success = (m_readMode == ReadModes::Pipelined) ? ReadPipelined(reader, pos) : ReadBuffered(reader, pos);
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+
+	close(fd);
+
+#else
+
+	std::ifstream inFile(FileName.c_str(), std::ifstream::in | std::ifstream::binary);
+
+	if (!inFile.is_open())
+		throw CryptoProcessingException("FileDigest:UpdateFile", "The file could not be opened!");
+
+	std::function<bool(byte*, size_t, size_t&)> reader = [&inFile](byte* Output, size_t Length, size_t &Read)
+	{
+		inFile.read(reinterpret_cast<char*>(Output), Length);
+		Read = static_cast<size_t>(inFile.gcount());
+
+		return !inFile.bad();
+	};
+
+	success = (m_readMode == ReadModes::Pipelined) ? ReadPipelined(reader, pos) : ReadBuffered(reader, pos);
+
+#endif
+
+	if (!success)
+		throw CryptoProcessingException("FileDigest:UpdateFile", "The file could not be read!");
+
+	return pos;
+}
+
+NAMESPACE_IOEND
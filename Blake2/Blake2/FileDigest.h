@@ -0,0 +1,207 @@
+#ifndef _CEX_FILEDIGEST_H
+#define _CEX_FILEDIGEST_H
+
+#include "CexDomain.h"
+#include "AlignedAllocator.h"
+#include "BlakeTree.h"
+#include "CryptoProcessingException.h"
+#include "Digests.h"
+#include "IDigest.h"
+#include <functional>
+
+NAMESPACE_IO
+
+using Exception::CryptoProcessingException;
+using Enumeration::Digests;
+using Digest::IDigest;
+
+/// <summary>
+/// Hashes a file with a message digest, reading the file directly into the digests compression kernels.
+/// <para>Regular files are memory mapped and hashed from the mapping; pipes, devices, and files that can not be mapped are read through a buffer.
+/// In the pipelined mode a reader thread fills a ring of buffers while the digest hashes the previous buffer.
+/// In the ranged mode several reader threads each read and hash their own part of the file, as subtrees of a BlakeTree.</para>
+/// </summary>
+///
+/// <example>
+/// <description>Hashing a file with the parallel Blake512:</description>
+/// <code>
+/// FileDigest fdg(Digests::Blake512, true);
+/// std:vector&lt;byte&gt; hash(fdg.DigestSize());
+/// fdg.Compute("volume.img", hash);
+/// </code>
+/// </example>
+///
+/// <remarks>
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>A mapped file is hashed in windows of 64MB; each window is mapped read-only, advised as sequential, with a transparent huge page hint where the platform has one, and unmapped once hashed.</description></item>
+/// <item><description>Mapping removes the copy from the page cache into a user buffer; the digest reads the cached pages directly.</description></item>
+/// <item><description>The pipelined mode overlaps the read latency with hashing; a reader thread fills up to QueueDepth() buffers of BufferSize() bytes ahead of the digest. It is suited to a parallel digest, or to storage that is slower than the digest, where waiting on each read leaves the digest idle.</description></item>
+/// <item><description>The ranged mode splits a regular file into ReaderCount() contiguous ranges of whole leaves; each reader thread reads its range with positional reads, and hashes it with BlakeTree::UpdateRange. The subtrees are joined in file order, and the last leaf is read and hashed by the calling thread; the digest is the same as hashing the file with the tree sequentially. Many concurrent readers keep a deep queue of requests on solid state storage, and the reader count may exceed the processor count.</description></item>
+/// <item><description>The read buffers are page aligned, and are kept between files; a buffer is filled completely before it is hashed, so a parallel digest is always given full parallel blocks, even from a pipe.</description></item>
+/// <item><description>With BypassCache() set, regular files are read around the page cache, so that hashing does not evict the cached data of other processes. On linux the file is read with O_DIRECT, in multiples of the 4KB buffer alignment; where the file system does not support direct reads, the pages are dropped from the cache with posix_fadvise(POSIX_FADV_DONTNEED) as they are hashed. Apple targets use F_NOCACHE, and windows FILE_FLAG_NO_BUFFERING.</description></item>
+/// <item><description>A file with a reported size of zero is read through the buffer, so that special files that report no size, such as pipes or procfs entries, are hashed completely.</description></item>
+/// <item><description>If a mapping fails, the remainder of the file is read through the buffer; the digest is the same either way.</description></item>
+/// <item><description>A mapped file that is truncated by another process while it is being hashed raises a bus error (SIGBUS) on posix systems; use ReadModes::Buffered for files that may change during hashing.</description></item>
+/// <item><description>A digest passed by pointer is not reset before hashing, so a digest initialized with a key produces a keyed code of the file; the digest is reset after each file, and a key must be set again for the next.</description></item>
+/// </list>
+/// </remarks>
+class FileDigest
+{
+public:
+
+	//~~~Enums~~~//
+
+	/// <summary>
+	/// The file read method
+	/// </summary>
+	enum class ReadModes : int
+	{
+		/// <summary>
+		/// Map regular files; pipes, devices, and files that can not be mapped are read through a buffer
+		/// <para>The file size is checked before each window is mapped, and a file that changes size is read through the buffer from that window.
+		/// A POSIX file truncated by another process while a window is mapped raises SIGBUS when the missing pages are read; use Buffered for files that may be truncated while they are hashed.</para>
+		/// </summary>
+		Mapped = 0,
+		/// <summary>
+		/// Read the file through a buffer
+		/// </summary>
+		Buffered = 1,
+		/// <summary>
+		/// Read the file through a ring of buffers on a reader thread, while the digest hashes the previous buffer
+		/// </summary>
+		Pipelined = 2,
+		/// <summary>
+		/// Read contiguous ranges of a regular file on several reader threads, each hashed as subtrees of a BlakeTree digest; other files are read through a buffer
+		/// </summary>
+		Ranged = 3
+	};
+
+private:
+
+	static const size_t BUFFER_ALIGN = 4096;
+	static const size_t BUFFER_SIZE = 1024 * 1024;
+	static const size_t DEF_QUEUEDEPTH = 4;
+	// a multiple of the page size and of the windows allocation granularity
+	static const size_t MAP_WINDOW = 64 * 1024 * 1024;
+
+	typedef std::vector<byte, Utility::AlignedAllocator<byte, BUFFER_ALIGN>> AlignedBuffer;
+
+	size_t m_bufferSize;
+	bool m_bypassCache;
+	bool m_destroyEngine;
+	bool m_isDestroyed;
+	IDigest* m_msgDigest;
+	size_t m_queueDepth;
+	std::vector<AlignedBuffer> m_readBuffers;
+	size_t m_readerCount;
+	ReadModes m_readMode;
+	Digest::BlakeTree* m_treeDigest;
+
+public:
+
+	FileDigest() = delete;
+	FileDigest(const FileDigest&) = delete;
+	FileDigest& operator=(const FileDigest&) = delete;
+	FileDigest& operator=(FileDigest&&) = delete;
+
+	//~~~Properties~~~//
+
+	/// <summary>
+	/// Get/Set: Read regular files around the page cache; the buffered or pipelined read mode is used, and files are not mapped.
+	/// <para>The default is false. Intended for background scrubbing of large volumes, where cached file data would evict the working set of other processes.</para>
+	/// </summary>
+	bool &BypassCache() { return m_bypassCache; }
+
+	/// <summary>
+	/// Get/Set: The size of a read buffer in bytes; the default is 1MB.
+	/// <para>With a parallel digest the size is rounded to a multiple of the digests ParallelBlockSize(), and with BypassCache() to a multiple of 4KB.</para>
+	/// </summary>
+	size_t &BufferSize() { return m_bufferSize; }
+
+	/// <summary>
+	/// Get: The underlying digest
+	/// </summary>
+	IDigest* Digest() { return m_msgDigest; }
+
+	/// <summary>
+	/// Get: Size of the returned digest in bytes
+	/// </summary>
+	const size_t DigestSize() { return m_msgDigest->DigestSize(); }
+
+	/// <summary>
+	/// Get: The digest type name
+	/// </summary>
+	const Digests DigestType() { return m_msgDigest->Enumeral(); }
+
+	/// <summary>
+	/// Get/Set: The number of buffers in the pipelined read ring; at least 2, the default is 4
+	/// </summary>
+	size_t &QueueDepth() { return m_queueDepth; }
+
+	/// <summary>
+	/// Get/Set: The number of reader threads in the ranged read mode; the default is the processor count
+	/// </summary>
+	size_t &ReaderCount() { return m_readerCount; }
+
+	/// <summary>
+	/// Get/Set: The file read method; the default is ReadModes::Mapped
+	/// </summary>
+	ReadModes &ReadMode() { return m_readMode; }
+
+	//~~~Constructor~~~//
+
+	/// <summary>
+	/// Instantiate the class with a digest type
+	/// </summary>
+	///
+	/// <param name="DigestType">The message digest enumeration name</param>
+	/// <param name="Parallel">Use the multi-threaded version of the digest</param>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the digest type is not supported</exception>
+	explicit FileDigest(Digests DigestType, bool Parallel = false);
+
+	/// <summary>
+	/// Instantiate the class with a digest instance; the digest is not destroyed by this class
+	/// </summary>
+	///
+	/// <param name="Digest">The message digest instance; may be keyed. The ranged read mode requires a BlakeTree</param>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the digest is null</exception>
+	explicit FileDigest(IDigest* Digest);
+
+	/// <summary>
+	/// Finalize objects
+	/// </summary>
+	~FileDigest();
+
+	//~~~Public Functions~~~//
+
+	/// <summary>
+	/// Hash a file and return the digest
+	/// </summary>
+	///
+	/// <param name="FileName">The full path and name of the file; may name a pipe or device</param>
+	/// <param name="Output">The digest output array; resized to DigestSize()</param>
+	///
+	/// <returns>The number of bytes hashed</returns>
+	///
+	/// <exception cref="Exception::CryptoProcessingException">Thrown if the file can not be opened or read, the buffer size, queue depth or reader count is invalid, or the ranged mode is used without a BlakeTree digest</exception>
+	ulong Compute(const std::string &FileName, std::vector<byte> &Output);
+
+	/// <summary>
+	/// Release all resources associated with the object
+	/// </summary>
+	void Destroy();
+
+private:
+	static bool FillBuffer(const std::function<bool(byte*, size_t, size_t&)> &Reader, byte* Output, size_t Length, size_t &Read);
+	bool ReadBuffered(const std::function<bool(byte*, size_t, size_t&)> &Reader, ulong &Length);
+	bool ReadPipelined(const std::function<bool(byte*, size_t, size_t&)> &Reader, ulong &Length);
+	bool ReadRanged(const std::function<bool(byte*, size_t, ulong, size_t&)> &Reader, ulong FileSize, ulong &Length);
+	size_t ReadSize();
+	ulong UpdateFile(const std::string &FileName);
+};
+
+NAMESPACE_IOEND
+#endif
@@ -10,12 +10,19 @@ HMAC::HMAC(Digests DigestType, bool Parallel)
 	:
 	m_msgDigest(Helper::DigestFromName::GetInstance(DigestType, Parallel)),
 	m_destroyEngine(true),
-	m_inputPad(m_msgDigest->BlockSize()),
 	m_isDestroyed(false),
 	m_isInitialized(false),
+	m_chainDigest256(0),
+	m_chainDigest512(0),
+	m_inputPad(m_msgDigest->BlockSize()),
+	m_inputState256(),
+	m_inputState512(),
+	m_innerHash(m_msgDigest->DigestSize()),
 	m_legalKeySizes(0),
 	m_msgDigestType(DigestType),
-	m_outputPad(m_msgDigest->BlockSize())
+	m_outputPad(m_msgDigest->BlockSize()),
+	m_outputState256(),
+	m_outputState512()
 {
 	Scope();
 }
@@ -24,12 +31,19 @@ HMAC::HMAC(IDigest* Digest)
 	:
 	m_msgDigest(Digest != 0 ? Digest : throw CryptoMacException("HMAC:Ctor", "The digest can not be null!")),
 	m_destroyEngine(false),
-	m_inputPad(m_msgDigest->BlockSize()),
 	m_isDestroyed(false),
 	m_isInitialized(false),
+	m_chainDigest256(0),
+	m_chainDigest512(0),
+	m_inputPad(m_msgDigest->BlockSize()),
+	m_inputState256(),
+	m_inputState512(),
+	m_innerHash(m_msgDigest->DigestSize()),
 	m_legalKeySizes(0),
 	m_msgDigestType(m_msgDigest->Enumeral()),
-	m_outputPad(m_msgDigest->BlockSize())
+	m_outputPad(m_msgDigest->BlockSize()),
+	m_outputState256(),
+	m_outputState512()
 {
 	Scope();
 }
@@ -57,6 +71,8 @@ void HMAC::Destroy()
 		m_msgDigestType = Digests::None;
 		m_isDestroyed = true;
 		m_isInitialized = false;
+		m_chainDigest256 = 0;
+		m_chainDigest512 = 0;
 
 		try
 		{
@@ -68,9 +84,14 @@ void HMAC::Destroy()
 					delete m_msgDigest;
 			}
 
+			Utility::ArrayUtils::ClearVector(m_innerHash);
 			Utility::ArrayUtils::ClearVector(m_inputPad);
 			Utility::ArrayUtils::ClearVector(m_legalKeySizes);
 			Utility::ArrayUtils::ClearVector(m_outputPad);
+			m_inputState256 = Digest::Blake2sKeyedState();
+			m_inputState512 = Digest::Blake2bKeyedState();
+			m_outputState256 = Digest::Blake2sKeyedState();
+			m_outputState512 = Digest::Blake2bKeyedState();
 		}
 		catch (std::exception& ex)
 		{
@@ -83,17 +104,23 @@ size_t HMAC::Finalize(std::vector<byte> &Output, size_t OutOffset)
 {
 	if (!m_isInitialized)
 		throw CryptoMacException("HMAC:Finalize", "The Mc has not been initialized!");
-	if (Output.size() - OutOffset < m_msgDigest->DigestSize())
+	if (Output.size() < OutOffset + m_msgDigest->DigestSize())
 		throw CryptoMacException("HMAC:Finalize", "The Output buffer is too short!");
 
-	std::vector<byte> tmpV(m_msgDigest->DigestSize(), 0);
-	m_msgDigest->Finalize(tmpV, 0);
-	m_msgDigest->Update(m_outputPad, 0, m_outputPad.size());
-	m_msgDigest->Update(tmpV, 0, tmpV.size());
+	return Finalize(&Output[OutOffset]);
+}
 
-	size_t msgLen = m_msgDigest->Finalize(Output, OutOffset);
-	m_msgDigest->Reset(); // TODO: still necessary?
-	m_msgDigest->Update(m_inputPad, 0, m_inputPad.size());
+size_t HMAC::Finalize(byte* Output)
+{
+	if (!m_isInitialized)
+		throw CryptoMacException("HMAC:Finalize", "The Mc has not been initialized!");
+
+	m_msgDigest->Finalize(&m_innerHash[0]);
+	LoadOutputPad();
+	m_msgDigest->Update(&m_innerHash[0], m_innerHash.size());
+
+	size_t msgLen = m_msgDigest->Finalize(Output);
+	LoadInputPad();
 
 	return msgLen;
 }
@@ -128,7 +155,8 @@ void HMAC::Initialize(ISymmetricKey &KeyParams)
 	memcpy(&m_outputPad[0], &m_inputPad[0], m_msgDigest->BlockSize());
 	XorPad(m_inputPad, IPAD);
 	XorPad(m_outputPad, OPAD);
-	m_msgDigest->Update(m_inputPad, 0, m_inputPad.size());
+	CachePads();
+	LoadInputPad();
 
 	m_isInitialized = true;
 }
@@ -143,10 +171,24 @@ void HMAC::ParallelMaxDegree(size_t Degree)
 	{
 		throw CryptoMacException("HMAC:ParallelMaxDegree", "The Degree value must be a non-zero even number less than the number of processor cores!");
 	}
+
+	// the digest was reset, and may have changed mode; the pad states are cached only by a sequential digest, so the pads are reloaded
+	if (m_isInitialized)
+	{
+		CachePads();
+		LoadInputPad();
+	}
+	else
+	{
+		m_chainDigest256 = 0;
+		m_chainDigest512 = 0;
+	}
 }
 
 void HMAC::Reset()
 {
+	m_chainDigest256 = 0;
+	m_chainDigest512 = 0;
 	m_msgDigest->Reset();
 	m_inputPad.clear();
 	m_inputPad.resize(m_msgDigest->BlockSize());
@@ -170,8 +212,74 @@ void HMAC::Update(const std::vector<byte> &Input, size_t InOffset, size_t Length
 	m_msgDigest->Update(Input, InOffset, Length);
 }
 
+void HMAC::Update(const byte* Input, size_t Length)
+{
+	if (!m_isInitialized)
+		throw CryptoMacException("HMAC:Update", "The Mac has not been initialized!");
+
+	m_msgDigest->Update(Input, Length);
+}
+
 //~~~Private Functions~~~//
 
+void HMAC::CachePads()
+{
+	m_chainDigest256 = 0;
+	m_chainDigest512 = 0;
+
+	// a sequential Blake2 digest buffers each pad as one full block; capture the state after each, so messages restore it rather than compress the pads
+	if (!m_msgDigest->IsParallel())
+	{
+		if (m_msgDigestType == Digests::Blake512)
+		{
+			m_chainDigest512 = dynamic_cast<Digest::Blake512*>(m_msgDigest);
+		}
+		else if (m_msgDigestType == Digests::Blake256)
+		{
+			m_chainDigest256 = dynamic_cast<Digest::Blake256*>(m_msgDigest);
+		}
+	}
+
+	if (m_chainDigest512 != 0)
+	{
+		m_msgDigest->Update(&m_inputPad[0], m_inputPad.size());
+		m_chainDigest512->GetKeyedState(m_inputState512);
+		m_msgDigest->Reset();
+		m_msgDigest->Update(&m_outputPad[0], m_outputPad.size());
+		m_chainDigest512->GetKeyedState(m_outputState512);
+		m_msgDigest->Reset();
+	}
+	else if (m_chainDigest256 != 0)
+	{
+		m_msgDigest->Update(&m_inputPad[0], m_inputPad.size());
+		m_chainDigest256->GetKeyedState(m_inputState256);
+		m_msgDigest->Reset();
+		m_msgDigest->Update(&m_outputPad[0], m_outputPad.size());
+		m_chainDigest256->GetKeyedState(m_outputState256);
+		m_msgDigest->Reset();
+	}
+}
+
+void HMAC::LoadInputPad()
+{
+	if (m_chainDigest512 != 0)
+		m_chainDigest512->LoadKeyedState(m_inputState512);
+	else if (m_chainDigest256 != 0)
+		m_chainDigest256->LoadKeyedState(m_inputState256);
+	else
+		m_msgDigest->Update(&m_inputPad[0], m_inputPad.size());
+}
+
+void HMAC::LoadOutputPad()
+{
+	if (m_chainDigest512 != 0)
+		m_chainDigest512->LoadKeyedState(m_outputState512);
+	else if (m_chainDigest256 != 0)
+		m_chainDigest256->LoadKeyedState(m_outputState256);
+	else
+		m_msgDigest->Update(&m_outputPad[0], m_outputPad.size());
+}
+
 void HMAC::Scope()
 {
 	m_legalKeySizes.resize(3);
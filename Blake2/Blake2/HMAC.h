@@ -27,6 +27,8 @@
 #define _CEX_HMAC_H
 
 #include "IMac.h"
+#include "Blake256.h"
+#include "Blake512.h"
 #include "IDigest.h"
 #include "Digests.h"
 
@@ -74,6 +76,7 @@ using Common::ParallelOptions;
 /// <item><description>The Compute(Input, Output) method wraps the Update(Input, Offset, Length) and Finalize(Output, Offset) methods and should only be used on small to medium sized data.</description>/></item>
 /// <item><description>The Update(Input, Offset, Length) processes any length of message data, and is used in conjunction with the Finalize(Output, Offset) method, which returns the final MAC code.</description>/></item>
 /// <item><description>After a finalizer call (Finalize or Compute), the Mac functions state is reset and must be re-initialized with a new key.</description></item>
+/// <item><description>With a sequential Blake2 digest, the digest states after the input and output pads are captured once by Initialize, and restored for each message; the two pad blocks are not compressed again.</description></item>
 /// </list>
 /// 
 /// <description>Guiding Publications:</description>
@@ -95,10 +98,17 @@ private:
 	bool m_destroyEngine;
 	bool m_isDestroyed;
 	bool m_isInitialized;
+	Digest::Blake256* m_chainDigest256;
+	Digest::Blake512* m_chainDigest512;
 	std::vector<byte> m_inputPad;
+	Digest::Blake2sKeyedState m_inputState256;
+	Digest::Blake2bKeyedState m_inputState512;
+	std::vector<byte> m_innerHash;
 	std::vector<SymmetricKeySize> m_legalKeySizes;
 	Digests m_msgDigestType;
 	std::vector<byte> m_outputPad;
+	Digest::Blake2sKeyedState m_outputState256;
+	Digest::Blake2bKeyedState m_outputState512;
 
 public:
 
@@ -221,6 +231,18 @@ public:
 	/// <exception cref="CryptoMacException">Thrown if Output array is too small</exception>
 	virtual size_t Finalize(std::vector<byte> &Output, size_t OutOffset);
 
+	/// <summary>
+	/// Process the data and write the Mac code to caller memory
+	/// <para>After calling this function the Macs state is reset and must be re-initialized with a new key.</para>
+	/// </summary>
+	/// 
+	/// <param name="Output">Pointer to the destination; must have room for MacSize() bytes</param>
+	/// 
+	/// <returns>The number of bytes processed</returns>
+	/// 
+	/// <exception cref="CryptoMacException">Thrown if the Mac has not been initialized</exception>
+	virtual size_t Finalize(byte* Output);
+
 	/// <summary>
 	/// Initialize the MAC generator with a SymmetricKey key container.
 	/// <para>Uses a key array to initialize the MAC.
@@ -262,7 +284,20 @@ public:
 	/// <param name="Length">The length of data to process in bytes</param>
 	virtual void Update(const std::vector<byte> &Input, size_t InOffset, size_t Length);
 
+	/// <summary>
+	/// Update the Mac with a block of bytes read directly from caller memory
+	/// </summary>
+	/// 
+	/// <param name="Input">Pointer to the input data</param>
+	/// <param name="Length">The length of data to process in bytes</param>
+	/// 
+	/// <exception cref="CryptoMacException">Thrown if the Mac has not been initialized</exception>
+	virtual void Update(const byte* Input, size_t Length);
+
 private:
+	void CachePads();
+	void LoadInputPad();
+	void LoadOutputPad();
 	void Scope();
 	void XorPad(std::vector<byte> &A, byte N);
 };
@@ -104,6 +104,15 @@ public:
 	/// <returns>Size of Hash value</returns>
 	virtual size_t Finalize(std::vector<byte> &Output, const size_t OutOffset) = 0;
 
+	/// <summary>
+	/// Do final processing and write the hash value to caller memory
+	/// </summary>
+	/// 
+	/// <param name="Output">Pointer to the destination; must have room for DigestSize() bytes</param>
+	/// 
+	/// <returns>Size of Hash value</returns>
+	virtual size_t Finalize(byte* Output) = 0;
+
 	/// <summary>
 	/// Set the number of threads allocated when using multi-threaded tree hashing processing.
 	/// <para>Thread count must be an even number, and not exceed the number of processor cores.
@@ -133,6 +142,14 @@ public:
 	/// <param name="InOffset">The starting offset within the Input array</param>
 	/// <param name="Length">Amount of data to process in bytes</param>
 	virtual void Update(const std::vector<byte> &Input, size_t InOffset, size_t Length) = 0;
+
+	/// <summary>
+	/// Update the buffer from caller memory; the message is read in place, without a copy into a vector
+	/// </summary>
+	/// 
+	/// <param name="Input">Pointer to the input data</param>
+	/// <param name="Length">Amount of data to process in bytes</param>
+	virtual void Update(const byte* Input, size_t Length) = 0;
 };
 
 NAMESPACE_DIGESTEND
@@ -89,6 +89,15 @@ public:
 	/// <returns>The number of bytes processed</returns>
 	virtual size_t Finalize(std::vector<byte> &Output, size_t OutOffset) = 0;
 
+	/// <summary>
+	/// Completes processing and writes the HMAC code to caller memory
+	/// </summary>
+	///
+	/// <param name="Output">Pointer to the destination; must have room for MacSize() bytes</param>
+	///
+	/// <returns>The number of bytes processed</returns>
+	virtual size_t Finalize(byte* Output) = 0;
+
 	/// <summary>
 	/// Initialize the MAC generator with a SymmetricKey key container.
 	/// <para>Uses a key and optional salt and info arrays to initialize the MAC.</para>
@@ -117,6 +126,14 @@ public:
 	/// <param name="InOffset">Starting position with the input array</param>
 	/// <param name="Length">The length of data to process in bytes</param>
 	virtual void Update(const std::vector<byte> &Input, size_t InOffset, size_t Length) = 0;
+
+	/// <summary>
+	/// Update the Mac with a block of bytes read directly from caller memory
+	/// </summary>
+	/// 
+	/// <param name="Input">Pointer to the input data</param>
+	/// <param name="Length">The length of data to process in bytes</param>
+	virtual void Update(const byte* Input, size_t Length) = 0;
 };
 
 NAMESPACE_MACEND
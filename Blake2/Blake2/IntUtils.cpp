@@ -330,6 +330,31 @@ void IntUtils::LeUL256ToBlock(std::vector<uint> &Input, std::vector<byte> &Outpu
 #endif
 }
 
+void IntUtils::LeUL256ToBlock(const uint* Input, byte* Output)
+{
+#if defined(IS_LITTLE_ENDIAN)
+	memcpy(Output, Input, 8 * sizeof(uint));
+#else
+	for (size_t i = 0; i < 8; ++i)
+	{
+		Output[i * 4] = static_cast<byte>(Input[i]);
+		Output[(i * 4) + 1] = static_cast<byte>(Input[i] >> 8);
+		Output[(i * 4) + 2] = static_cast<byte>(Input[i] >> 16);
+		Output[(i * 4) + 3] = static_cast<byte>(Input[i] >> 24);
+	}
+#endif
+}
+
+void IntUtils::LeUL256ToBlock(const uint* Input, byte* Output, size_t Length)
+{
+#if defined(IS_LITTLE_ENDIAN)
+	memcpy(Output, Input, Length);
+#else
+	for (size_t i = 0; i < Length; ++i)
+		Output[i] = static_cast<byte>(Input[i / 4] >> ((i % 4) * 8));
+#endif
+}
+
 void IntUtils::LeULL256ToBlock(std::vector<ulong> &Input, std::vector<byte> &Output, size_t OutOffset)
 {
 #if defined(IS_LITTLE_ENDIAN)
@@ -358,6 +383,29 @@ void IntUtils::LeULL512ToBlock(std::vector<ulong> &Input, std::vector<byte> &Out
 #endif
 }
 
+void IntUtils::LeULL512ToBlock(const ulong* Input, byte* Output)
+{
+#if defined(IS_LITTLE_ENDIAN)
+	memcpy(Output, Input, 8 * sizeof(ulong));
+#else
+	for (size_t i = 0; i < 8; ++i)
+	{
+		for (size_t j = 0; j < 8; ++j)
+			Output[(i * 8) + j] = static_cast<byte>(Input[i] >> (j * 8));
+	}
+#endif
+}
+
+void IntUtils::LeULL512ToBlock(const ulong* Input, byte* Output, size_t Length)
+{
+#if defined(IS_LITTLE_ENDIAN)
+	memcpy(Output, Input, Length);
+#else
+	for (size_t i = 0; i < Length; ++i)
+		Output[i] = static_cast<byte>(Input[i / 8] >> ((i % 8) * 8));
+#endif
+}
+
 void IntUtils::LeULL1024ToBlock(std::vector<ulong> &Input, std::vector<byte> &Output, size_t OutOffset)
 {
 #if defined(IS_LITTLE_ENDIAN)
@@ -453,6 +501,22 @@ void IntUtils::BytesToLeUL512(const std::vector<byte> &Input, const size_t InOff
 #endif
 }
 
+void IntUtils::BytesToLeUL512(const byte* Input, uint* Output)
+{
+#if defined(IS_LITTLE_ENDIAN)
+	memcpy(Output, Input, 16 * sizeof(uint));
+#else
+	for (size_t i = 0; i < 16; ++i)
+	{
+		Output[i] =
+			(static_cast<uint>(Input[i * 4]) |
+			(static_cast<uint>(Input[(i * 4) + 1]) << 8) |
+			(static_cast<uint>(Input[(i * 4) + 2]) << 16) |
+			(static_cast<uint>(Input[(i * 4) + 3]) << 24));
+	}
+#endif
+}
+
 void IntUtils::BytesToLeULL256(const std::vector<byte> &Input, const size_t InOffset, std::vector<ulong> &Output, size_t OutOffset)
 {
 #if defined(IS_LITTLE_ENDIAN)
@@ -505,6 +569,21 @@ void IntUtils::BytesToLeULL1024(const std::vector<byte> &Input, const size_t InO
 #endif
 }
 
+void IntUtils::BytesToLeULL1024(const byte* Input, ulong* Output)
+{
+#if defined(IS_LITTLE_ENDIAN)
+	memcpy(Output, Input, 16 * sizeof(ulong));
+#else
+	for (size_t i = 0; i < 16; ++i)
+	{
+		Output[i] = 0;
+
+		for (size_t j = 0; j < 8; ++j)
+			Output[i] |= (static_cast<ulong>(Input[(i * 8) + j]) << (j * 8));
+	}
+#endif
+}
+
 ulong IntUtils::Crop(ulong Value, uint size)
 {
 	if (size < 8 * sizeof(Value))
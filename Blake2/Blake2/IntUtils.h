@@ -448,6 +448,23 @@ public:
 	/// <param name="OutOffset">OutOffset within the destination block</param>
 	static void LeUL256ToBlock(std::vector<uint> &Input, std::vector<byte> &Output, size_t OutOffset);
 
+	/// <summary>
+	/// Convert a Little Endian 8 * 32bit word array to 32 bytes of caller memory
+	/// </summary>
+	/// 
+	/// <param name="Input">The 32bit word array</param>
+	/// <param name="Output">Pointer to the destination bytes</param>
+	static void LeUL256ToBlock(const uint* Input, byte* Output);
+
+	/// <summary>
+	/// Convert the first Length bytes of a Little Endian 8 * 32bit word array to caller memory
+	/// </summary>
+	/// 
+	/// <param name="Input">The 32bit word array</param>
+	/// <param name="Output">Pointer to the destination bytes</param>
+	/// <param name="Length">The number of bytes to write; at most 32</param>
+	static void LeUL256ToBlock(const uint* Input, byte* Output, size_t Length);
+
 	/// <summary>
 	/// Convert a Little Endian 4 * 64bit word array to a byte array
 	/// </summary>
@@ -466,6 +483,23 @@ public:
 	/// <param name="OutOffset">OutOffset within the destination block</param>
 	static void LeULL512ToBlock(std::vector<ulong> &Input, std::vector<byte> &Output, size_t OutOffset);
 
+	/// <summary>
+	/// Convert a Little Endian 8 * 64bit word array to 64 bytes of caller memory
+	/// </summary>
+	/// 
+	/// <param name="Input">The 64bit word array</param>
+	/// <param name="Output">Pointer to the destination bytes</param>
+	static void LeULL512ToBlock(const ulong* Input, byte* Output);
+
+	/// <summary>
+	/// Convert the first Length bytes of a Little Endian 8 * 64bit word array to caller memory
+	/// </summary>
+	/// 
+	/// <param name="Input">The 64bit word array</param>
+	/// <param name="Output">Pointer to the destination bytes</param>
+	/// <param name="Length">The number of bytes to write; at most 64</param>
+	static void LeULL512ToBlock(const ulong* Input, byte* Output, size_t Length);
+
 	/// <summary>
 	/// Convert a Little Endian 16 * 64bit word array to a byte array
 	/// </summary>
@@ -513,6 +547,14 @@ public:
 	/// <returns>An array of 32 bit words in Little Endian format</returns>
 	static void BytesToLeUL512(const std::vector<byte> &Input, const size_t InOffset, std::vector<uint> &Output, const size_t OutOffset);
 
+	/// <summary>
+	/// Convert 64 bytes of caller memory to a Little Endian 16 * 32bit word array
+	/// </summary>
+	/// 
+	/// <param name="Input">Pointer to the source bytes</param>
+	/// <param name="Output">Pointer to the 16 output words</param>
+	static void BytesToLeUL512(const byte* Input, uint* Output);
+
 	/// <summary>
 	/// Convert a byte array to a Little Endian 4 * 64bit word array
 	/// </summary>
@@ -546,6 +588,14 @@ public:
 	/// <returns>An array of 32 bit words in Little Endian format</returns>
 	static void BytesToLeULL1024(const std::vector<byte> &Input, const size_t InOffset, std::vector<ulong> &Output, size_t OutOffset);
 
+	/// <summary>
+	/// Convert 128 bytes of caller memory to a Little Endian 16 * 64bit word array
+	/// </summary>
+	/// 
+	/// <param name="Input">Pointer to the source bytes</param>
+	/// <param name="Output">Pointer to the 16 output words</param>
+	static void BytesToLeULL1024(const byte* Input, ulong* Output);
+
 	//~~~Miscellaneous and Constant Time~~~//
 
 	/// <summary>
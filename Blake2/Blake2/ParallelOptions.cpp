@@ -15,6 +15,7 @@ ParallelOptions::ParallelOptions(size_t BlockSize, bool SimdMultiply, size_t Res
 	m_hasSHA2(false),
 	m_hasSimd128(false),
 	m_hasSimd256(false),
+	m_hasSimd512(false),
 	m_isParallel(false),
 	m_l1DataCacheReserved(ReservedCache),
 	m_l1DataCacheTotal(0),
@@ -45,6 +46,7 @@ ParallelOptions::ParallelOptions(size_t BlockSize, bool Parallel, size_t Paralle
 	m_hasSHA2(false),
 	m_hasSimd128(false),
 	m_hasSimd256(false),
+	m_hasSimd512(false),
 	m_isParallel(Parallel),
 	m_l1DataCacheReserved(ReservedCache),
 	m_l1DataCacheTotal(0),
@@ -142,13 +144,16 @@ void ParallelOptions::SetMaxDegree(size_t MaxDegree)
 
 void ParallelOptions::Detect()
 {
-	Common::CpuDetect detect;
+	// detected once per process; every digest constructs a profile, and cpuid is slow, and traps under a hypervisor
+	static Common::CpuDetect detect;
 
 	m_hasSHA2 = detect.SHA();
 	m_hasSimd128 = detect.AVX();
 	m_hasSimd256 = detect.AVX2();
+	// the opmask and zmm state must also be saved by the os; the same test that selects the AVX512 kernels
+	m_hasSimd512 = detect.Avx512Usable();
 	m_physicalCores = detect.PhysicalCores();
-	m_simdDetected = (m_hasSimd256) ? SimdProfiles::Simd256 : (m_hasSimd128) ? SimdProfiles::Simd128 : SimdProfiles::None;
+	m_simdDetected = (m_hasSimd512) ? SimdProfiles::Simd512 : (m_hasSimd256) ? SimdProfiles::Simd256 : (m_hasSimd128) ? SimdProfiles::Simd128 : SimdProfiles::None;
 	m_virtualCores = detect.VirtualCores();
 	m_processorCount = (m_virtualCores > m_physicalCores) ? m_virtualCores : m_physicalCores;
 
@@ -168,6 +173,7 @@ void ParallelOptions::Reset()
 	m_hasSHA2 = false;
 	m_hasSimd128 = false;
 	m_hasSimd256 = false;
+	m_hasSimd512 = false;
 	m_l1DataCacheReserved = 0;
 	m_l1DataCacheTotal = 0;
 	m_isParallel = false;
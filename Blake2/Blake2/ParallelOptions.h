@@ -37,9 +37,9 @@ private:
 	};
 
 	// 16kb min
-	const size_t DEF_DATACACHE = 16384;
+	static const size_t DEF_DATACACHE = 16384;
 	// 32mb, not enforced
-	const size_t MAX_PRLALLOC = DEF_DATACACHE * 2000;
+	static const size_t MAX_PRLALLOC = DEF_DATACACHE * 2000;
 
 	bool m_autoInit;
 	size_t m_blockSize;
@@ -47,6 +47,7 @@ private:
 	bool m_hasSHA2;
 	bool m_hasSimd128;
 	bool m_hasSimd256;
+	bool m_hasSimd512;
 	bool m_isParallel;
 	size_t m_l1DataCacheReserved;
 	size_t m_l1DataCacheTotal;
@@ -96,6 +97,11 @@ public:
 	/// </summary>
 	const bool HasSimd256() { return m_hasSimd256; }
 
+	/// <summary>
+	/// Get: Returns True if the system supports 512bit AVX512 (F and VL) intrinsics
+	/// </summary>
+	const bool HasSimd512() { return m_hasSimd512; }
+
 	/// <summary>
 	/// Get: The total size in bytes of the L1 Data cache available on the system
 	/// </summary>
@@ -1,10 +1,11 @@
 #include "ParallelUtils.h"
+#include "TaskScheduler.h"
+#include "ThreadPool.h"
 #include <functional>
+#include <thread>
 
 #if defined(_OPENMP)
 #	include <omp.h>
-#else
-#	include <future>
 #endif
 
 NAMESPACE_UTILITY
@@ -20,29 +21,13 @@ size_t ParallelUtils::ProcessorCount()
 
 void ParallelUtils::ParallelFor(size_t From, size_t To, const std::function<void(size_t)> &F)
 {
-#if defined(_OPENMP)
-#pragma omp parallel num_threads((int)To)
-	{
-		size_t i = (size_t)omp_get_thread_num();
-		F(i);
-	}
-#else
-	std::vector<std::future<void>> futures;
+	TaskScheduler* sched = TaskScheduler::Current();
 
-	for (size_t i = From; i < To; ++i)
-	{
-		auto fut = std::async([i, F]()
-		{
-			F(i);
-		});
-		futures.push_back(std::move(fut));
-	}
-
-	for (size_t i = 0; i < futures.size(); ++i)
-		futures[i].wait();
-
-	futures.clear();
-#endif
+	// inside a scheduler task the loop joins the work-stealing deques, otherwise it runs on the persistent workers
+	if (sched != nullptr)
+		sched->ParallelFor(From, To, F);
+	else
+		ThreadPool::Instance().Run(From, To, F);
 }
 
 NAMESPACE_UTILITYEND
\ No newline at end of file
@@ -20,6 +20,8 @@ public:
 
 	/// <summary>
 	/// A Parallel For loop
+	/// <para>The loop runs on the persistent ThreadPool workers and the calling thread; no threads are created per call.
+	/// Called from a TaskScheduler task, the loop is split into tasks on that scheduler.</para>
 	/// </summary>
 	/// 
 	/// <param name="From">The inclusive starting position</param> 
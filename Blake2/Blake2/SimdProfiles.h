@@ -21,7 +21,11 @@ enum class SimdProfiles : byte
 	/// <summary>
 	/// The system supports AVX2 intrinsics
 	/// </summary>
-	Simd256 = 2
+	Simd256 = 2,
+	/// <summary>
+	/// The system supports AVX512 intrinsics
+	/// </summary>
+	Simd512 = 3
 };
 
 NAMESPACE_ENUMERATIONEND
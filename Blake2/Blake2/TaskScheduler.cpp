@@ -0,0 +1,220 @@
+#include "TaskScheduler.h"
+#include "ParallelUtils.h"
+#include "ThreadPool.h"
+
+NAMESPACE_UTILITY
+
+// the scheduler and deque index of the task running on this thread
+static thread_local TaskScheduler* s_currentScheduler = nullptr;
+static thread_local size_t s_currentQueue = 0;
+
+//~~~Constructor~~~//
+
+TaskScheduler::TaskScheduler(size_t ThreadCount)
+	:
+	m_error(),
+	m_errorSync(),
+	m_idleSignal(),
+	m_idleSync(),
+	m_nextQueue(0),
+	m_pendingCount(0),
+	m_signalCount(0),
+	m_workQueues()
+{
+	if (ThreadCount == 0)
+		ThreadCount = ThreadPool::Instance().WorkerCount() + 1;
+
+	for (size_t i = 0; i < ThreadCount; ++i)
+		m_workQueues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+}
+
+//~~~Public Functions~~~//
+
+TaskScheduler* TaskScheduler::Current()
+{
+	return s_currentScheduler;
+}
+
+void TaskScheduler::ParallelFor(size_t From, size_t To, const std::function<void(size_t)> &F)
+{
+	if (To <= From)
+		return;
+
+	std::atomic<size_t> remaining(To - From);
+	std::exception_ptr error;
+	std::mutex errorSync;
+
+	const std::function<void(size_t)> RUNIDX = [&F, &remaining, &error, &errorSync](size_t i)
+	{
+		try
+		{
+			F(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(errorSync);
+			if (!error)
+				error = std::current_exception();
+		}
+
+		remaining.fetch_sub(1);
+	};
+
+	// queue all but the first index, newest on the bottom; idle threads steal the oldest from the top
+	for (size_t i = To - 1; i > From; --i)
+		Submit([&RUNIDX, i]() { RUNIDX(i); });
+
+	RUNIDX(From);
+
+	// help with queued work while the stolen indices complete
+	std::function<void()> task;
+	while (remaining.load() != 0)
+	{
+		// the count is read before the deques; an index completed after the search changes it, and the wait returns at once
+		const size_t SIGCNT = m_signalCount.load();
+
+		if (TakeTask(s_currentQueue, task))
+			Execute(task);
+		else if (remaining.load() != 0)
+			WaitSignal(SIGCNT);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void TaskScheduler::Run()
+{
+	m_error = nullptr;
+
+	// each loop index is a scheduler thread; they return together when the last task completes
+	ParallelUtils::ParallelFor(0, m_workQueues.size(), [this](size_t i)
+	{
+		WorkerLoop(i);
+	});
+
+	if (m_error)
+	{
+		std::exception_ptr error = m_error;
+		m_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void TaskScheduler::Submit(const std::function<void()> &Task)
+{
+	// the task is pending from the moment it is queued
+	m_pendingCount.fetch_add(1);
+
+	const size_t IDX = (s_currentScheduler == this) ? s_currentQueue : m_nextQueue.fetch_add(1) % m_workQueues.size();
+	WorkQueue &queue = *m_workQueues[IDX];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.Sync);
+		queue.Tasks.push_back(Task);
+	}
+
+	Signal();
+}
+
+//~~~Private Functions~~~//
+
+void TaskScheduler::Execute(std::function<void()> &Task)
+{
+	try
+	{
+		Task();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(m_errorSync);
+		if (!m_error)
+			m_error = std::current_exception();
+	}
+
+	Task = nullptr;
+	m_pendingCount.fetch_sub(1);
+
+	// wakes the threads waiting on a loop that this task completed, and every thread when it was the last task
+	Signal();
+}
+
+void TaskScheduler::Signal()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_idleSync);
+		m_signalCount.fetch_add(1);
+	}
+
+	m_idleSignal.notify_all();
+}
+
+bool TaskScheduler::TakeTask(size_t Index, std::function<void()> &Task)
+{
+	// own deque first, newest task
+	{
+		WorkQueue &queue = *m_workQueues[Index];
+		std::lock_guard<std::mutex> lock(queue.Sync);
+
+		if (!queue.Tasks.empty())
+		{
+			Task = std::move(queue.Tasks.back());
+			queue.Tasks.pop_back();
+
+			return true;
+		}
+	}
+
+	// steal the oldest task from the next non-empty deque
+	for (size_t i = 1; i < m_workQueues.size(); ++i)
+	{
+		WorkQueue &queue = *m_workQueues[(Index + i) % m_workQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.Sync);
+
+		if (!queue.Tasks.empty())
+		{
+			Task = std::move(queue.Tasks.front());
+			queue.Tasks.pop_front();
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TaskScheduler::WaitSignal(size_t SignalCount)
+{
+	std::unique_lock<std::mutex> lock(m_idleSync);
+	m_idleSignal.wait(lock, [this, SignalCount]() { return m_signalCount.load() != SignalCount; });
+}
+
+void TaskScheduler::WorkerLoop(size_t Index)
+{
+	TaskScheduler* prvSched = s_currentScheduler;
+	size_t prvQueue = s_currentQueue;
+	std::function<void()> task;
+
+	s_currentScheduler = this;
+	s_currentQueue = Index;
+
+	while (m_pendingCount.load() != 0)
+	{
+		// the count is read before the deques; a task submitted or completed after the search changes it, and the wait returns at once
+		const size_t SIGCNT = m_signalCount.load();
+
+		if (TakeTask(Index, task))
+			Execute(task);
+		else if (m_pendingCount.load() != 0)
+			WaitSignal(SIGCNT);
+	}
+
+	s_currentScheduler = prvSched;
+	s_currentQueue = prvQueue;
+}
+
+NAMESPACE_UTILITYEND
@@ -0,0 +1,137 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _CEX_TASKSCHEDULER_H
+#define _CEX_TASKSCHEDULER_H
+
+#include "CexDomain.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+NAMESPACE_UTILITY
+
+/// <summary>
+/// A work-stealing task scheduler for running many independent jobs across all processors.
+/// <para>Each scheduler thread owns a deque of tasks; a thread takes work from the bottom of its own deque, and when that is empty,
+/// steals from the top of another thread's deque, so threads that finish short jobs take over the queued work of threads with long ones.
+/// The scheduler threads are the loop indices of a ParallelUtils::ParallelFor, and run on the persistent ThreadPool workers.</para>
+/// </summary>
+///
+/// <example>
+/// <description>Hashing a set of messages of varying length:</description>
+/// <code>
+/// TaskScheduler sched;
+/// for (size_t i = 0; i &lt; msgs.size(); ++i)
+///     sched.Submit([&amp;msgs, &amp;hashes, i]() { Blake512 dgt(msgs[i].size() &gt; 1024 * 1024); dgt.Compute(msgs[i], hashes[i]); });
+/// sched.Run();
+/// </code>
+/// </example>
+///
+/// <remarks>
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>A task submitted from a running task is pushed to the bottom of the submitting thread's deque; tasks submitted before Run are dealt round-robin.</description></item>
+/// <item><description>ParallelUtils::ParallelFor called from a running task, e.g. the leaves of a parallel Blake2 digest, is split into tasks on the same deques; the calling task helps execute queued work until its loop completes.</description></item>
+/// <item><description>Run returns when every task, including the tasks they submit, has completed; the first exception thrown by a task is then rethrown.</description></item>
+/// <item><description>A thread that finds no work sleeps on a condition variable, and is woken when a task is submitted or completes.</description></item>
+/// </list>
+/// </remarks>
+class TaskScheduler
+{
+private:
+
+	struct WorkQueue
+	{
+		std::mutex Sync;
+		std::deque<std::function<void()>> Tasks;
+	};
+
+	std::exception_ptr m_error;
+	std::mutex m_errorSync;
+	std::condition_variable m_idleSignal;
+	std::mutex m_idleSync;
+	std::atomic<size_t> m_nextQueue;
+	std::atomic<size_t> m_pendingCount;
+	std::atomic<size_t> m_signalCount;
+	std::vector<std::unique_ptr<WorkQueue>> m_workQueues;
+
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+public:
+
+	/// <summary>
+	/// Get: The scheduler running a task on the calling thread, or null if the thread is not running a task
+	/// </summary>
+	static TaskScheduler* Current();
+
+	/// <summary>
+	/// Get: The number of scheduler threads
+	/// </summary>
+	size_t ThreadCount() const { return m_workQueues.size(); }
+
+	/// <summary>
+	/// Initialize the scheduler
+	/// </summary>
+	///
+	/// <param name="ThreadCount">The number of scheduler threads; the default of zero uses the ThreadPool workers and the calling thread</param>
+	explicit TaskScheduler(size_t ThreadCount = 0);
+
+	/// <summary>
+	/// Destructor
+	/// </summary>
+	~TaskScheduler();
+
+	/// <summary>
+	/// Split a loop into tasks on this scheduler, and help execute queued tasks until every index has completed.
+	/// <para>Called by ParallelUtils::ParallelFor when the calling thread is running one of this scheduler's tasks.</para>
+	/// </summary>
+	///
+	/// <param name="From">The inclusive starting position</param>
+	/// <param name="To">The exclusive ending position</param>
+	/// <param name="F">The function delegate</param>
+	void ParallelFor(size_t From, size_t To, const std::function<void(size_t)> &F);
+
+	/// <summary>
+	/// Execute the queued tasks, and the tasks they submit, on the scheduler threads; returns when all have completed
+	/// </summary>
+	void Run();
+
+	/// <summary>
+	/// Queue a task
+	/// </summary>
+	///
+	/// <param name="Task">The task delegate</param>
+	void Submit(const std::function<void()> &Task);
+
+private:
+
+	void Execute(std::function<void()> &Task);
+	void Signal();
+	bool TakeTask(size_t Index, std::function<void()> &Task);
+	void WaitSignal(size_t SignalCount);
+	void WorkerLoop(size_t Index);
+};
+
+NAMESPACE_UTILITYEND
+#endif
@@ -0,0 +1,191 @@
+#include "ThreadPool.h"
+#include "ParallelUtils.h"
+
+#if defined(CEX_OS_WINDOWS)
+#	include <Windows.h>
+#elif defined(CEX_OS_LINUX)
+#	include <pthread.h>
+#	include <sched.h>
+#endif
+
+NAMESPACE_UTILITY
+
+thread_local bool ThreadPool::m_isWorker = false;
+
+//~~~Constructor~~~//
+
+ThreadPool::ThreadPool(size_t WorkerCount)
+	:
+	m_activeCount(0),
+	m_doneSignal(),
+	m_generation(0),
+	m_job(nullptr),
+	m_poolMutex(),
+	m_stopWorkers(false),
+	m_submitMutex(),
+	m_wakeSignal(),
+	m_workers()
+{
+	for (size_t i = 0; i < WorkerCount; ++i)
+	{
+		m_workers.push_back(std::thread([this]() { WorkerLoop(); }));
+		// processor 0 is left to the calling thread
+		PinThread(m_workers.back(), i + 1);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		m_stopWorkers = true;
+		m_generation.fetch_add(1);
+	}
+
+	m_wakeSignal.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		if (m_workers[i].joinable())
+			m_workers[i].join();
+	}
+}
+
+//~~~Public Functions~~~//
+
+ThreadPool &ThreadPool::Instance()
+{
+	// initialized once, thread safe
+	static ThreadPool POOL(ParallelUtils::ProcessorCount() > 1 ? ParallelUtils::ProcessorCount() - 1 : 0);
+
+	return POOL;
+}
+
+void ThreadPool::Run(size_t From, size_t To, const std::function<void(size_t)> &F)
+{
+	if (To <= From)
+		return;
+
+	std::unique_lock<std::mutex> submit(m_submitMutex, std::try_to_lock);
+
+	// nested, concurrent, single index, or no workers; run on this thread
+	if (m_isWorker || !submit.owns_lock() || m_workers.size() == 0 || To - From == 1)
+	{
+		for (size_t i = From; i < To; ++i)
+			F(i);
+
+		return;
+	}
+
+	Job work(F, From, To);
+
+	{
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		m_job = &work;
+		m_generation.fetch_add(1);
+	}
+
+	m_wakeSignal.notify_all();
+	// the caller takes indices alongside the workers
+	Execute(work);
+
+	// every index is claimed; close the job to late workers and wait for the running tasks
+	{
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		m_job = nullptr;
+	}
+
+	for (size_t i = 0; i < SPIN_COUNT && m_activeCount.load() != 0; ++i)
+		std::this_thread::yield();
+
+	if (m_activeCount.load() != 0)
+	{
+		std::unique_lock<std::mutex> lock(m_poolMutex);
+		m_doneSignal.wait(lock, [this]() { return m_activeCount.load() == 0; });
+	}
+
+	if (work.Error)
+		std::rethrow_exception(work.Error);
+}
+
+//~~~Private Functions~~~//
+
+void ThreadPool::Execute(Job &Work)
+{
+	size_t idx;
+
+	while ((idx = Work.Next.fetch_add(1)) < Work.To)
+	{
+		try
+		{
+			(*Work.Function)(idx);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(Work.Sync);
+			if (!Work.Error)
+				Work.Error = std::current_exception();
+		}
+	}
+}
+
+void ThreadPool::PinThread(std::thread &Worker, size_t Processor)
+{
+	// pinning is advisory; a failure leaves the thread to the scheduler
+#if defined(CEX_OS_WINDOWS)
+	if (Processor < sizeof(DWORD_PTR) * 8)
+		SetThreadAffinityMask(Worker.native_handle(), static_cast<DWORD_PTR>(1) << Processor);
+#elif defined(CEX_OS_LINUX)
+	if (Processor < CPU_SETSIZE)
+	{
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(Processor, &cpuSet);
+		pthread_setaffinity_np(Worker.native_handle(), sizeof(cpu_set_t), &cpuSet);
+	}
+#else
+	(void)Worker;
+	(void)Processor;
+#endif
+}
+
+void ThreadPool::WorkerLoop()
+{
+	size_t seen = 0;
+	m_isWorker = true;
+
+	while (true)
+	{
+		// spin on the generation counter before sleeping, new loops usually arrive back to back
+		for (size_t i = 0; i < SPIN_COUNT && m_generation.load() == seen; ++i)
+			std::this_thread::yield();
+
+		Job* work = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(m_poolMutex);
+			m_wakeSignal.wait(lock, [this, seen]() { return m_generation.load() != seen; });
+			seen = m_generation.load();
+
+			if (m_stopWorkers)
+				return;
+
+			if (m_job != nullptr)
+			{
+				work = m_job;
+				m_activeCount.fetch_add(1);
+			}
+		}
+
+		if (work != nullptr)
+		{
+			Execute(*work);
+
+			std::lock_guard<std::mutex> lock(m_poolMutex);
+			if (m_activeCount.fetch_sub(1) == 1)
+				m_doneSignal.notify_all();
+		}
+	}
+}
+
+NAMESPACE_UTILITYEND
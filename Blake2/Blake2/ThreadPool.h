@@ -0,0 +1,125 @@
+// The GPL version 3 License (GPLv3)
+//
+// Copyright (c) 2017 vtdev.com
+// This file is part of the CEX Cryptographic library.
+//
+// This program is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _CEX_THREADPOOL_H
+#define _CEX_THREADPOOL_H
+
+#include "CexDomain.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+NAMESPACE_UTILITY
+
+/// <summary>
+/// A persistent pool of worker threads used by ParallelUtils::ParallelFor.
+/// <para>The workers are created once, on first use, one per processor less the calling thread, and each is pinned to its own processor.
+/// A loop is published to the workers and the calling thread, which claim indices from a shared counter until the range is exhausted.
+/// Idle workers and the waiting caller spin briefly before sleeping, so back to back loops are dispatched without a kernel transition.</para>
+/// </summary>
+///
+/// <remarks>
+/// <description>Implementation Notes:</description>
+/// <list type="bullet">
+/// <item><description>One loop runs on the pool at a time; a loop started from inside a task, or while another thread owns the pool, runs on the calling thread.</description></item>
+/// <item><description>Every index is executed exactly once; the first exception thrown by a task is rethrown to the caller after the loop completes.</description></item>
+/// <item><description>On a single processor system there are no workers, and loops run on the calling thread.</description></item>
+/// </list>
+/// </remarks>
+class ThreadPool
+{
+private:
+
+	// iterations of the spin wait before a thread blocks on its condition
+	static const size_t SPIN_COUNT = 2000;
+
+	struct Job
+	{
+		std::exception_ptr Error;
+		const std::function<void(size_t)>* Function;
+		std::atomic<size_t> Next;
+		std::mutex Sync;
+		size_t To;
+
+		Job(const std::function<void(size_t)> &F, size_t From, size_t To)
+			:
+			Error(),
+			Function(&F),
+			Next(From),
+			Sync(),
+			To(To)
+		{
+		}
+	};
+
+	std::atomic<size_t> m_activeCount;
+	std::condition_variable m_doneSignal;
+	std::atomic<size_t> m_generation;
+	Job* m_job;
+	std::mutex m_poolMutex;
+	bool m_stopWorkers;
+	std::mutex m_submitMutex;
+	std::condition_variable m_wakeSignal;
+	std::vector<std::thread> m_workers;
+	// set on the pool threads; a loop started from a task runs on that task's thread
+	static thread_local bool m_isWorker;
+
+	explicit ThreadPool(size_t WorkerCount);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+public:
+
+	/// <summary>
+	/// Get: The process-wide pool; the worker threads are started on the first call
+	/// </summary>
+	static ThreadPool &Instance();
+
+	/// <summary>
+	/// Get: The number of worker threads, not counting the calling thread
+	/// </summary>
+	size_t WorkerCount() const { return m_workers.size(); }
+
+	/// <summary>
+	/// Destructor; stops and joins the worker threads
+	/// </summary>
+	~ThreadPool();
+
+	/// <summary>
+	/// Execute a function once for every index in a range, on the worker threads and the calling thread.
+	/// <para>Returns when every call has completed.</para>
+	/// </summary>
+	///
+	/// <param name="From">The inclusive starting position</param>
+	/// <param name="To">The exclusive ending position</param>
+	/// <param name="F">The function delegate</param>
+	void Run(size_t From, size_t To, const std::function<void(size_t)> &F);
+
+private:
+
+	static void Execute(Job &Work);
+	static void PinThread(std::thread &Worker, size_t Processor);
+	void WorkerLoop();
+};
+
+NAMESPACE_UTILITYEND
+#endif
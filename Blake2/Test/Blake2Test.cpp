@@ -1,18 +1,137 @@
 #include "Blake2Test.h"
 #include "HexConverter.h"
 #include "../Blake2/CSP.h"
+#include "../Blake2/DigestFromName.h"
+#include "../Blake2/FileBatch.h"
+#include "../Blake2/FileDigest.h"
 #include "../Blake2/Blake256.h"
 #include "../Blake2/Blake512.h"
+#include "../Blake2/BlakeKdf.h"
+#include "../Blake2/BlakeTree.h"
+#include "../Blake2/BlakeXof.h"
+#include "../Blake2/HMAC.h"
+#include "../Blake2/ParallelUtils.h"
 #include "../Blake2/SymmetricKey.h"
+#include "../Blake2/TaskScheduler.h"
 #include "TestFiles.h"
+#include <cstdlib>
 #include <fstream>
+#include <new>
 #include <string>
 
+#if defined(CEX_OS_WINDOWS)
+#	include <malloc.h>
+#elif defined(CEX_HAS_POSIXIO)
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+// counts the heap allocations made by the calling thread; used by AllocationTest
+static thread_local size_t s_allocCount = 0;
+
+void* operator new(size_t Size)
+{
+	++s_allocCount;
+	void* ptr = malloc(Size != 0 ? Size : 1);
+
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void* operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void operator delete(void* Ptr) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete[](void* Ptr) noexcept
+{
+	free(Ptr);
+}
+
+// the sized forms are called in place of the unsized forms where the compiler knows the size; they release the same heap
+void operator delete(void* Ptr, size_t) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete[](void* Ptr, size_t) noexcept
+{
+	free(Ptr);
+}
+
+#if defined(__cpp_aligned_new)
+// over-aligned types are allocated through the aligned forms; these are replaced together, so that each block returns to its own heap
+void* operator new(size_t Size, std::align_val_t Align)
+{
+	++s_allocCount;
+#	if defined(CEX_OS_WINDOWS)
+	void* ptr = _aligned_malloc(Size != 0 ? Size : 1, static_cast<size_t>(Align));
+#	else
+	void* ptr = nullptr;
+
+	if (posix_memalign(&ptr, static_cast<size_t>(Align) < sizeof(void*) ? sizeof(void*) : static_cast<size_t>(Align), Size != 0 ? Size : 1) != 0)
+		ptr = nullptr;
+#	endif
+
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void* operator new[](size_t Size, std::align_val_t Align)
+{
+	return operator new(Size, Align);
+}
+
+void operator delete(void* Ptr, std::align_val_t) noexcept
+{
+#	if defined(CEX_OS_WINDOWS)
+	_aligned_free(Ptr);
+#	else
+	free(Ptr);
+#	endif
+}
+
+void operator delete[](void* Ptr, std::align_val_t Align) noexcept
+{
+	operator delete(Ptr, Align);
+}
+
+void operator delete(void* Ptr, size_t, std::align_val_t Align) noexcept
+{
+	operator delete(Ptr, Align);
+}
+
+void operator delete[](void* Ptr, size_t, std::align_val_t Align) noexcept
+{
+	operator delete(Ptr, Align);
+}
+#endif
+
 namespace Test
 {
 	using Digest::BlakeParams;
 	using Digest::Blake256;
 	using Digest::Blake512;
+	using Digest::BlakeTree;
+	using Digest::BlakeTreeRange;
+	using Digest::BlakeXof;
+	using Digest::IDigest;
+	using Enumeration::Digests;
+	using IO::FileBatch;
+	using IO::FileDigest;
+	using Kdf::BlakeKdf;
+	using Mac::HMAC;
+	using Utility::ParallelUtils;
+	using Utility::TaskScheduler;
 	using namespace TestFiles::Blake2Kat;
 
 	const std::string Blake2Test::DESCRIPTION = "Blake Vector KATs; tests Blake2 256/512 digests.";
@@ -34,6 +153,177 @@ namespace Test
 	{
 	}
 
+	// the ways in which the state of a partly hashed message is carried into the rest of the message; used by StateCompare
+	enum class StateModes : int
+	{
+		// the message is hashed under a keyed template restored by LoadKeyedState; the messages are also hashed as one batch
+		Keyed = 0,
+		// the state is copied by Clone at the first split, and the copy cloned again at the second
+		Clone = 1,
+		// the state is imported by a second digest at the first split, and imported back at the second
+		Import = 2,
+		// the state is written by Serialize at each split, and resumed by a digest of the other mode, then by one of the same mode
+		Serialize = 3
+	};
+
+	template <class Digest, class KeyedState>
+	static void StateCompare(StateModes Mode, bool Parallel, size_t KeySize)
+	{
+		// each random message is hashed whole by a new digest, and again in three parts with the state carried across both splits; the outputs must match
+		Provider::CSP rng;
+		std::vector<size_t> msgLen;
+
+		for (size_t i = 0; i < 300; i += (i < 140) ? 1 : 7)
+			msgLen.push_back(i);
+
+		msgLen.push_back(16 * 1024 + 3);
+		msgLen.push_back(200 * 1024 + 17);
+		msgLen.push_back(600 * 1024 + 37);
+
+		// a KeySize of zero hashes the messages unkeyed
+		std::vector<uint8_t> key(KeySize);
+		Key::Symmetric::SymmetricKey* mkey = 0;
+
+		if (KeySize != 0)
+		{
+			rng.GetBytes(key);
+			mkey = new Key::Symmetric::SymmetricKey(key);
+		}
+
+		Digest dgt(Parallel);
+		Digest fork(Parallel);
+		KeyedState kstate;
+		std::vector<std::vector<uint8_t>> expect;
+		std::vector<uint8_t> hash(dgt.DigestSize());
+		std::vector<std::vector<uint8_t>> messages;
+		std::vector<uint8_t> tmplCode(dgt.DigestSize());
+
+		if (Mode == StateModes::Keyed)
+		{
+			// the template does not change the digest; it still holds the key block
+			dgt.Initialize(*mkey);
+			dgt.GetKeyedState(kstate);
+			dgt.Finalize(tmplCode, 0);
+		}
+
+		for (size_t i = 0; i < msgLen.size(); ++i)
+		{
+			const size_t SPLIT1 = msgLen[i] / 3;
+			const size_t SPLIT2 = (2 * msgLen[i]) / 3;
+			messages.push_back(std::vector<uint8_t>(msgLen[i]));
+			std::vector<uint8_t> &input = messages.back();
+			if (input.size() != 0)
+				rng.GetBytes(input);
+
+			Digest whole(Parallel);
+			if (mkey != 0)
+				whole.Initialize(*mkey);
+
+			expect.push_back(std::vector<uint8_t>(whole.DigestSize()));
+			whole.Update(input, 0, input.size());
+			whole.Finalize(expect.back(), 0);
+
+			switch (Mode)
+			{
+				case StateModes::Keyed:
+				{
+					// the template is reused for every message
+					dgt.LoadKeyedState(kstate);
+					dgt.Update(input, 0, SPLIT1);
+					dgt.Update(input, SPLIT1, SPLIT2 - SPLIT1);
+					dgt.Update(input, SPLIT2, input.size() - SPLIT2);
+					dgt.Finalize(hash, 0);
+					break;
+				}
+				case StateModes::Clone:
+				{
+					dgt.Update(input, 0, SPLIT1);
+					Digest* cpy1 = dgt.Clone();
+					dgt.Reset();
+					cpy1->Update(input, SPLIT1, SPLIT2 - SPLIT1);
+					Digest* cpy2 = cpy1->Clone();
+					delete cpy1;
+					cpy2->Update(input, SPLIT2, input.size() - SPLIT2);
+					cpy2->Finalize(hash, 0);
+					delete cpy2;
+					break;
+				}
+				case StateModes::Import:
+				{
+					// the digests are reused without a Reset; Import replaces the whole state
+					dgt.Update(input, 0, SPLIT1);
+					fork.Import(dgt);
+					fork.Update(input, SPLIT1, SPLIT2 - SPLIT1);
+					dgt.Import(fork);
+					dgt.Update(input, SPLIT2, input.size() - SPLIT2);
+					dgt.Finalize(hash, 0);
+					break;
+				}
+				case StateModes::Serialize:
+				{
+					Digest res(!Parallel);
+					dgt.Update(input, 0, SPLIT1);
+					res.DeSerialize(dgt.Serialize());
+					res.Update(input, SPLIT1, SPLIT2 - SPLIT1);
+					dgt.DeSerialize(res.Serialize());
+					dgt.Update(input, SPLIT2, input.size() - SPLIT2);
+					dgt.Finalize(hash, 0);
+					break;
+				}
+			}
+
+			if (hash != expect.back())
+				throw TestException("StateCompare: Carried state output does not match the whole message!");
+		}
+
+		if (Mode == StateModes::Keyed)
+		{
+			if (tmplCode != expect[0])
+				throw TestException("KeyedStateTest: Empty message code does not match the keyed digest!");
+
+			// a batch under a loaded template matches each message hashed in turn; empty messages lead, follow and separate the others
+			std::vector<std::vector<uint8_t>> batchIn;
+			std::vector<std::vector<uint8_t>> batchOut;
+			std::vector<size_t> batchMsg;
+
+			for (size_t i = 1; i < messages.size(); i += 17)
+			{
+				batchIn.push_back(messages[0]);
+				batchMsg.push_back(0);
+				batchIn.push_back(messages[i]);
+				batchMsg.push_back(i);
+			}
+
+			batchIn.push_back(messages[0]);
+			batchMsg.push_back(0);
+			dgt.LoadKeyedState(kstate);
+			dgt.ComputeBatch(batchIn, batchOut);
+
+			for (size_t i = 0; i < batchIn.size(); ++i)
+			{
+				if (batchOut[i] != expect[batchMsg[i]])
+					throw TestException("KeyedStateTest: Keyed template batch code does not match the sequential code!");
+			}
+
+			// a template can only be taken from a keyed digest before message data is added
+			bool thrown = false;
+			dgt.Reset();
+			try
+			{
+				dgt.GetKeyedState(kstate);
+			}
+			catch (Exception::CryptoDigestException&)
+			{
+				thrown = true;
+			}
+
+			if (!thrown)
+				throw TestException("KeyedStateTest: An unkeyed digest returned a keyed template!");
+		}
+
+		delete mkey;
+	}
+
 	std::string Blake2Test::Run()
 	{
 		try
@@ -50,6 +340,40 @@ namespace Test
 			OnProgress(std::string("Passed Blake2-B 512 vector tests.."));
 			Blake2BPTest();
 			OnProgress(std::string("Passed Blake2-BP 512 vector tests.."));    
+			Blake2BBatchTest();
+			OnProgress(std::string("Passed Blake2-B 512 multi-buffer vector tests.."));
+			Blake2SBatchTest();
+			OnProgress(std::string("Passed Blake2-S 256 multi-buffer vector tests.."));
+			Blake2BPSimdTest();
+			OnProgress(std::string("Passed Blake2-BP 512 single-thread SIMD tests.."));
+			Blake2SPSimdTest();
+			OnProgress(std::string("Passed Blake2-SP 256 single-thread SIMD tests.."));
+			SchedulerTest();
+			OnProgress(std::string("Passed Blake2 work-stealing scheduler tests.."));
+			TreeHashTest();
+			OnProgress(std::string("Passed Blake2 tree hashing and joined range tests.."));
+			PointerUpdateTest();
+			OnProgress(std::string("Passed raw-pointer Update and Finalize tests.."));
+			AllocationTest();
+			OnProgress(std::string("Passed allocation-free Update and Finalize tests.."));
+			KeyedStateTest();
+			OnProgress(std::string("Passed keyed state template tests.."));
+			HMACTest();
+			OnProgress(std::string("Passed HMAC cached pad state tests.."));
+			CloneTest();
+			OnProgress(std::string("Passed Blake2 digest clone and import tests.."));
+			SerializeTest();
+			OnProgress(std::string("Passed Blake2 state serialization tests.."));
+			XofTest();
+			OnProgress(std::string("Passed Blake2X extendable output tests.."));
+			DigestSizeTest();
+			OnProgress(std::string("Passed Blake2 variable digest size tests.."));
+			KdfTest();
+			OnProgress(std::string("Passed Blake2 key derivation function tests.."));
+			FileDigestTest();
+			OnProgress(std::string("Passed mapped, buffered, pipelined, ranged and uncached file hashing tests.."));
+			FileBatchTest();
+			OnProgress(std::string("Passed multi-file batch hashing tests.."));
 
 			return SUCCESS;
 		}
@@ -63,6 +387,66 @@ namespace Test
 		}
 	}
 
+	void Blake2Test::AllocationTest()
+	{
+		// after construction and a first message, an Update and Finalize cycle must not touch the heap
+		const size_t MSGLEN = 4096 + 77;
+		std::vector<uint8_t> input(MSGLEN);
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = static_cast<uint8_t>(i);
+
+		std::vector<IDigest*> dgts;
+		dgts.push_back(new Blake512(false));
+		dgts.push_back(new Blake256(false));
+		dgts.push_back(new Blake512(true));
+		dgts.push_back(new Blake256(true));
+		dynamic_cast<Blake512*>(dgts[2])->ParallelSimd(true);
+		dynamic_cast<Blake256*>(dgts[3])->ParallelSimd(true);
+
+		for (size_t i = 0; i < dgts.size(); ++i)
+		{
+			std::vector<uint8_t> hash(dgts[i]->DigestSize());
+			dgts[i]->Update(input, 0, input.size());
+			dgts[i]->Finalize(hash, 0);
+
+			const size_t ALLOCS = s_allocCount;
+
+			for (size_t j = 0; j < 8; ++j)
+			{
+				dgts[i]->Update(input[j]);
+				dgts[i]->Update(input, j, MSGLEN - (j * 500) - j);
+				dgts[i]->Update(&input[0], j * 13);
+				dgts[i]->Finalize(hash, 0);
+			}
+
+			if (s_allocCount != ALLOCS)
+				throw TestException("AllocationTest: " + dgts[i]->Name() + " allocated in an Update and Finalize cycle!");
+
+			delete dgts[i];
+		}
+
+		std::vector<uint8_t> key(64, 0x0B);
+		Key::Symmetric::SymmetricKey mkey(key);
+		HMAC mac(Digests::Blake512, false);
+		std::vector<uint8_t> code(mac.MacSize());
+
+		mac.Initialize(mkey);
+		mac.Update(input, 0, input.size());
+		mac.Finalize(code, 0);
+
+		const size_t ALLOCS = s_allocCount;
+
+		for (size_t j = 0; j < 8; ++j)
+		{
+			mac.Update(input[j]);
+			mac.Update(input, j, MSGLEN - (j * 500) - j);
+			mac.Finalize(code, 0);
+		}
+
+		if (s_allocCount != ALLOCS)
+			throw TestException("AllocationTest: HMAC allocated in an Update and Finalize cycle!");
+	}
+
 	void Blake2Test::Blake2BTest()
 	{
 		std::ifstream stream(BLAKE2BKAT);
@@ -109,6 +493,70 @@ namespace Test
 		stream.close();
 	}
 
+	void Blake2Test::Blake2BBatchTest()
+	{
+		std::ifstream stream(BLAKE2BKAT);
+		if (!stream)
+			throw TestException("Could not open file: " + BLAKE2BKAT);
+
+		std::vector<std::vector<uint8_t>> input;
+		std::vector<std::vector<uint8_t>> expect;
+		std::vector<std::vector<uint8_t>> hash;
+		std::vector<uint8_t> key;
+		std::string line;
+
+		while (std::getline(stream, line))
+		{
+			if (line.size() != 0)
+			{
+				if (line.find(DMK_INP) != std::string::npos)
+				{
+					std::vector<uint8_t> msg(0);
+					std::vector<uint8_t> exp(64);
+
+					size_t sze = DMK_INP.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), msg);
+
+					std::getline(stream, line);
+					sze = DMK_KEY.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), key);
+
+					std::getline(stream, line);
+					sze = DMK_HSH.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), exp);
+
+					input.push_back(msg);
+					expect.push_back(exp);
+				}
+			}
+		}
+		stream.close();
+
+		// the kat messages share one key and have ragged lengths of 0 to 255 bytes
+		Key::Symmetric::SymmetricKey mkey(key);
+		Blake512 blake2b(false);
+		blake2b.Initialize(mkey);
+		blake2b.ComputeBatch(input, hash);
+
+		if (hash != expect)
+			throw TestException("Blake2BBatchTest: KAT test has failed!");
+
+		// the digest is reset after a batch; compare the unkeyed batch with sequential hashing
+		std::vector<uint8_t> code(64);
+		blake2b.ComputeBatch(input, hash);
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			blake2b.Compute(input[i], code);
+
+			if (hash[i] != code)
+				throw TestException("Blake2BBatchTest: Batch output does not match sequential output!");
+		}
+	}
+
 	void Blake2Test::Blake2BPTest()
 	{
 		std::ifstream stream(BLAKE2BPKAT);
@@ -160,6 +608,97 @@ namespace Test
 		stream.close();
 	}
 
+	void Blake2Test::Blake2BPSimdTest()
+	{
+		std::ifstream stream(BLAKE2BPKAT);
+		if (!stream)
+			throw TestException("Could not open file: " + BLAKE2BPKAT);
+
+		std::string line;
+
+		while (std::getline(stream, line))
+		{
+			if (line.size() != 0)
+			{
+				if (line.find(DMK_INP) != std::string::npos)
+				{
+					std::vector<uint8_t> input(0);
+					std::vector<uint8_t> expect(64);
+					std::vector<uint8_t> key;
+					std::vector<uint8_t> hash(64);
+
+					size_t sze = DMK_INP.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), input);
+
+					std::getline(stream, line);
+					sze = DMK_KEY.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), key);
+
+					std::getline(stream, line);
+					sze = DMK_HSH.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), expect);
+
+					// the simd tree is available on any processor count; the leaves are hashed on this thread
+					Blake512 blake2bp(false);
+					Key::Symmetric::SymmetricKey mkey(key);
+					blake2bp.ParallelSimd(true);
+					blake2bp.Initialize(mkey);
+					blake2bp.Compute(input, hash);
+
+					if (hash != expect)
+						throw TestException("Blake2BPSimdTest: KAT test has failed!");
+				}
+			}
+		}
+		stream.close();
+
+		// compare with the threaded tree of the same shape, and with byte-wise updates through the message buffer;
+		// the fan-outs give a partial, a full, and several lane groups for the four and eight lane kernels
+		const size_t FNOUT[] = { 4, 6, 8, 12, 16 };
+		Provider::CSP rng;
+		std::vector<uint8_t> hash1(64);
+		std::vector<uint8_t> hash2(64);
+		std::vector<uint8_t> hash3(64);
+
+		for (size_t i = 0; i < sizeof(FNOUT) / sizeof(size_t); ++i)
+		{
+			BlakeParams params(64, 2, static_cast<uint8_t>(FNOUT[i]), 0, 64);
+			Blake512 blake2bp(params);
+			blake2bp.ParallelSimd(true);
+			blake2bp.ParallelMaxDegree(FNOUT[i]);
+			// the threaded tree needs more than one processor, on one processor the params build a sequential digest
+			Blake512 blake2bpt(params);
+			// the buffered path, the unbuffered leaf path with a remainder, and multiples of the parallel block size
+			const size_t MINSZE = FNOUT[i] * 128;
+			const size_t MSGLEN[] = { (2 * MINSZE) + 1, (3 * MINSZE) + 64, (9 * MINSZE) + 7, blake2bp.ParallelBlockSize(), (2 * blake2bp.ParallelBlockSize()) + 1031 };
+
+			for (size_t j = 0; j < sizeof(MSGLEN) / sizeof(size_t); ++j)
+			{
+				std::vector<uint8_t> input(MSGLEN[j]);
+				rng.GetBytes(input);
+				blake2bp.Compute(input, hash1);
+
+				if (blake2bpt.IsParallel())
+				{
+					blake2bpt.Compute(input, hash2);
+
+					if (hash1 != hash2)
+						throw TestException("Blake2BPSimdTest: SIMD output does not match threaded output!");
+				}
+
+				for (size_t k = 0; k < input.size(); ++k)
+					blake2bp.Update(input[k]);
+				blake2bp.Finalize(hash3, 0);
+
+				if (hash1 != hash3)
+					throw TestException("Blake2BPSimdTest: Leaf path output does not match buffered output!");
+			}
+		}
+	}
+
 	void Blake2Test::Blake2STest()
 	{
 		std::ifstream stream(BLAKE2SKAT);
@@ -204,6 +743,125 @@ namespace Test
 			}
 		}
 		stream.close();
+
+		// expected values from the Blake2s reference; keyed, with a salt and personalization, for 0, 64 and 255 byte messages
+		const std::vector<std::string> EXPECT =
+		{
+			"E287C0D6BD7D80B478213445F6606FAD8B70834CC1A334726EB27686F0B00834",
+			"65FC3FDCB1AC2C0734DDF04D15BD2CF5D0A0F1FF28BEE19EEFD3FCE2B7B6D501",
+			"8F998CFBA747175FF95CB6792157B05B4FFF54424D6201C7D2B5FBB35C8D860C"
+		};
+		const size_t MSGLEN[] = { 0, 64, 255 };
+		std::vector<uint8_t> expect;
+		std::vector<uint8_t> hash(32);
+		std::vector<uint8_t> info(8);
+		std::vector<uint8_t> key(32);
+		std::vector<uint8_t> salt(8);
+		Blake256 blake2s(false);
+
+		for (size_t i = 0; i < key.size(); ++i)
+			key[i] = static_cast<uint8_t>(i + 1);
+
+		for (size_t i = 0; i < salt.size(); ++i)
+		{
+			salt[i] = static_cast<uint8_t>(0xA0 + i);
+			info[i] = static_cast<uint8_t>(0xC0 + i);
+		}
+
+		Key::Symmetric::SymmetricKey mkey(key, salt, info);
+
+		for (size_t i = 0; i < EXPECT.size(); ++i)
+		{
+			std::vector<uint8_t> input(MSGLEN[i]);
+
+			for (size_t j = 0; j < input.size(); ++j)
+				input[j] = static_cast<uint8_t>(j);
+
+			HexConverter::Decode(EXPECT[i], expect);
+			blake2s.Initialize(mkey);
+			blake2s.Compute(input, hash);
+
+			if (hash != expect)
+				throw TestException("Blake2STest: Salted KAT test has failed!");
+		}
+
+		// keyed again without a salt or personalization; those of the previous key are cleared
+		std::vector<uint8_t> input(255);
+
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = static_cast<uint8_t>(i);
+
+		Key::Symmetric::SymmetricKey mkey2(key);
+		blake2s.Initialize(mkey2);
+		blake2s.Compute(input, hash);
+		HexConverter::Decode("1210FB99B33C3A15F999E477701456CA842F2F3078B7B63996BB5584E9244D0F", expect);
+
+		if (hash != expect)
+			throw TestException("Blake2STest: The salt and personalization of a previous key were kept!");
+	}
+
+	void Blake2Test::Blake2SBatchTest()
+	{
+		std::ifstream stream(BLAKE2SKAT);
+		if (!stream)
+			throw TestException("Could not open file: " + BLAKE2SKAT);
+
+		std::vector<std::vector<uint8_t>> input;
+		std::vector<std::vector<uint8_t>> expect;
+		std::vector<std::vector<uint8_t>> hash;
+		std::vector<uint8_t> key;
+		std::string line;
+
+		while (std::getline(stream, line))
+		{
+			if (line.size() != 0)
+			{
+				if (line.find(DMK_INP) != std::string::npos)
+				{
+					std::vector<uint8_t> msg(0);
+					std::vector<uint8_t> exp(32);
+
+					size_t sze = DMK_INP.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), msg);
+
+					std::getline(stream, line);
+					sze = DMK_KEY.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), key);
+
+					std::getline(stream, line);
+					sze = DMK_HSH.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), exp);
+
+					input.push_back(msg);
+					expect.push_back(exp);
+				}
+			}
+		}
+		stream.close();
+
+		// the kat messages share one key and have ragged lengths of 0 to 255 bytes
+		Key::Symmetric::SymmetricKey mkey(key);
+		Blake256 blake2s(false);
+		blake2s.Initialize(mkey);
+		blake2s.ComputeBatch(input, hash);
+
+		if (hash != expect)
+			throw TestException("Blake2SBatchTest: KAT test has failed!");
+
+		// the digest is reset after a batch; compare the unkeyed batch with sequential hashing
+		std::vector<uint8_t> code(32);
+		blake2s.ComputeBatch(input, hash);
+
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			blake2s.Compute(input[i], code);
+
+			if (hash[i] != code)
+				throw TestException("Blake2SBatchTest: Batch output does not match sequential output!");
+		}
 	}
 
 	void Blake2Test::Blake2SPTest()
@@ -254,11 +912,784 @@ namespace Test
 		stream.close();
 	}
 
-	void Blake2Test::MacParamsTest()
+	void Blake2Test::Blake2SPSimdTest()
 	{
-		std::vector<uint8_t> key(64);
-		for (uint8_t i = 0; i < key.size(); ++i)
-			key[i] = i;
+		std::ifstream stream(BLAKE2SPKAT);
+		if (!stream)
+			throw TestException("Could not open file: " + BLAKE2SPKAT);
+
+		std::string line;
+
+		while (std::getline(stream, line))
+		{
+			if (line.size() != 0)
+			{
+				if (line.find(DMK_INP) != std::string::npos)
+				{
+					std::vector<uint8_t> input(0);
+					std::vector<uint8_t> expect(32);
+					std::vector<uint8_t> key;
+					std::vector<uint8_t> hash(32);
+
+					size_t sze = DMK_INP.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), input);
+
+					std::getline(stream, line);
+					sze = DMK_KEY.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), key);
+
+					std::getline(stream, line);
+					sze = DMK_HSH.length();
+					if (line.length() - sze > 0)
+						HexConverter::Decode(line.substr(sze, line.length() - sze), expect);
+
+					// the simd tree is available on any processor count; the leaves are hashed on this thread
+					Blake256 blake2sp(false);
+					Key::Symmetric::SymmetricKey mkey(key);
+					blake2sp.ParallelSimd(true);
+					blake2sp.Initialize(mkey);
+					blake2sp.Compute(input, hash);
+
+					if (hash != expect)
+						throw TestException("Blake2SPSimdTest: KAT test has failed!");
+				}
+			}
+		}
+		stream.close();
+
+		// compare with the threaded tree of the same shape, and with byte-wise updates through the message buffer;
+		// the fan-outs give a partial, a full, and several lane groups for the eight lane kernel
+		const size_t FNOUT[] = { 4, 8, 12, 16 };
+		Provider::CSP rng;
+		std::vector<uint8_t> hash1(32);
+		std::vector<uint8_t> hash2(32);
+		std::vector<uint8_t> hash3(32);
+
+		for (size_t i = 0; i < sizeof(FNOUT) / sizeof(size_t); ++i)
+		{
+			BlakeParams params(32, 2, static_cast<uint8_t>(FNOUT[i]), 0, 32);
+			Blake256 blake2sp(params);
+			blake2sp.ParallelSimd(true);
+			blake2sp.ParallelMaxDegree(FNOUT[i]);
+			// the threaded tree needs more than one processor, on one processor the params build a sequential digest
+			Blake256 blake2spt(params);
+			// the buffered path, the unbuffered leaf path with a remainder, and multiples of the parallel block size
+			const size_t MINSZE = FNOUT[i] * 64;
+			const size_t MSGLEN[] = { (2 * MINSZE) + 1, (3 * MINSZE) + 32, (9 * MINSZE) + 7, blake2sp.ParallelBlockSize(), (2 * blake2sp.ParallelBlockSize()) + 1031 };
+
+			for (size_t j = 0; j < sizeof(MSGLEN) / sizeof(size_t); ++j)
+			{
+				std::vector<uint8_t> input(MSGLEN[j]);
+				rng.GetBytes(input);
+				blake2sp.Compute(input, hash1);
+
+				if (blake2spt.IsParallel())
+				{
+					blake2spt.Compute(input, hash2);
+
+					if (hash1 != hash2)
+						throw TestException("Blake2SPSimdTest: SIMD output does not match threaded output!");
+				}
+
+				for (size_t k = 0; k < input.size(); ++k)
+					blake2sp.Update(input[k]);
+				blake2sp.Finalize(hash3, 0);
+
+				if (hash1 != hash3)
+					throw TestException("Blake2SPSimdTest: Leaf path output does not match buffered output!");
+			}
+		}
+	}
+
+	void Blake2Test::CloneTest()
+	{
+		// each split message is completed by a clone, and by a reused digest importing the state; both must match the whole message
+		for (size_t i = 0; i < 2; ++i)
+		{
+			StateCompare<Blake512, Digest::Blake2bKeyedState>(StateModes::Clone, i != 0, 0);
+			StateCompare<Blake512, Digest::Blake2bKeyedState>(StateModes::Import, i != 0, 0);
+			StateCompare<Blake256, Digest::Blake2sKeyedState>(StateModes::Clone, i != 0, 0);
+			StateCompare<Blake256, Digest::Blake2sKeyedState>(StateModes::Import, i != 0, 0);
+		}
+
+		// a parallel prefix imported by a sequential digest takes the parallel configuration
+		std::vector<uint8_t> input(10000, 1);
+		std::vector<uint8_t> expect(64);
+		std::vector<uint8_t> hash(64);
+		Blake512 prl(true);
+		Blake512 seq(false);
+
+		prl.Update(input, 0, 5000);
+		seq.Import(prl);
+		prl.Update(input, 5000, 5000);
+		prl.Finalize(expect, 0);
+		seq.Update(input, 5000, 5000);
+		seq.Finalize(hash, 0);
+
+		if (hash != expect || !seq.IsParallel())
+			throw TestException("CloneTest: Imported parallel digest output does not match the source!");
+
+		// a keyed template state is carried by the copy
+		std::vector<uint8_t> key(64, 3);
+		Key::Symmetric::SymmetricKey mkey(key);
+		Digest::Blake2bKeyedState kstate;
+		Blake512 mac(false);
+		mac.Initialize(mkey);
+		mac.GetKeyedState(kstate);
+		mac.Finalize(expect, 0);
+		mac.LoadKeyedState(kstate);
+
+		Blake512* dgt = mac.Clone();
+		dgt->Finalize(hash, 0);
+		delete dgt;
+
+		if (hash != expect)
+			throw TestException("CloneTest: Cloned keyed template output does not match the source!");
+	}
+
+	void Blake2Test::DigestSizeTest()
+	{
+		// expected values from the reference implementations; the output size is part of the parameter block, a 1000 byte message
+		const std::vector<std::string> EXPECT =
+		{
+			"C636324D47D89F2B2434DC2C994100663FBBAEA880FF020FC5DE89DD0F77A1EC",
+			"978A3F8B45508A42FE7F0F99CAF2C423",
+			"0B94973A96DC199CFBC1EC1E06615C99",
+			"9489E7B7D8F63097F1A00B06D1F2B02D296C510B5CAC468D1EE57370619BE850",
+			"320A0AAB4778132014CCEE2CAEF23690"
+		};
+		// Blake2b-256, Blake2b-128, Blake2s-128, Blake2bp-256, Blake2sp-128
+		const std::vector<Digests> DGTTYPE = { Digests::Blake512, Digests::Blake512, Digests::Blake256, Digests::Blake512, Digests::Blake256 };
+		const std::vector<bool> PRLMODE = { false, false, false, true, true };
+		std::vector<uint8_t> expect;
+		std::vector<uint8_t> input(1000);
+		std::vector<uint8_t> output;
+
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = static_cast<uint8_t>(i);
+
+		for (size_t i = 0; i < EXPECT.size(); ++i)
+		{
+			HexConverter::Decode(EXPECT[i], expect);
+			IDigest* dgt = Helper::DigestFromName::GetSizedInstance(DGTTYPE[i], expect.size(), PRLMODE[i]);
+
+			if (dgt->DigestSize() != expect.size())
+				throw TestException("DigestSizeTest: The digest size is incorrect!");
+
+			// the output buffer is exactly the digest size; no bytes beyond it are written
+			output.resize(expect.size());
+			dgt->Compute(input, output);
+			delete dgt;
+
+			if (output != expect)
+				throw TestException("DigestSizeTest: Variable digest output does not match the expected value!");
+
+			if (!PRLMODE[i])
+			{
+				// the multi-buffer batch writes the same output size
+				std::vector<std::vector<uint8_t>> batchIn(3, input);
+				std::vector<std::vector<uint8_t>> batchOut;
+
+				if (DGTTYPE[i] == Digests::Blake512)
+				{
+					Blake512 dgt512(expect.size(), false);
+					dgt512.ComputeBatch(batchIn, batchOut);
+				}
+				else
+				{
+					Blake256 dgt256(expect.size(), false);
+					dgt256.ComputeBatch(batchIn, batchOut);
+				}
+
+				for (size_t j = 0; j < batchOut.size(); ++j)
+				{
+					if (batchOut[j] != expect)
+						throw TestException("DigestSizeTest: Variable digest batch output does not match the expected value!");
+				}
+			}
+		}
+
+		// the parameter block for a shortened Blake2b output keeps the Blake2b layout
+		BlakeParams params(32);
+		Blake512 dgt(params);
+		output.resize(dgt.DigestSize());
+		dgt.Compute(input, output);
+		HexConverter::Decode(EXPECT[0], expect);
+
+		if (output != expect)
+			throw TestException("DigestSizeTest: BlakeParams output size does not match the expected value!");
+
+		// the whole Blake2b distribution code is kept for a 32 byte output; a salt at bytes 8 to 23, and a personalization at 24 to 39
+		std::vector<uint8_t> code(40, 0);
+
+		for (size_t i = 0; i < 16; ++i)
+		{
+			code[8 + i] = static_cast<uint8_t>(0xA0 + i);
+			code[24 + i] = static_cast<uint8_t>(0xC0 + i);
+		}
+
+		BlakeParams params2(32, 0, 1, 1, 0, 0, 0, 0, code);
+		Blake512 dgt2(params2);
+		dgt2.Compute(input, output);
+		HexConverter::Decode("968B257F3AE1B2C52C57596A9B93609DF89C6AD09F282DC7033A6F7A125058CE", expect);
+
+		if (output != expect)
+			throw TestException("DigestSizeTest: The distribution code of a shortened Blake2b output was truncated!");
+
+		// an invalid size is rejected
+		bool thrown = false;
+
+		try
+		{
+			Blake256 dgt256(33, false);
+		}
+		catch (Exception::CryptoDigestException&)
+		{
+			thrown = true;
+		}
+
+		if (!thrown)
+			throw TestException("DigestSizeTest: An invalid digest size was accepted!");
+	}
+
+	void Blake2Test::FileBatchTest()
+	{
+		// small files in the multi-buffer batches, files above the small file size hashed alone, and a missing file in the list
+		const std::vector<size_t> FLESZE = { 0, 1, 127, 128, 129, 1000, 4096, 65536, 65537, 300000, 31, 8191 };
+		std::vector<std::vector<uint8_t>> expect;
+		std::vector<std::vector<uint8_t>> output;
+		std::vector<std::string> names;
+
+		for (size_t i = 0; i < FLESZE.size() * 3; ++i)
+		{
+			std::vector<uint8_t> input(FLESZE[i % FLESZE.size()] + (i / FLESZE.size()));
+
+			for (size_t j = 0; j < input.size(); ++j)
+				input[j] = static_cast<uint8_t>((j * 11) + i);
+
+			names.push_back("FileBatchTest" + std::to_string(i) + ".tmp");
+			std::ofstream outFile(names.back().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (input.size() != 0)
+				outFile.write(reinterpret_cast<const char*>(&input[0]), input.size());
+			outFile.close();
+
+			expect.push_back(input);
+		}
+
+		names.insert(names.begin() + 7, "FileBatchTest.missing");
+		expect.insert(expect.begin() + 7, std::vector<uint8_t>(0));
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			const Digests DGTTYPE = (i == 0) ? Digests::Blake512 : Digests::Blake256;
+			IDigest* dgt = Helper::DigestFromName::GetInstance(DGTTYPE, false);
+			FileBatch batch(DGTTYPE);
+
+			// one reader, then several readers with batches of a few files
+			for (size_t j = 1; j < 5; j += 3)
+			{
+				batch.ReaderCount() = j;
+				batch.BatchSize() = (j == 1) ? 1024 * 1024 : 5000;
+
+				if (batch.Compute(names, output) != names.size() - 1)
+					throw TestException("FileBatchTest: The number of hashed files is incorrect!");
+				if (output.size() != names.size())
+					throw TestException("FileBatchTest: The number of digests is incorrect!");
+
+				for (size_t k = 0; k < names.size(); ++k)
+				{
+					std::vector<uint8_t> hash(0);
+
+					if (k != 7)
+					{
+						hash.resize(dgt->DigestSize());
+						dgt->Compute(expect[k], hash);
+					}
+
+					if (output[k] != hash)
+						throw TestException("FileBatchTest: A batch file hash does not match the message hash!");
+				}
+			}
+
+			delete dgt;
+		}
+
+#if defined(CEX_HAS_POSIXIO)
+		// a directory tree; the files are listed in name order, the files of a subdirectory after its name
+		const std::string DIRNAME = "FileBatchTest.dir";
+		mkdir(DIRNAME.c_str(), 0700);
+		mkdir((DIRNAME + "/b").c_str(), 0700);
+		rename(names[0].c_str(), (DIRNAME + "/c").c_str());
+		rename(names[1].c_str(), (DIRNAME + "/a").c_str());
+		rename(names[2].c_str(), (DIRNAME + "/b/d").c_str());
+
+		std::vector<std::string> dirNames;
+		FileBatch batch(Digests::Blake512);
+
+		if (batch.ComputeDirectory(DIRNAME, dirNames, output) != 3 || dirNames.size() != 3)
+			throw TestException("FileBatchTest: The directory file count is incorrect!");
+		if (dirNames[0] != DIRNAME + "/a" || dirNames[1] != DIRNAME + "/b/d" || dirNames[2] != DIRNAME + "/c")
+			throw TestException("FileBatchTest: The directory files are not in name order!");
+
+		// a, b/d and c were the second, third and first files
+		const std::vector<size_t> DIRORDER = { 1, 2, 0 };
+		Blake512 dgt;
+		std::vector<uint8_t> hash(dgt.DigestSize());
+
+		for (size_t i = 0; i < DIRORDER.size(); ++i)
+		{
+			dgt.Compute(expect[DIRORDER[i]], hash);
+
+			if (output[i] != hash)
+				throw TestException("FileBatchTest: The directory file hash does not match the message hash!");
+		}
+
+		dirNames.clear();
+		FileBatch::ListFiles(DIRNAME, dirNames, false);
+
+		if (dirNames.size() != 2)
+			throw TestException("FileBatchTest: The non-recursive directory listing is incorrect!");
+
+		std::remove((DIRNAME + "/a").c_str());
+		std::remove((DIRNAME + "/b/d").c_str());
+		std::remove((DIRNAME + "/c").c_str());
+		rmdir((DIRNAME + "/b").c_str());
+		rmdir(DIRNAME.c_str());
+#endif
+
+		for (size_t i = 0; i < names.size(); ++i)
+			std::remove(names[i].c_str());
+
+		// a missing directory is reported
+		bool thrown = false;
+
+		try
+		{
+			std::vector<std::string> dirNames;
+			FileBatch::ListFiles("FileBatchTest.missing", dirNames);
+		}
+		catch (Exception::CryptoProcessingException&)
+		{
+			thrown = true;
+		}
+
+#if defined(CEX_OS_WINDOWS) || defined(CEX_HAS_POSIXIO)
+		if (!thrown)
+			throw TestException("FileBatchTest: A missing directory was listed!");
+#endif
+	}
+
+	void Blake2Test::FileDigestTest()
+	{
+		// sizes around the block and buffer boundaries, and larger than the parallel block size
+		const std::vector<size_t> FLESZE = { 0, 1, 127, 128, 129, 4096, 1048576 + 17, 4194304 + 333 };
+		const std::string FLENAME = "FileDigestTest.tmp";
+		std::vector<uint8_t> expect;
+		std::vector<uint8_t> input;
+		std::vector<uint8_t> output;
+
+		for (size_t i = 0; i < FLESZE.size(); ++i)
+		{
+			input.resize(FLESZE[i]);
+
+			for (size_t j = 0; j < input.size(); ++j)
+				input[j] = static_cast<uint8_t>((j * 7) + (j >> 8));
+
+			std::ofstream outFile(FLENAME.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (input.size() != 0)
+				outFile.write(reinterpret_cast<const char*>(&input[0]), input.size());
+			outFile.close();
+
+			for (size_t j = 0; j < 4; ++j)
+			{
+				const Digests DGTTYPE = (j < 2) ? Digests::Blake512 : Digests::Blake256;
+				const bool PRLMODE = (j % 2) != 0;
+				IDigest* dgt = Helper::DigestFromName::GetInstance(DGTTYPE, PRLMODE);
+				expect.resize(dgt->DigestSize());
+				dgt->Compute(input, expect);
+				delete dgt;
+
+				FileDigest fdg(DGTTYPE, PRLMODE);
+
+				if (fdg.Compute(FLENAME, output) != input.size())
+					throw TestException("FileDigestTest: The mapped file length is incorrect!");
+				if (output != expect)
+					throw TestException("FileDigestTest: The mapped file hash does not match the message hash!");
+
+				fdg.ReadMode() = FileDigest::ReadModes::Buffered;
+
+				if (fdg.Compute(FLENAME, output) != input.size())
+					throw TestException("FileDigestTest: The buffered file length is incorrect!");
+				if (output != expect)
+					throw TestException("FileDigestTest: The buffered file hash does not match the message hash!");
+	
+				fdg.ReadMode() = FileDigest::ReadModes::Pipelined;
+
+				if (fdg.Compute(FLENAME, output) != input.size())
+					throw TestException("FileDigestTest: The pipelined file length is incorrect!");
+				if (output != expect)
+					throw TestException("FileDigestTest: The pipelined file hash does not match the message hash!");
+
+				// small odd sized buffers, so that the ring wraps many times
+				fdg.BufferSize() = 1000;
+				fdg.QueueDepth() = 2;
+
+				if (fdg.Compute(FLENAME, output) != input.size() || output != expect)
+					throw TestException("FileDigestTest: The small buffer pipelined file hash does not match the message hash!");
+
+				// reads around the page cache; direct where the file system supports it, the buffer is rounded to the block size
+				fdg.BypassCache() = true;
+
+				if (fdg.Compute(FLENAME, output) != input.size() || output != expect)
+					throw TestException("FileDigestTest: The uncached pipelined file hash does not match the message hash!");
+
+				fdg.ReadMode() = FileDigest::ReadModes::Buffered;
+				fdg.BufferSize() = 65536;
+
+				if (fdg.Compute(FLENAME, output) != input.size() || output != expect)
+					throw TestException("FileDigestTest: The uncached buffered file hash does not match the message hash!");
+			}
+
+			// ranged reads; the readers hash their parts of the file as subtrees, and the digest is the tree hash of the message
+			for (size_t j = 0; j < 2; ++j)
+			{
+				// the Blake2s leaves are not block aligned, and are read through the cache when uncached
+				BlakeParams params = (j == 0) ? BlakeParams(64, 255, 4, 0, 64) : BlakeParams(32, 4, 3, 0, 32);
+				params.LeafLength() = (j == 0) ? 4096 : 1152;
+				BlakeTree tree((j == 0) ? Digests::Blake512 : Digests::Blake256, params);
+				expect.resize(tree.DigestSize());
+				tree.Compute(input, expect);
+
+				FileDigest fdg(&tree);
+				fdg.ReadMode() = FileDigest::ReadModes::Ranged;
+
+				for (size_t k = 1; k < 8; k += 3)
+				{
+					fdg.ReaderCount() = k;
+
+					if (fdg.Compute(FLENAME, output) != input.size() || output != expect)
+						throw TestException("FileDigestTest: The ranged file hash does not match the tree hash!");
+				}
+
+				fdg.BypassCache() = true;
+				fdg.BufferSize() = 10000;
+
+				if (fdg.Compute(FLENAME, output) != input.size() || output != expect)
+					throw TestException("FileDigestTest: The uncached ranged file hash does not match the tree hash!");
+			}
+		}
+
+		// a digest passed by pointer is hashed from its current state; a keyed digest returns a keyed code
+		std::vector<uint8_t> key(64);
+		for (size_t i = 0; i < key.size(); ++i)
+			key[i] = static_cast<uint8_t>(i);
+
+		Key::Symmetric::SymmetricKey mkey(key);
+		Blake512 dgt;
+		dgt.Initialize(mkey);
+		expect.resize(dgt.DigestSize());
+		dgt.Compute(input, expect);
+		FileDigest fdg(&dgt);
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			// the key is cleared by Finalize, and is set for each file
+			dgt.Initialize(mkey);
+			fdg.Compute(FLENAME, output);
+
+			if (output != expect)
+				throw TestException("FileDigestTest: The keyed file hash does not match the keyed message hash!");
+		}
+
+		std::remove(FLENAME.c_str());
+
+#if defined(CEX_HAS_POSIXIO)
+		// a character device is read through the buffer; the empty message
+		Blake256 dgt256;
+		input.clear();
+		expect.resize(dgt256.DigestSize());
+		dgt256.Compute(input, expect);
+		FileDigest fdg256(Digests::Blake256);
+
+		if (fdg256.Compute("/dev/null", output) != 0 || output != expect)
+			throw TestException("FileDigestTest: The device hash does not match the empty message hash!");
+#endif
+
+		// a queue that can not overlap a read with hashing is rejected
+		bool thrown = false;
+		fdg.ReadMode() = FileDigest::ReadModes::Pipelined;
+		fdg.QueueDepth() = 1;
+
+		try
+		{
+			fdg.Compute(FLENAME, output);
+		}
+		catch (Exception::CryptoProcessingException&)
+		{
+			thrown = true;
+		}
+
+		if (!thrown)
+			throw TestException("FileDigestTest: A queue depth of one was accepted!");
+
+		// the ranged mode hashes the subtrees of a BlakeTree
+		thrown = false;
+		fdg.ReadMode() = FileDigest::ReadModes::Ranged;
+
+		try
+		{
+			fdg.Compute(FLENAME, output);
+		}
+		catch (Exception::CryptoProcessingException&)
+		{
+			thrown = true;
+		}
+
+		if (!thrown)
+			throw TestException("FileDigestTest: The ranged mode was accepted without a tree digest!");
+
+		// a missing file is reported
+		thrown = false;
+		fdg.ReadMode() = FileDigest::ReadModes::Pipelined;
+		fdg.QueueDepth() = 2;
+
+		try
+		{
+			fdg.Compute(FLENAME, output);
+		}
+		catch (Exception::CryptoProcessingException&)
+		{
+			thrown = true;
+		}
+
+		if (!thrown)
+			throw TestException("FileDigestTest: A missing file was hashed!");
+	}
+
+	void Blake2Test::HMACTest()
+	{
+		// the cached pad states must match H((K' ^ opad) || H((K' ^ ipad) || m)) computed with a plain digest
+		const Digests DGTTYPE[] = { Digests::Blake512, Digests::Blake512, Digests::Blake512, Digests::Blake256, Digests::Blake256, Digests::Blake256 };
+		const size_t KEYLEN[] = { 64, 128, 200, 32, 64, 100 };
+		Provider::CSP rng;
+
+		for (size_t i = 0; i < sizeof(KEYLEN) / sizeof(size_t); ++i)
+		{
+			std::vector<uint8_t> key(KEYLEN[i]);
+			rng.GetBytes(key);
+			Key::Symmetric::SymmetricKey mkey(key);
+			HMAC mac(DGTTYPE[i], false);
+			IDigest* dgt = Helper::DigestFromName::GetInstance(DGTTYPE[i], false);
+			const size_t BLKLEN = dgt->BlockSize();
+			std::vector<uint8_t> ipad(BLKLEN, 0);
+			std::vector<uint8_t> opad(BLKLEN, 0);
+			std::vector<uint8_t> inner(dgt->DigestSize());
+			std::vector<uint8_t> expect(dgt->DigestSize());
+			std::vector<uint8_t> code(dgt->DigestSize());
+			std::vector<uint8_t> pkey(key);
+
+			// a key longer than the block is replaced by its hash
+			if (KEYLEN[i] > BLKLEN)
+			{
+				pkey.resize(dgt->DigestSize());
+				dgt->Compute(key, pkey);
+			}
+
+			for (size_t j = 0; j < pkey.size(); ++j)
+			{
+				ipad[j] = pkey[j];
+				opad[j] = pkey[j];
+			}
+
+			for (size_t j = 0; j < BLKLEN; ++j)
+			{
+				ipad[j] ^= 0x36;
+				opad[j] ^= 0x5C;
+			}
+
+			mac.Initialize(mkey);
+
+			for (size_t j = 0; j < 300; j += (j < 140) ? 1 : 7)
+			{
+				std::vector<uint8_t> input(j);
+				if (j != 0)
+					rng.GetBytes(input);
+
+				dgt->Update(ipad, 0, ipad.size());
+				dgt->Update(input, 0, input.size());
+				dgt->Finalize(inner, 0);
+				dgt->Update(opad, 0, opad.size());
+				dgt->Update(inner, 0, inner.size());
+				dgt->Finalize(expect, 0);
+
+				// the mac is reused without a new Initialize; the input pad state is restored by Finalize
+				mac.Update(input, 0, input.size());
+				mac.Finalize(code, 0);
+
+				if (code != expect)
+					throw TestException("HMACTest: Cached pad state code does not match the reference HMAC!");
+			}
+
+			delete dgt;
+		}
+
+		// a parallel digest is not cached; the pads are compressed per message, and Initialize with a new key replaces the old pads
+		std::vector<uint8_t> key(64, 1);
+		std::vector<uint8_t> input(1000, 2);
+		std::vector<uint8_t> code1(64);
+		std::vector<uint8_t> code2(64);
+		Key::Symmetric::SymmetricKey mkey1(key);
+		key[0] = 2;
+		Key::Symmetric::SymmetricKey mkey2(key);
+		HMAC mac(Digests::Blake512, true);
+
+		mac.Initialize(mkey1);
+		mac.Compute(input, code1);
+		mac.Compute(input, code2);
+
+		if (code1 != code2)
+			throw TestException("HMACTest: Parallel mac reuse does not match the first code!");
+
+		mac.Initialize(mkey2);
+		mac.Compute(input, code2);
+
+		if (code1 == code2)
+			throw TestException("HMACTest: A new key did not replace the pad states!");
+
+		// a degree set after Initialize may change the digest mode; the pads are reloaded, and match a degree set before Initialize
+		HMAC seq(Digests::Blake512, false);
+		HMAC ref(Digests::Blake512, false);
+
+		seq.Initialize(mkey1);
+		seq.ParallelMaxDegree(4);
+		seq.Compute(input, code1);
+		ref.ParallelMaxDegree(4);
+		ref.Initialize(mkey1);
+		ref.Compute(input, code2);
+
+		if (code1 != code2)
+			throw TestException("HMACTest: A degree change after Initialize does not match the reference code!");
+	}
+
+	void Blake2Test::KdfTest()
+	{
+		// expected values from keyed Blake2b with the same parameter blocks; extract, then counter mode expansion
+		const std::vector<std::string> EXPECT =
+		{
+			"6B61AF1A1D478894E77AEE7FCCFCF0B5B722866EA591B93EED47896B4A64AA0ABD91CD2ABA6330EF7DE9626F69CB9114304F8A8B5C449833C564E7C94D48FDB7",
+			"7B93B6FCED14EEF705B506148DD6C716447F17066A3755909A7FA189115EF4415B33A3662224BD59EC74A1CBD43618B383E42C3643EAA1673FC1A0960887A3EC6426D0E73DBEB1AEF3DC2D3D6FE3CE01520DEE48D9730F42D0A6437C301905094BAB8AF71B5FF92779A0A00C676835BC4927AA4C78507B057299C8D8B0C4E2EDF0E7950ABC24BA7DE5940BF160BE7AE9F0AF9859C371"
+		};
+		std::vector<uint8_t> context(12);
+		std::vector<uint8_t> expect;
+		std::vector<uint8_t> ikm(32);
+		std::vector<uint8_t> info(16);
+		std::vector<uint8_t> output;
+		std::vector<uint8_t> salt(16);
+
+		for (size_t i = 0; i < ikm.size(); ++i)
+			ikm[i] = static_cast<uint8_t>(i + 1);
+
+		for (size_t i = 0; i < salt.size(); ++i)
+		{
+			salt[i] = static_cast<uint8_t>(0xA0 + i);
+			info[i] = static_cast<uint8_t>(0xC0 + i);
+		}
+
+		for (size_t i = 0; i < context.size(); ++i)
+			context[i] = static_cast<uint8_t>(0xE0 + i);
+
+		// no salt, personalization, or context
+		BlakeKdf kdf1;
+		Key::Symmetric::SymmetricKey kp1(ikm);
+		kdf1.Initialize(kp1);
+		HexConverter::Decode(EXPECT[0], expect);
+		output.resize(expect.size());
+		kdf1.Generate(output);
+
+		if (output != expect)
+			throw TestException("KdfTest: Output does not match the expected value!");
+
+		// salt, personalization, and a context; a multi-block output
+		BlakeKdf kdf2;
+		Key::Symmetric::SymmetricKey kp2(ikm, salt, info);
+		kdf2.Initialize(kp2);
+		HexConverter::Decode(EXPECT[1], expect);
+		output.resize(expect.size() + 10);
+		kdf2.Generate(context, output, 10, expect.size());
+
+		if (std::vector<uint8_t>(output.begin() + 10, output.end()) != expect)
+			throw TestException("KdfTest: Salted output does not match the expected value!");
+
+		// a shorter output is the start of a longer one
+		output.resize(42);
+		kdf2.Generate(context, output, 0, output.size());
+
+		if (std::vector<uint8_t>(expect.begin(), expect.begin() + 42) != output)
+			throw TestException("KdfTest: Truncated output does not match the expected value!");
+
+		// a digest keyed with a salt and personalization, then keyed again without them, matches a digest that never had them
+		std::vector<uint8_t> code1(64);
+		std::vector<uint8_t> code2(64);
+		Blake512 mac1(false);
+		Blake512 mac2(false);
+		mac1.Initialize(kp2);
+		mac1.Initialize(kp1);
+		mac1.Compute(context, code1);
+		mac2.Initialize(kp1);
+		mac2.Compute(context, code2);
+
+		if (code1 != code2)
+			throw TestException("KdfTest: The salt and personalization of a previous key were kept!");
+
+		// the batched outputs match the single context outputs
+		std::vector<std::vector<uint8_t>> contexts(9);
+		std::vector<std::vector<uint8_t>> batch;
+
+		for (size_t i = 0; i < contexts.size(); ++i)
+			contexts[i].assign(i * 17, static_cast<uint8_t>(i));
+
+		kdf2.GenerateBatch(contexts, batch, 100);
+
+		for (size_t i = 0; i < contexts.size(); ++i)
+		{
+			output.resize(100);
+			kdf2.Generate(contexts[i], output, 0, output.size());
+
+			if (batch[i] != output)
+				throw TestException("KdfTest: Batched output does not match the single context output!");
+		}
+
+		// the generator can not be used after Reset
+		bool thrown = false;
+		kdf2.Reset();
+		try
+		{
+			kdf2.Generate(output);
+		}
+		catch (Exception::CryptoDigestException&)
+		{
+			thrown = true;
+		}
+
+		if (!thrown)
+			throw TestException("KdfTest: A reset generator produced output!");
+	}
+
+	void Blake2Test::KeyedStateTest()
+	{
+		StateCompare<Blake512, Digest::Blake2bKeyedState>(StateModes::Keyed, false, 64);
+		StateCompare<Blake512, Digest::Blake2bKeyedState>(StateModes::Keyed, false, 32);
+		StateCompare<Blake256, Digest::Blake2sKeyedState>(StateModes::Keyed, false, 32);
+		StateCompare<Blake256, Digest::Blake2sKeyedState>(StateModes::Keyed, false, 16);
+	}
+
+	void Blake2Test::MacParamsTest()
+	{
+		std::vector<uint8_t> key(64);
+		for (uint8_t i = 0; i < key.size(); ++i)
+			key[i] = i;
 
 		Key::Symmetric::SymmetricKey mkey(key, key, key);
 		Key::Symmetric::ISymmetricKey* mkey2 = mkey.Clone();
@@ -267,6 +1698,315 @@ namespace Test
 			throw TestException("Blake2STest: Mac parameters test failed!");
 	}
 
+	void Blake2Test::PointerUpdateTest()
+	{
+		// uneven chunks through the pointer overloads must match a single vector update, with the code written at an offset
+		const size_t MSGLEN = 1024 * 1024 + 117;
+		const size_t OUTOFF = 3;
+		Provider::CSP rng;
+		std::vector<uint8_t> input(MSGLEN);
+		rng.GetBytes(input);
+
+		std::vector<IDigest*> dgts;
+		dgts.push_back(new Blake512(false));
+		dgts.push_back(new Blake512(true));
+		dgts.push_back(new Blake256(false));
+		dgts.push_back(new Blake256(true));
+		dgts.push_back(new BlakeTree(Digests::Blake512));
+
+		for (size_t i = 0; i < dgts.size(); ++i)
+		{
+			std::vector<uint8_t> expect(dgts[i]->DigestSize());
+			std::vector<uint8_t> hash(dgts[i]->DigestSize() + OUTOFF);
+			size_t prcLen = 0;
+
+			dgts[i]->Update(input, 0, input.size());
+			dgts[i]->Finalize(expect, 0);
+
+			for (size_t j = 1; prcLen < MSGLEN; ++j)
+			{
+				const size_t CHKLEN = (MSGLEN - prcLen < j * j * 13) ? MSGLEN - prcLen : j * j * 13;
+				dgts[i]->Update(&input[prcLen], CHKLEN);
+				prcLen += CHKLEN;
+			}
+
+			dgts[i]->Finalize(&hash[OUTOFF]);
+			delete dgts[i];
+
+			if (std::vector<uint8_t>(hash.begin() + OUTOFF, hash.end()) != expect)
+				throw TestException("PointerUpdateTest: Pointer digest output does not match vector output!");
+		}
+
+		std::vector<uint8_t> key(64);
+		rng.GetBytes(key);
+		Key::Symmetric::SymmetricKey mkey(key);
+		HMAC mac(Digests::Blake512, false);
+		std::vector<uint8_t> expect(mac.MacSize());
+		std::vector<uint8_t> code(mac.MacSize() + OUTOFF);
+
+		mac.Initialize(mkey);
+		mac.Update(input, 0, input.size());
+		mac.Finalize(expect, 0);
+		mac.Initialize(mkey);
+		mac.Update(&input[0], 1000);
+		mac.Update(&input[1000], MSGLEN - 1000);
+		mac.Finalize(&code[OUTOFF]);
+
+		if (std::vector<uint8_t>(code.begin() + OUTOFF, code.end()) != expect)
+			throw TestException("PointerUpdateTest: Pointer mac output does not match vector output!");
+	}
+
+	void Blake2Test::SchedulerTest()
+	{
+		// job sizes vary from empty to megabytes; parallel digests add their leaf loops to the scheduler
+		const size_t MSGCNT = 48;
+		Provider::CSP rng;
+		std::vector<std::vector<uint8_t>> input(MSGCNT);
+		std::vector<std::vector<uint8_t>> expect(MSGCNT);
+		std::vector<std::vector<uint8_t>> hash(MSGCNT);
+
+		for (size_t i = 0; i < MSGCNT; ++i)
+		{
+			input[i].resize((i * i * i * 23) % (2 * 1024 * 1024));
+			if (input[i].size() != 0)
+				rng.GetBytes(input[i]);
+
+			const bool PRLMODE = (i % 3 == 0);
+			if (i % 2 == 0)
+			{
+				Blake512 dgt(PRLMODE);
+				expect[i].resize(64);
+				dgt.Compute(input[i], expect[i]);
+			}
+			else
+			{
+				Blake256 dgt(PRLMODE);
+				expect[i].resize(32);
+				dgt.Compute(input[i], expect[i]);
+			}
+		}
+
+		TaskScheduler sched;
+
+		for (size_t i = 0; i < MSGCNT; ++i)
+		{
+			sched.Submit([&input, &hash, i]()
+			{
+				const bool PRLMODE = (i % 3 == 0);
+				if (i % 2 == 0)
+				{
+					Blake512 dgt(PRLMODE);
+					hash[i].resize(64);
+					dgt.Compute(input[i], hash[i]);
+				}
+				else
+				{
+					Blake256 dgt(PRLMODE);
+					hash[i].resize(32);
+					dgt.Compute(input[i], hash[i]);
+				}
+			});
+		}
+
+		sched.Run();
+
+		if (hash != expect)
+			throw TestException("SchedulerTest: Scheduled digest output does not match direct output!");
+	}
+
+	void Blake2Test::SerializeTest()
+	{
+		// each split message is checkpointed, and resumed by a new digest of the other mode
+		for (size_t i = 0; i < 2; ++i)
+		{
+			StateCompare<Blake512, Digest::Blake2bKeyedState>(StateModes::Serialize, i != 0, 0);
+			StateCompare<Blake256, Digest::Blake2sKeyedState>(StateModes::Serialize, i != 0, 0);
+		}
+
+		// a keyed digest with a salt and personalization, and a keyed template, are resumed with their key state
+		std::vector<uint8_t> key(64, 5);
+		std::vector<uint8_t> salt(16, 6);
+		std::vector<uint8_t> input(1000, 7);
+		std::vector<uint8_t> expect(64);
+		std::vector<uint8_t> hash(64);
+		Key::Symmetric::SymmetricKey mkey(key, salt, salt);
+		Digest::Blake2bKeyedState kstate;
+		Blake512 mac(false);
+		Blake512 res(true);
+
+		mac.Initialize(mkey);
+		mac.Update(input, 0, input.size());
+		mac.Finalize(expect, 0);
+		mac.Initialize(mkey);
+		mac.Update(input, 0, 500);
+		res.DeSerialize(mac.Serialize());
+		res.Update(input, 500, 500);
+		res.Finalize(hash, 0);
+
+		if (hash != expect)
+			throw TestException("SerializeTest: Resumed mac output does not match the keyed digest!");
+
+		mac.Initialize(mkey);
+		mac.GetKeyedState(kstate);
+		mac.Finalize(expect, 0);
+		mac.LoadKeyedState(kstate);
+		res.DeSerialize(mac.Serialize());
+		res.Finalize(hash, 0);
+
+		if (hash != expect)
+			throw TestException("SerializeTest: Resumed keyed template output does not match the keyed digest!");
+
+		// a state with the wrong version, the wrong digest, or a wrong length is rejected
+		std::vector<uint8_t> state = mac.Serialize();
+		std::vector<std::vector<uint8_t>> bad(4, state);
+		Blake256 dgt256(false);
+		bad[0][0] ^= 0xFF;
+		bad[1].pop_back();
+		bad[2].push_back(0);
+		bad[3] = dgt256.Serialize();
+
+		for (size_t i = 0; i < bad.size(); ++i)
+		{
+			bool thrown = false;
+
+			try
+			{
+				res.DeSerialize(bad[i]);
+			}
+			catch (Exception::CryptoDigestException&)
+			{
+				thrown = true;
+			}
+
+			if (!thrown)
+				throw TestException("SerializeTest: A malformed state was accepted!");
+		}
+	}
+
+	void Blake2Test::TreeHashTest()
+	{
+		// expected values from the reference tree construction: contiguous leaves, last node flag on the last node of every level
+		const std::vector<std::string> EXPECT =
+		{
+			"67722EA14E56EF9F085AD376E686EEFDCC402E627CA0664BA78BA1478CD26791C4E2D04443FDD79E95ACA749F20B24AFA74657B950E30DE4895D47DA250D8EAE",
+			"75542C3E4DCF3483522DC6A72D302B11FD411BF951C1AA7B655358D7B6D04050"
+		};
+		const std::vector<size_t> MSGLEN = { 100000, 30000 };
+		std::vector<uint8_t> expect;
+		std::vector<uint8_t> hash;
+
+		for (size_t i = 0; i < EXPECT.size(); ++i)
+		{
+			// Blake2b: fanout 4, unlimited depth, 1024 byte leaves; Blake2s: fanout 2, depth 3, 128 byte leaves, 16 byte inner hashes
+			BlakeParams params = (i == 0) ? BlakeParams(64, 255, 4, 0, 64) : BlakeParams(32, 3, 2, 0, 16);
+			params.LeafLength() = (i == 0) ? 1024 : 128;
+			BlakeTree dgt((i == 0) ? Enumeration::Digests::Blake512 : Enumeration::Digests::Blake256, params);
+			std::vector<uint8_t> input(MSGLEN[i]);
+
+			for (size_t j = 0; j < input.size(); ++j)
+				input[j] = static_cast<uint8_t>(j);
+
+			HexConverter::Decode(EXPECT[i], expect);
+			hash.resize(dgt.DigestSize());
+
+			// the leaves are hashed in parallel by default on a multi-processor host
+			if (dgt.IsParallel() != (ParallelUtils::ProcessorCount() > 1))
+				throw TestException("TreeHashTest: The default tree profile is not parallel on a multi-processor host!");
+
+			// one thread
+			dgt.ParallelMaxDegree(1);
+			dgt.Compute(input, hash);
+
+			if (hash != expect)
+				throw TestException("TreeHashTest: Tree hash output does not match the expected value!");
+
+			// several threads, with updates that split the leaves
+			dgt.ParallelMaxDegree(4);
+
+			for (size_t j = 0; j < input.size(); j += 997)
+				dgt.Update(input, j, (input.size() - j < 997) ? input.size() - j : 997);
+
+			dgt.Finalize(hash, 0);
+
+			if (hash != expect)
+				throw TestException("TreeHashTest: Parallel tree hash output does not match the expected value!");
+
+			// ranges of leaves hashed independently and out of order, then joined in message order; Finalize hashes the last leaf
+			const size_t LEAFLEN = dgt.LeafLength();
+			const std::vector<size_t> RNGPOS = { 0, 5, 22, (input.size() - 1) / LEAFLEN };
+			std::vector<BlakeTreeRange> ranges;
+
+			for (size_t j = 0; j < RNGPOS.size() - 1; ++j)
+				ranges.push_back(BlakeTreeRange(RNGPOS[j]));
+
+			for (size_t j = ranges.size(); j != 0; --j)
+			{
+				const size_t RNGLEN = RNGPOS[j] - RNGPOS[j - 1];
+
+				// a range is continued across calls
+				dgt.UpdateRange(ranges[j - 1], &input[RNGPOS[j - 1] * LEAFLEN], (RNGLEN / 2) * LEAFLEN);
+				dgt.UpdateRange(ranges[j - 1], &input[(RNGPOS[j - 1] + (RNGLEN / 2)) * LEAFLEN], (RNGLEN - (RNGLEN / 2)) * LEAFLEN);
+			}
+
+			for (size_t j = 0; j < ranges.size(); ++j)
+				dgt.JoinRange(ranges[j]);
+
+			dgt.Update(input, RNGPOS.back() * LEAFLEN, input.size() - (RNGPOS.back() * LEAFLEN));
+			dgt.Finalize(hash, 0);
+
+			if (hash != expect)
+				throw TestException("TreeHashTest: Joined range tree hash output does not match the expected value!");
+
+			// the cached tree; change a few bytes inside one leaf, then a range across several leaves
+			dgt.ComputeCached(input, hash);
+
+			if (hash != expect)
+				throw TestException("TreeHashTest: Cached tree hash output does not match the expected value!");
+
+			for (size_t j = 0; j < 2; ++j)
+			{
+				const size_t MODOFF = (j == 0) ? input.size() / 3 : 1000;
+				const size_t MODLEN = (j == 0) ? 5 : input.size() / 2;
+
+				for (size_t k = MODOFF; k < MODOFF + MODLEN; ++k)
+					input[k] ^= 0xA5;
+
+				dgt.UpdateCached(input, MODOFF, MODLEN, hash);
+				dgt.Compute(input, expect);
+
+				if (hash != expect)
+					throw TestException("TreeHashTest: Updated cached tree hash output does not match the recomputed value!");
+			}
+
+			// a new key discards the cached tree; the rekeyed cache is updated, and compared with a cache built with the new key
+			std::vector<uint8_t> key((i == 0) ? 64 : 32, 7);
+			Key::Symmetric::SymmetricKey mkey(key);
+			bool cacheCleared = false;
+
+			dgt.Initialize(mkey);
+
+			try
+			{
+				dgt.UpdateCached(input, 0, 1, hash);
+			}
+			catch (Exception::CryptoDigestException&)
+			{
+				cacheCleared = true;
+			}
+
+			if (!cacheCleared)
+				throw TestException("TreeHashTest: The cached tree was not discarded by Initialize!");
+
+			dgt.ComputeCached(input, hash);
+			input[input.size() / 2] ^= 0x5A;
+			dgt.UpdateCached(input, input.size() / 2, 1, hash);
+			dgt.ComputeCached(input, expect);
+
+			if (hash != expect)
+				throw TestException("TreeHashTest: Rekeyed cached tree hash output does not match the cached value!");
+		}
+	}
+
 	void Blake2Test::TreeParamsTest()
 	{
 		std::vector<byte> code1(40, 7);
@@ -287,6 +2027,85 @@ namespace Test
 			throw std::string("Blake2STest: Tree parameters test failed!");
 	}
 
+	void Blake2Test::XofTest()
+	{
+		// expected values from the Blake2X reference construction; a 300 byte message, the last of each set keyed, with a salt and personalization
+		const std::vector<std::string> EXPECT =
+		{
+			"B8",
+			"6F198C10DA6B1E35FE8F91C30AA2816A97AB072927EE903B9963B26D62A3CC7DAB4AAFF04939C5E5178E95E9E453B8E3D14B830300AB8459244626BF0341FC45BD29CDC05CFD1B4D8E003D12E9CE5EE5F0E0FBDF4102FE732D26DB5E67F156EA5287C4B88B5AB24B595AE113ED46CAE3F9F7C6BA0C69CA8C52629D62B31DB4F641",
+			"412F0DFB6437270E1C1DD12D9A08745EAE6B64CBC4782A768EB5246F4145BF95489DC450FB8FC2744E545D9989F8856AD59E085279B78524365DCF36D6940E5E31A10A448EE408EFA54E0DFD556B5E0E3CE965E4CC43E97706109EEC268D71F6C0EC67DB64A12B06FC10105839FCBD137A59B8C8AB34E5C0B2F03E9C7D833EFFCEF70CC002917AA628FD4B520B9761B94256B6D134F00032609072A3CE839FC21783ED62C60421FBBED318C30BBAB67800E82E826CB158D46D63710BFA0E2E07A48C7F57242C2DF2",
+			"14",
+			"F1541611C03EDD714AE2FDB109619503F91435884E36BB828827657C6F75C4F193B8837E6C285ECA430B79B43223DE10071A0C6E6A21D93F5432702D8FC7A5DF32",
+			"B2559C51EAA60E63099564751CA96186421A77DF284741F366E0D60BB0BBDE5A47714BCB002D769B5F2BE5B05F24D10C1FA1BC834491E92CCCE968BDBC3E1C39C1578A8CEB97BA47483FE3662BDA51D2C2ABE88617CB635F065A9AE54E76ECA1B3232A5D"
+		};
+		std::vector<uint8_t> expect;
+		std::vector<uint8_t> input(300);
+		std::vector<uint8_t> output;
+
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = static_cast<uint8_t>(i);
+
+		for (size_t i = 0; i < EXPECT.size(); ++i)
+		{
+			const Enumeration::Digests DGTTYPE = (i < 3) ? Enumeration::Digests::Blake512 : Enumeration::Digests::Blake256;
+			const size_t DGTLEN = (i < 3) ? 64 : 32;
+
+			HexConverter::Decode(EXPECT[i], expect);
+			BlakeXof xof(DGTTYPE, static_cast<uint>(expect.size()));
+
+			if (i % 3 == 2)
+			{
+				std::vector<uint8_t> key(DGTLEN);
+				std::vector<uint8_t> salt(DGTLEN / 4);
+				std::vector<uint8_t> info(DGTLEN / 4);
+
+				for (size_t j = 0; j < key.size(); ++j)
+					key[j] = static_cast<uint8_t>(j + 1);
+
+				for (size_t j = 0; j < salt.size(); ++j)
+				{
+					salt[j] = static_cast<uint8_t>(0xA0 + j);
+					info[j] = static_cast<uint8_t>(0xC0 + j);
+				}
+
+				Key::Symmetric::SymmetricKey mkey(key, salt, info);
+				xof.Initialize(mkey);
+			}
+
+			output.clear();
+			xof.Compute(input, output);
+
+			if (output != expect)
+				throw TestException("XofTest: Blake2X output does not match the expected value!");
+
+			// the key is retained after finalizing; compute again with byte-sized updates
+			for (size_t j = 0; j < input.size(); ++j)
+				xof.Update(input[j]);
+
+			xof.Finalize(output, 0);
+
+			if (output != expect)
+				throw TestException("XofTest: Blake2X incremental output does not match the expected value!");
+		}
+
+		// large outputs generated on several threads match the single thread output
+		for (size_t i = 0; i < 2; ++i)
+		{
+			const Enumeration::Digests DGTTYPE = (i == 0) ? Enumeration::Digests::Blake512 : Enumeration::Digests::Blake256;
+			const uint OUTLEN = (i == 0) ? 1000000 : 65534;
+			BlakeXof xof1(DGTTYPE, OUTLEN, false);
+			BlakeXof xof2(DGTTYPE, OUTLEN, true);
+
+			xof1.Compute(input, expect);
+			xof2.ParallelMaxDegree(4);
+			xof2.Compute(input, output);
+
+			if (output != expect)
+				throw TestException("XofTest: Parallel Blake2X output does not match the sequential output!");
+		}
+	}
+
 	void Blake2Test::OnProgress(std::string Data)
 	{
 		m_progressEvent(Data);
@@ -52,12 +52,29 @@ namespace Test
 
 	private:
 
+		void AllocationTest();
 		void Blake2BTest();
+		void Blake2BBatchTest();
 		void Blake2BPTest();
+		void Blake2BPSimdTest();
 		void Blake2STest();
+		void Blake2SBatchTest();
 		void Blake2SPTest();
+		void Blake2SPSimdTest();
+		void CloneTest();
+		void DigestSizeTest();
+		void FileBatchTest();
+		void FileDigestTest();
+		void HMACTest();
+		void KdfTest();
+		void KeyedStateTest();
 		void MacParamsTest();
+		void PointerUpdateTest();
+		void SchedulerTest();
+		void SerializeTest();
+		void TreeHashTest();
 		void TreeParamsTest();
+		void XofTest();
 		void OnProgress(std::string Data);
 	};
 }
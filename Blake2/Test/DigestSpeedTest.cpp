@@ -1,7 +1,22 @@
 #include "DigestSpeedTest.h"
 #include "../Blake2/IDigest.h"
+#include "../Blake2/Blake256.h"
+#include "../Blake2/Blake512.h"
+#include "../Blake2/BlakeTree.h"
 #include "../Blake2/DigestFromName.h"
+#include "../Blake2/FileBatch.h"
+#include "../Blake2/FileDigest.h"
+#include "../Blake2/HMAC.h"
 #include "../Blake2/IntUtils.h"
+#include "../Blake2/ParallelUtils.h"
+#include "../Blake2/SymmetricKey.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#if defined(_OPENMP)
+#	include <omp.h>
+#endif
 
 namespace Test
 {
@@ -58,6 +73,140 @@ namespace Test
 		OnProgress(std::string(""));
 	}
 
+	void DigestSpeedTest::DigestConstruction(Enumeration::Digests DigestType, size_t Loops, bool Parallel)
+	{
+		// a new digest for every one block message; the time measured is dominated by construction and state setup
+		Digest::IDigest* dgt = Helper::DigestFromName::GetInstance(DigestType, Parallel);
+		std::string name = dgt->Name() + (Parallel ? " parallel" : "");
+		std::vector<byte> hash(dgt->DigestSize(), 0);
+		std::vector<byte> block(dgt->BlockSize(), 0);
+		delete dgt;
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+		{
+			dgt = Helper::DigestFromName::GetInstance(DigestType, Parallel);
+			dgt->Compute(block, hash);
+			delete dgt;
+		}
+		double nsec = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+		OnProgress(std::string(name + ", construct and hash one block: " + Utility::IntUtils::ToString(nsec) + " nanoseconds per digest"));
+
+		// the same messages on one instance; the per block cost of the compression state
+		dgt = Helper::DigestFromName::GetInstance(DigestType, Parallel);
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+			dgt->Compute(block, hash);
+		nsec = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+		delete dgt;
+		OnProgress(std::string(name + ", reuse and hash one block: " + Utility::IntUtils::ToString(nsec) + " nanoseconds per digest"));
+		OnProgress(std::string(""));
+	}
+
+	void DigestSpeedTest::FileBatchLoop(Enumeration::Digests DigestType, size_t FileCount, size_t FileSize)
+	{
+		std::vector<byte> buffer(FileSize, 0);
+		std::vector<std::string> names;
+
+		for (size_t i = 0; i < FileCount; ++i)
+		{
+			names.push_back("DigestSpeedTest" + Utility::IntUtils::ToString(i) + ".tmp");
+			std::ofstream outFile(names.back().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			outFile.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
+			outFile.close();
+		}
+
+		// one file at a time; an open, read and close, and a digest cycle per file
+		IO::FileDigest fdg(DigestType);
+		std::vector<byte> hash;
+		uint64_t start = TestUtils::GetTimeMs64();
+
+		for (size_t i = 0; i < FileCount; ++i)
+			fdg.Compute(names[i], hash);
+
+		uint64_t dur = TestUtils::GetTimeMs64() - start;
+		std::string fps = Utility::IntUtils::ToString(dur != 0 ? (FileCount * 1000) / dur : FileCount * 1000);
+		std::string name = fdg.Digest()->Name() + ", " + Utility::IntUtils::ToString(FileSize) + " byte files";
+		OnProgress(std::string(name + ", one at a time: " + fps + " files per Second"));
+
+		// concurrent readers, and the small files hashed together in the multi-buffer lanes
+		IO::FileBatch batch(DigestType);
+		std::vector<std::vector<byte>> hashes;
+		start = TestUtils::GetTimeMs64();
+		batch.Compute(names, hashes);
+		dur = TestUtils::GetTimeMs64() - start;
+		fps = Utility::IntUtils::ToString(dur != 0 ? (FileCount * 1000) / dur : FileCount * 1000);
+		OnProgress(std::string(name + ", batched by " + Utility::IntUtils::ToString(batch.ReaderCount()) + " readers: " + fps + " files per Second"));
+
+		for (size_t i = 0; i < FileCount; ++i)
+			std::remove(names[i].c_str());
+
+		OnProgress(std::string(""));
+	}
+
+	void DigestSpeedTest::FileHashLoop(Enumeration::Digests DigestType, size_t FileSize, size_t Loops, bool Parallel)
+	{
+		// the file is cached after it is written; the time measured is the copy and hash cost, not the disk
+		const std::string FLENAME = "DigestSpeedTest.tmp";
+		std::vector<byte> buffer(MB1, 0);
+		std::vector<byte> hash;
+		std::ofstream outFile(FLENAME.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		for (size_t i = 0; i < FileSize; i += buffer.size())
+			outFile.write(reinterpret_cast<const char*>(&buffer[0]), (FileSize - i < buffer.size()) ? FileSize - i : buffer.size());
+		outFile.close();
+
+		IO::FileDigest fdg(DigestType, Parallel);
+		std::string name = fdg.Digest()->Name() + (Parallel ? " parallel" : "");
+
+		const std::vector<IO::FileDigest::ReadModes> MODES = { IO::FileDigest::ReadModes::Buffered, IO::FileDigest::ReadModes::Pipelined, IO::FileDigest::ReadModes::Mapped };
+		const std::vector<std::string> MODENAME = { ", buffered reads: ", ", pipelined reads: ", ", mapped file: " };
+
+		for (size_t i = 0; i < MODES.size(); ++i)
+		{
+			fdg.ReadMode() = MODES[i];
+			uint64_t start = TestUtils::GetTimeMs64();
+
+			for (size_t j = 0; j < Loops; ++j)
+				fdg.Compute(FLENAME, hash);
+
+			uint64_t dur = TestUtils::GetTimeMs64() - start;
+			std::string mbps = Utility::IntUtils::ToString(GetBytesPerSecond(dur, Loops * FileSize) / MB1);
+			OnProgress(std::string(name + MODENAME[i] + mbps + " MB per Second"));
+		}
+
+		// direct reads from the device; the rate is bounded by the storage rather than the digest
+		fdg.ReadMode() = IO::FileDigest::ReadModes::Pipelined;
+		fdg.BypassCache() = true;
+		uint64_t start = TestUtils::GetTimeMs64();
+
+		for (size_t j = 0; j < Loops; ++j)
+			fdg.Compute(FLENAME, hash);
+
+		uint64_t dur = TestUtils::GetTimeMs64() - start;
+		std::string mbps = Utility::IntUtils::ToString(GetBytesPerSecond(dur, Loops * FileSize) / MB1);
+		OnProgress(std::string(name + ", pipelined uncached reads: " + mbps + " MB per Second"));
+
+		if (Parallel)
+		{
+			// the tree hash of the file; each reader thread reads and hashes its own part of the file
+			Digest::BlakeTree tree(DigestType);
+			IO::FileDigest fdgTree(&tree);
+			fdgTree.ReadMode() = IO::FileDigest::ReadModes::Ranged;
+			start = TestUtils::GetTimeMs64();
+
+			for (size_t j = 0; j < Loops; ++j)
+				fdgTree.Compute(FLENAME, hash);
+
+			dur = TestUtils::GetTimeMs64() - start;
+			mbps = Utility::IntUtils::ToString(GetBytesPerSecond(dur, Loops * FileSize) / MB1);
+			OnProgress(std::string(tree.Name() + ", ranged reads by " + Utility::IntUtils::ToString(fdgTree.ReaderCount()) + " threads: " + mbps + " MB per Second"));
+		}
+
+		std::remove(FLENAME.c_str());
+		OnProgress(std::string(""));
+	}
+
 	uint64_t DigestSpeedTest::GetBytesPerSecond(uint64_t DurationTicks, uint64_t DataSize)
 	{
 		double sec = (double)DurationTicks / 1000.0;
@@ -66,8 +215,124 @@ namespace Test
 		return (uint64_t)(sze / sec);
 	}
 
+	template <class Digest, class KeyedState>
+	static void KeyedMacTime(size_t KeySize, size_t MessageSize, size_t Loops, double &InitNsec, double &TemplateNsec)
+	{
+		Digest dgt(false);
+		Key::Symmetric::SymmetricKey mkey(std::vector<byte>(KeySize, 1));
+		std::vector<byte> code(dgt.DigestSize(), 0);
+		std::vector<byte> msg(MessageSize, 0);
+		KeyedState kstate;
+
+		// the key block is compressed again for every message
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+		{
+			dgt.Initialize(mkey);
+			dgt.Update(msg, 0, msg.size());
+			dgt.Finalize(code, 0);
+		}
+		InitNsec = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+
+		// the key block is compressed once, into the template
+		dgt.Initialize(mkey);
+		dgt.GetKeyedState(kstate);
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+		{
+			dgt.LoadKeyedState(kstate);
+			dgt.Update(msg, 0, msg.size());
+			dgt.Finalize(code, 0);
+		}
+		TemplateNsec = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+	}
+
+	void DigestSpeedTest::KeyedMacLoop(Enumeration::Digests DigestType, size_t MessageSize, size_t Loops)
+	{
+		double initNsec = 0;
+		double tmplNsec = 0;
+		std::string name;
+
+		if (DigestType == Enumeration::Digests::Blake512)
+		{
+			KeyedMacTime<Digest::Blake512, Digest::Blake2bKeyedState>(64, MessageSize, Loops, initNsec, tmplNsec);
+			name = "Blake512";
+		}
+		else
+		{
+			KeyedMacTime<Digest::Blake256, Digest::Blake2sKeyedState>(32, MessageSize, Loops, initNsec, tmplNsec);
+			name = "Blake256";
+		}
+
+		// the HMAC restores its cached pad states for each message
+		Mac::HMAC mac(DigestType, false);
+		Key::Symmetric::SymmetricKey mkey(std::vector<byte>(mac.MacSize(), 1));
+		std::vector<byte> code(mac.MacSize(), 0);
+		std::vector<byte> msg(MessageSize, 0);
+
+		mac.Initialize(mkey);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+		{
+			mac.Update(msg, 0, msg.size());
+			mac.Finalize(code, 0);
+		}
+		double hmacNsec = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+
+		std::string size = Utility::IntUtils::ToString(MessageSize);
+		OnProgress(std::string(name + " mac, " + size + " byte message, Initialize per message: " + Utility::IntUtils::ToString(initNsec) + " nanoseconds per code"));
+		OnProgress(std::string(name + " mac, " + size + " byte message, keyed template: " + Utility::IntUtils::ToString(tmplNsec) + " nanoseconds per code"));
+		OnProgress(std::string(name + " hmac, " + size + " byte message, cached pads: " + Utility::IntUtils::ToString(hmacNsec) + " nanoseconds per code"));
+		OnProgress(std::string(""));
+	}
+
 	void DigestSpeedTest::OnProgress(std::string Data)
 	{
 		m_progressEvent(Data);
 	}
+
+	void DigestSpeedTest::ParallelForLatency(size_t Width, size_t Loops)
+	{
+		// an almost empty task; the time measured is the cost of starting and joining the loop
+		std::atomic<size_t> counter(0);
+		std::function<void(size_t)> task = [&counter](size_t i) { counter.fetch_add(i + 1); };
+		std::string width = Utility::IntUtils::ToString(Width);
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+			Utility::ParallelUtils::ParallelFor(0, Width, task);
+		double usec = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+		OnProgress(std::string("Thread pool, " + width + " tasks: " + Utility::IntUtils::ToString(usec) + " microseconds per call"));
+
+		// the previous dispatch; a future per index on every call
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+		{
+			std::vector<std::future<void>> futures;
+
+			for (size_t j = 0; j < Width; ++j)
+				futures.push_back(std::async(std::launch::async, [&task, j]() { task(j); }));
+
+			for (size_t j = 0; j < futures.size(); ++j)
+				futures[j].wait();
+		}
+		usec = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+		OnProgress(std::string("std::async, " + width + " tasks: " + Utility::IntUtils::ToString(usec) + " microseconds per call"));
+
+#if defined(_OPENMP)
+		// the previous OpenMP dispatch; a parallel region per call
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < Loops; ++i)
+		{
+#pragma omp parallel num_threads((int)Width)
+			{
+				task((size_t)omp_get_thread_num());
+			}
+		}
+		usec = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / Loops;
+		OnProgress(std::string("OpenMP region, " + width + " tasks: " + Utility::IntUtils::ToString(usec) + " microseconds per call"));
+#endif
+
+		OnProgress(std::string(""));
+	}
 }
\ No newline at end of file
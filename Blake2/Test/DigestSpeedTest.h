@@ -57,6 +57,31 @@ namespace Test
 			{
 				using Enumeration::Digests;
 
+				OnProgress(std::string("### ParallelFor Dispatch Latency: 10000 calls ###"));
+				ParallelForLatency(4, 10000);
+				ParallelForLatency(8, 10000);
+
+				OnProgress(std::string("### Digest Construction and Single Block Cost: 100000 digests ###"));
+				DigestConstruction(Digests::Blake256, 100000);
+				DigestConstruction(Digests::Blake256, 100000, true);
+				DigestConstruction(Digests::Blake512, 100000);
+				DigestConstruction(Digests::Blake512, 100000, true);
+
+				OnProgress(std::string("### Short Message Keyed Mac Cost: 1000000 messages ###"));
+				KeyedMacLoop(Digests::Blake256, 16, 1000000);
+				KeyedMacLoop(Digests::Blake256, 64, 1000000);
+				KeyedMacLoop(Digests::Blake512, 16, 1000000);
+				KeyedMacLoop(Digests::Blake512, 64, 1000000);
+
+				OnProgress(std::string("### File Hashing, Buffered, Pipelined, Memory Mapped, Uncached and Ranged Reads: 10 loops * 100MB file ###"));
+				FileHashLoop(Digests::Blake512, MB100, 10);
+				FileHashLoop(Digests::Blake512, MB100, 10, true);
+
+				OnProgress(std::string("### Many Small Files, One at a Time and Batched: 4000 files ###"));
+				FileBatchLoop(Digests::Blake256, 4000, 4096);
+				FileBatchLoop(Digests::Blake512, 4000, 4096);
+				FileBatchLoop(Digests::Blake512, 4000, 512);
+
 				OnProgress(std::string("### Message Digest Speed Tests: 10 loops * 100MB ###"));
 
 				OnProgress(std::string("***The sequential Blake 256 digest***"));
@@ -118,8 +143,13 @@ namespace Test
 
 	private:
 		void DigestBlockLoop(Enumeration::Digests DigestType, size_t SampleSize, size_t Loops = DEFITER, bool Parallel = false);
+		void DigestConstruction(Enumeration::Digests DigestType, size_t Loops, bool Parallel = false);
+		void FileBatchLoop(Enumeration::Digests DigestType, size_t FileCount, size_t FileSize);
+		void FileHashLoop(Enumeration::Digests DigestType, size_t FileSize, size_t Loops, bool Parallel = false);
 		uint64_t GetBytesPerSecond(uint64_t DurationTicks, uint64_t DataSize);
+		void KeyedMacLoop(Enumeration::Digests DigestType, size_t MessageSize, size_t Loops);
 		void OnProgress(std::string Data);
+		void ParallelForLatency(size_t Width, size_t Loops);
 	};
 }
 
@@ -12,7 +12,7 @@
 #include "ITest.h"
 #include "TestFiles.h"
 #include "TestUtils.h"
-#include "../Blake2/CpuDetect.h"
+#include "../Blake2/BlakeDispatch.h"
 
 using namespace Test;
 
@@ -132,30 +132,8 @@ int main()
 		return 0;
 	}
 
-	CEX::Common::CpuDetect detect;
-
-	if (detect.AVX2())
-	{
-#if !defined(__AVX2__)
-		PrintHeader("Warning! AVX2 support was detected! Set the enhanced instruction set to arch:AVX2 for best performance.");
-#else
-		PrintHeader("AVX2 intrinsics support has been enabled.");
-#endif
-	}
-	else if (detect.AVX())
-	{
-#if defined(__AVX2__)
-		PrintHeader("AVX2 is not supported on this system! AVX intrinsics support is available, set enable enhanced instruction set to arch:AVX");
-#elif !defined(__AVX__)
-		PrintHeader("AVX intrinsics support has been detected, set enhanced instruction set to arch:AVX for best performance.");
-#else
-		PrintHeader("AVX intrinsics support has been enabled.");
-#endif
-	}
-	else
-	{
-		PrintHeader("The minimum SIMD intrinsics support (AVX) was not detected, intrinsics have been disabled!");
-	}
+	// the compression kernels are selected at runtime; no enhanced instruction set option is required
+	PrintHeader(std::string("Blake2 compression kernels selected for this processor: ") + CEX::Digest::BlakeDispatch::Get().Name);
 	PrintHeader("", "");
 
 	try